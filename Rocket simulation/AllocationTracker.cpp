@@ -0,0 +1,68 @@
+#include "AllocationTracker.h"
+#include "imgui.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Per thread, so the dashboard's check sees only what the UI thread does and
+// not the servers and campaign workers allocating beside it. Constant
+// initialized, so operator new may touch it on any thread at any time.
+thread_local uint64_t allocationCount = 0;
+}
+
+#if ROCKET_TRACK_ALLOCATIONS
+// The array and nothrow forms of new forward to this one. Over-aligned new is
+// left alone; it is only used for the one-off per-thread counter blocks.
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+namespace AllocationTracker {
+
+uint64_t count() {
+    return allocationCount;
+}
+
+void noteAllocation() {
+    allocationCount++;
+}
+
+bool enabled() {
+    return ROCKET_TRACK_ALLOCATIONS != 0;
+}
+
+}
+
+void FrameAllocationCheck::beginFrame() {
+    frameStart = AllocationTracker::count();
+}
+
+void FrameAllocationCheck::endFrame() {
+    frameAllocations = AllocationTracker::count() - frameStart;
+    if (!AllocationTracker::enabled()) {
+        return;
+    }
+
+    if (warmupFrames < WARMUP_FRAMES) {
+        warmupFrames++;
+        return;
+    }
+    IM_ASSERT(frameAllocations == 0 && "Dashboard frame allocated on the heap after warm-up");
+}
+
+void FrameAllocationCheck::restartWarmup() {
+    warmupFrames = 0;
+}
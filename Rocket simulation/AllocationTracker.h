@@ -0,0 +1,51 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation counting for the "no allocations in a steady frame" check.
+// On by default in Debug builds; it replaces the global operator new/delete,
+// so it is compiled out of Release entirely.
+#ifndef ROCKET_TRACK_ALLOCATIONS
+#ifdef NDEBUG
+#define ROCKET_TRACK_ALLOCATIONS 0
+#else
+#define ROCKET_TRACK_ALLOCATIONS 1
+#endif
+#endif
+
+namespace AllocationTracker {
+
+// Allocations the calling thread has made so far through operator new and ImGui
+uint64_t count();
+
+// Adds allocations made outside operator new (arena chunks, oversized ImGui
+// blocks), to the calling thread
+void noteAllocation();
+
+bool enabled();
+
+}
+
+// Asserts that a dashboard frame makes no heap allocations on the UI thread
+// once WARMUP_FRAMES frames have passed since the last restart. Anything that
+// legitimately changes the layout or starts something new (a flight phase, a
+// resize, a server or campaign starting) calls restartWarmup().
+class FrameAllocationCheck {
+public:
+    static const int WARMUP_FRAMES = 120;
+
+    void beginFrame();
+    void endFrame();
+    void restartWarmup();
+
+    uint64_t lastFrameAllocations() const { return frameAllocations; }
+
+private:
+    uint64_t frameStart = 0;
+    uint64_t frameAllocations = 0;
+    int warmupFrames = 0;       // Frames since the last restart, up to WARMUP_FRAMES
+};
+
+#endif
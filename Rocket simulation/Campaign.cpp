@@ -0,0 +1,389 @@
+#include "Campaign.h"
+#include "Flight.h"
+#include "Scenario.h"
+#include "Topology.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+const double RADIANS_TO_DEGREES = 57.29577951308232;
+const long CAMPAIGN_BATCH = 16; // Runs a worker claims at a time
+const double HISTOGRAM_SPREAD = 0.25; // Histograms span the nominal flight's values +/- this fraction
+
+static_assert(std::is_trivially_copyable<CampaignStatistics>::value, "published with memcpy");
+
+void CampaignStatistics::add(const RunOutcome& outcome) {
+    apogee.add(outcome.apogee);
+    burnoutTime.add(outcome.burnoutTime);
+    maxAcceleration.add(outcome.maxAcceleration);
+}
+
+double NormalQuantile(double confidence) {
+    double low = 0.0, high = 10.0;
+    for (int i = 0; i < 64; i++) {
+        double middle = 0.5 * (low + high);
+        if (std::erf(middle / std::sqrt(2.0)) < confidence) low = middle;
+        else high = middle;
+    }
+    return 0.5 * (low + high);
+}
+
+// Wilson score interval: unlike the normal approximation it stays inside
+// [0, 1] and behaves with no failures yet
+static void WilsonInterval(long successes, long runs, double z, double& low, double& high) {
+    double n = static_cast<double>(runs);
+    double p = successes / n;
+    double z2 = z * z;
+    double centre = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+    double half = z / (1.0 + z2 / n) * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n));
+    low = std::max(0.0, centre - half);
+    high = std::min(1.0, centre + half);
+}
+
+// Highest point of the unpowered flight from here on: ballistic over flat
+// ground, the apoapsis of the Kepler orbit on the round-Earth models
+static float CoastApogee(const FlightState& flight) {
+    const Rocket& rocket = flight.rocket;
+    if (flight.scenario->gravityModel == GRAVITY_FLAT) {
+        return FlatCoastApogee(rocket.position.y, rocket.velocity.y, flight.scenario->gravity);
+    }
+    const glm::dvec3& position = flight.inertialPosition;
+    const glm::dvec3& velocity = flight.inertialVelocity;
+    if (glm::dot(position, velocity) <= 0.0) return rocket.position.y; // Already on the way down
+    double radius = glm::length(position);
+    double energy = 0.5 * glm::dot(velocity, velocity) - EARTH_MU / radius;
+    if (energy >= 0.0) return std::numeric_limits<float>::infinity();
+    double momentum = glm::length(glm::cross(position, velocity));
+    double semiMajor = -EARTH_MU / (2.0 * energy);
+    double eccentricity = std::sqrt(std::max(0.0, 1.0 + 2.0 * energy * momentum * momentum / (EARTH_MU * EARTH_MU)));
+    return static_cast<float>(rocket.position.y + semiMajor * (1.0 + eccentricity) - radius);
+}
+
+// path, if given, receives the position after every step
+static RunOutcome FlyRun(const Scenario& scenario, uint32_t run, const FaultPlan& faults, float timeStep, float duration,
+    std::vector<glm::vec3>* path = nullptr) {
+    FlightState flight;
+    flight.scenario = &scenario;
+    flight.vehicle = run;
+    flight.faults = faults;
+    StartCountdown(flight, -scenario.countdown); // Liftoff on the first step
+
+    float maxTilt = 0.0f, maxAcceleration = 0.0f;
+    long steps = static_cast<long>(duration / timeStep);
+    long step = 0;
+    for (; step < steps && flight.fuelLevel > 0.0f; step++) {
+        UpdateFlight(flight, step * timeStep, timeStep);
+        float upright = std::cos(flight.rocket.pitch) * std::cos(flight.rocket.yaw);
+        maxTilt = std::max(maxTilt, std::acos(std::min(1.0f, std::max(-1.0f, upright))));
+        maxAcceleration = std::max(maxAcceleration, flight.acceleration);
+        if (path != nullptr) path->push_back(flight.rocket.position);
+    }
+
+    RunOutcome outcome;
+    outcome.engineOut = flight.faults.engineOut >= 0;
+    outcome.gimbalStuck = flight.faults.stuckGimbal >= 0;
+    outcome.altitude = flight.rocket.position.y;
+    outcome.maxTilt = static_cast<float>(maxTilt * RADIANS_TO_DEGREES);
+    outcome.success = outcome.altitude >= scenario.successAltitude && outcome.maxTilt <= scenario.successTilt;
+    outcome.apogee = CoastApogee(flight);
+    outcome.burnoutTime = step * timeStep;
+    outcome.maxAcceleration = maxAcceleration;
+    return outcome;
+}
+
+RunOutcome FlyCampaignRun(const Scenario& scenario, uint32_t run, float timeStep, float duration) {
+    return FlyRun(scenario, run, DrawFaults(scenario, run), timeStep, duration);
+}
+
+RunOutcome FlyNominalRun(const Scenario& scenario, float timeStep, float duration) {
+    return FlyRun(scenario, 0, FaultPlan(), timeStep, duration);
+}
+
+void TraceCampaignRuns(const Scenario& scenario, long runs, int pointsPerRun, float timeStep, float duration,
+    CampaignTraces& traces, const std::atomic<bool>* cancel) {
+    std::vector<glm::vec3> path;
+    for (long run = 0; run < runs; run++) {
+        if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) return;
+        path.clear();
+        RunOutcome outcome = FlyRun(scenario, static_cast<uint32_t>(run), DrawFaults(scenario, static_cast<uint32_t>(run)),
+            timeStep, duration, &path);
+        int count = static_cast<int>(std::min<size_t>(path.size(), static_cast<size_t>(std::max(2, pointsPerRun))));
+        traces.firsts.push_back(static_cast<int>(traces.points.size()));
+        traces.counts.push_back(count);
+        traces.flags.push_back(RunFlagsOf(outcome));
+        // Evenly spaced, always ending at burnout
+        for (int i = 0; i < count; i++) {
+            size_t step = count > 1 ? (path.size() - 1) * i / (count - 1) : 0;
+            traces.points.push_back(path[step]);
+        }
+    }
+}
+
+uint8_t RunFlagsOf(const RunOutcome& outcome) {
+    uint8_t flags = RUN_DONE;
+    if (outcome.success) flags |= RUN_SUCCESS;
+    if (outcome.engineOut) flags |= RUN_ENGINE_OUT;
+    if (outcome.gimbalStuck) flags |= RUN_GIMBAL_STUCK;
+    return flags;
+}
+
+bool CountRun(CampaignResult& result, uint8_t flags, const CampaignOptions& options, double z) {
+    bool success = (flags & RUN_SUCCESS) != 0;
+    result.runs++;
+    result.successes += success ? 1 : 0;
+    if (flags & RUN_ENGINE_OUT) {
+        result.engineOutRuns++;
+        result.engineOutFailures += success ? 0 : 1;
+    }
+    if (flags & RUN_GIMBAL_STUCK) {
+        result.gimbalStuckRuns++;
+        result.gimbalStuckFailures += success ? 0 : 1;
+    }
+    WilsonInterval(result.successes, result.runs, z, result.low, result.high);
+    return options.halfWidth > 0.0 && result.runs >= options.minRuns && 0.5 * (result.high - result.low) <= options.halfWidth;
+}
+
+void SetHistogramRanges(CampaignStatistics& statistics, const RunOutcome& nominal) {
+    statistics.apogee.histogram.setRange((1.0 - HISTOGRAM_SPREAD) * nominal.apogee, (1.0 + HISTOGRAM_SPREAD) * nominal.apogee);
+    statistics.burnoutTime.histogram.setRange((1.0 - HISTOGRAM_SPREAD) * nominal.burnoutTime,
+        (1.0 + HISTOGRAM_SPREAD) * nominal.burnoutTime);
+    statistics.maxAcceleration.histogram.setRange((1.0 - HISTOGRAM_SPREAD) * nominal.maxAcceleration,
+        (1.0 + HISTOGRAM_SPREAD) * nominal.maxAcceleration);
+}
+
+void PublishStatistics(WorkerStatistics& worker) {
+    uint32_t sequence = worker.sequence.load(std::memory_order_relaxed);
+    worker.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&worker.published, &worker.local, sizeof(CampaignStatistics));
+    worker.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void MergePublished(const WorkerStatistics& worker, CampaignStatistics& into, CampaignStatistics& scratch) {
+    for (int attempt = 0; attempt < 100; attempt++) {
+        uint32_t before = worker.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        std::memcpy(&scratch, &worker.published, sizeof(CampaignStatistics));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (worker.sequence.load(std::memory_order_relaxed) == before) {
+            into.merge(scratch);
+            return;
+        }
+    }
+}
+
+CampaignResult RunCampaign(const Scenario& scenario, const CampaignOptions& options) {
+    CampaignResult result;
+    const RunOutcome nominal = FlyNominalRun(scenario, options.timeStep, options.duration);
+    SetHistogramRanges(result.statistics, nominal);
+    const long maxRuns = options.maxRuns;
+    const double z = NormalQuantile(options.confidence);
+    int workerCount = options.workers > 0 ? options.workers : static_cast<int>(std::thread::hardware_concurrency());
+    if (workerCount < 1) workerCount = 1;
+
+    std::vector<std::atomic<uint8_t> > outcomes(static_cast<size_t>(maxRuns));
+    std::atomic<long> nextRun{ 0 };
+    std::atomic<long> simulated{ 0 };
+    std::atomic<bool> stop{ false };
+    // Each worker allocates and fills its own statistics, so first touch puts
+    // a pinned worker's on its node; null until the worker has made them
+    std::vector<std::atomic<WorkerStatistics*> > statistics(static_cast<size_t>(workerCount));
+    CpuTopology topology;
+    if (options.pinWorkers) topology = DetectTopology();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back([&, i] {
+            if (options.pinWorkers) PinThreadToCpu(SpreadCpu(topology, i));
+            WorkerStatistics& mine = *new WorkerStatistics();
+            SetHistogramRanges(mine.local, nominal);
+            mine.published = mine.local;
+            statistics[i].store(&mine, std::memory_order_release);
+            while (!stop.load(std::memory_order_relaxed)) {
+                long first = nextRun.fetch_add(CAMPAIGN_BATCH, std::memory_order_relaxed);
+                if (first >= maxRuns) break;
+                long last = std::min(first + CAMPAIGN_BATCH, maxRuns);
+                for (long run = first; run < last && !stop.load(std::memory_order_relaxed); run++) {
+                    RunOutcome outcome = FlyCampaignRun(scenario, static_cast<uint32_t>(run), options.timeStep, options.duration);
+                    mine.local.add(outcome);
+                    outcomes[run].store(RunFlagsOf(outcome), std::memory_order_release);
+                    simulated.fetch_add(1, std::memory_order_relaxed);
+                }
+                PublishStatistics(mine);
+            }
+        });
+    }
+
+    // Fold finished runs in order; a gap waits for its run
+    auto lastProgress = start;
+    CampaignStatistics scratch;
+    while (result.runs < maxRuns && !result.stoppedEarly) {
+        if (options.cancel != nullptr && options.cancel->load(std::memory_order_relaxed)) {
+            result.cancelled = true;
+            stop.store(true, std::memory_order_relaxed);
+            break;
+        }
+        uint8_t flags;
+        while (result.runs < maxRuns && (flags = outcomes[result.runs].load(std::memory_order_acquire)) != 0) {
+            if (CountRun(result, flags, options, z)) {
+                result.stoppedEarly = true;
+                stop.store(true, std::memory_order_relaxed);
+                break;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (options.progress != nullptr && now - lastProgress >= std::chrono::seconds(1) && result.runs > 0) {
+            result.probability = double(result.successes) / result.runs;
+            result.statistics = CampaignStatistics();
+            SetHistogramRanges(result.statistics, nominal);
+            for (const std::atomic<WorkerStatistics*>& worker : statistics) {
+                if (const WorkerStatistics* published = worker.load(std::memory_order_acquire)) {
+                    MergePublished(*published, result.statistics, scratch);
+                }
+            }
+            options.progress(result, options.progressContext);
+            lastProgress = now;
+        }
+        if (result.runs < maxRuns && !result.stoppedEarly) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    // Workers are done: merge their own copies, no sequence needed
+    result.statistics = CampaignStatistics();
+    SetHistogramRanges(result.statistics, nominal);
+    for (std::atomic<WorkerStatistics*>& worker : statistics) {
+        std::unique_ptr<WorkerStatistics> owned(worker.load(std::memory_order_relaxed));
+        result.statistics.merge(owned->local);
+    }
+
+    result.probability = result.runs > 0 ? double(result.successes) / result.runs : 0.0;
+    result.simulated = simulated.load();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void PrintProgress(const CampaignResult& sofar, void*) {
+    std::cout << "  " << sofar.runs << " runs, success " << sofar.probability
+        << " [" << sofar.low << ", " << sofar.high << "]";
+    if (sofar.statistics.apogee.digest.weight > 0.0) { // Empty, and its median NaN, until a worker publishes
+        std::cout << ", median apogee " << sofar.statistics.apogee.digest.quantile(0.5) << " m";
+    }
+    std::cout << std::endl;
+}
+
+static void PrintDistribution(const char* name, const Distribution& distribution) {
+    const RunningMoments& moments = distribution.moments;
+    const TDigest& digest = distribution.digest;
+    if (digest.weight == 0.0) {
+        std::cout << std::setw(22) << std::left << name << std::right << "no runs simulated" << std::endl;
+        return;
+    }
+    std::cout << std::setw(22) << std::left << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << moments.mean << std::setw(9) << moments.deviation()
+        << std::setw(10) << moments.minimum << std::setw(10) << digest.quantile(0.05)
+        << std::setw(10) << digest.quantile(0.5) << std::setw(10) << digest.quantile(0.95)
+        << std::setw(10) << moments.maximum << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+void PrintCampaignResult(const CampaignResult& result) {
+    std::cout << "Runs: " << result.runs << (result.stoppedEarly ? ", stopped early" : "")
+        << "; " << result.simulated << " simulated" << std::endl;
+    std::cout << "Success probability: " << result.probability << ", interval [" << result.low << ", " << result.high << "]" << std::endl;
+    std::cout << "Engine-out runs: " << result.engineOutRuns << ", " << result.engineOutFailures << " failed" << std::endl;
+    std::cout << "Gimbal-stuck runs: " << result.gimbalStuckRuns << ", " << result.gimbalStuckFailures << " failed" << std::endl;
+    std::cout << "Time: " << result.seconds << " s, " << result.simulated / result.seconds << " runs/s" << std::endl;
+    std::cout << "Over " << result.statistics.apogee.moments.count << " simulated runs:" << std::endl;
+    std::cout << std::setw(22) << std::left << "" << std::right << std::setw(10) << "mean" << std::setw(9) << "sd"
+        << std::setw(10) << "min" << std::setw(10) << "p5" << std::setw(10) << "p50" << std::setw(10) << "p95"
+        << std::setw(10) << "max" << std::endl;
+    PrintDistribution("Apogee (m)", result.statistics.apogee);
+    PrintDistribution("Burnout time (s)", result.statistics.burnoutTime);
+    PrintDistribution("Max accel. (m/s^2)", result.statistics.maxAcceleration);
+}
+
+int RunCampaignMode(const CampaignOptions& options) {
+    if (options.maxRuns <= 0 || options.minRuns < 0 || !(options.confidence > 0.0 && options.confidence < 1.0)
+        || !(options.halfWidth >= 0.0) || !(options.duration > 0.0f) || !(options.timeStep > 0.0f)) {
+        std::cerr << "Campaign needs runs, a confidence in (0, 1), a half-width, a duration and a timestep" << std::endl;
+        return -1;
+    }
+    const Scenario& scenario = ActiveScenario();
+    std::cout << "Campaign: " << scenario.name << ", up to " << options.maxRuns << " runs";
+    if (options.halfWidth > 0.0) std::cout << ", stopping at +/-" << options.halfWidth;
+    std::cout << " (" << options.confidence * 100.0 << "% interval)" << std::endl;
+
+    CampaignOptions reporting = options;
+    reporting.progress = PrintProgress;
+    CampaignResult result = RunCampaign(scenario, reporting);
+
+    PrintCampaignResult(result);
+    return 0;
+}
+
+BackgroundCampaign::~BackgroundCampaign() {
+    stop();
+}
+
+bool BackgroundCampaign::start(const Scenario& campaignScenario, const CampaignOptions& options) {
+    if (isRunning()) return false;
+    if (thread.joinable()) thread.join(); // The last one, finished
+    scenario = campaignScenario;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reported = false;
+    }
+    cancel.store(false);
+    running.store(true, std::memory_order_release);
+
+    CampaignOptions reporting = options;
+    reporting.progress = report;
+    reporting.progressContext = this;
+    reporting.cancel = &cancel;
+    finishedTraces = CampaignTraces();
+    traced = false;
+    thread = std::thread([this, reporting] {
+        CampaignResult final = RunCampaign(scenario, reporting);
+        report(final, this);
+        if (!final.cancelled) {
+            long tracedRuns = final.runs < TRACED_RUNS ? final.runs : TRACED_RUNS;
+            TraceCampaignRuns(scenario, tracedRuns, TRACE_POINTS, reporting.timeStep,
+                reporting.duration, finishedTraces, &cancel);
+            traced = !cancel.load();
+        }
+        running.store(false, std::memory_order_release);
+    });
+    return true;
+}
+
+void BackgroundCampaign::stop() {
+    cancel.store(true);
+    if (thread.joinable()) thread.join();
+}
+
+bool BackgroundCampaign::latest(CampaignResult& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (reported) out = result;
+    return reported;
+}
+
+const CampaignTraces* BackgroundCampaign::traces() const {
+    return !isRunning() && traced ? &finishedTraces : nullptr;
+}
+
+void BackgroundCampaign::report(const CampaignResult& sofar, void* context) {
+    BackgroundCampaign& campaign = *static_cast<BackgroundCampaign*>(context);
+    std::lock_guard<std::mutex> lock(campaign.mutex);
+    campaign.result = sofar;
+    campaign.reported = true;
+}
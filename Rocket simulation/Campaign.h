@@ -0,0 +1,178 @@
+#ifndef CAMPAIGN_H
+#define CAMPAIGN_H
+
+#include "Scenario.h"
+#include "Statistics.h"
+#include <glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Monte Carlo reliability campaign: many flights of one scenario, each with
+// its own sensor noise and faults drawn from the scenario's fault model,
+// judged against its success criteria.
+
+// What one run did
+struct RunOutcome {
+    bool success;
+    bool engineOut;             // Drawn, whether or not it struck before burnout
+    bool gimbalStuck;
+    float altitude;             // m at burnout
+    float maxTilt;              // Degrees from vertical
+    float apogee;               // m, coasting on from burnout; infinite once the vehicle escapes
+    float burnoutTime;          // s after liftoff, or the duration if it still burns
+    float maxAcceleration;      // m/s^2
+};
+
+// Distributions of what the runs did, over every simulated run (the count
+// includes runs in flight when the campaign stopped)
+struct CampaignStatistics {
+    Distribution apogee;        // m
+    Distribution burnoutTime;   // s after liftoff
+    Distribution maxAcceleration; // m/s^2
+
+    void add(const RunOutcome& outcome);
+
+    void merge(const CampaignStatistics& other) {
+        apogee.merge(other.apogee);
+        burnoutTime.merge(other.burnoutTime);
+        maxAcceleration.merge(other.maxAcceleration);
+    }
+};
+
+// One worker's statistics: its own running copy, and the copy it publishes
+// after every batch. Readers retry while the sequence is odd or moves, which
+// works across processes too when the block is in shared memory.
+struct alignas(64) WorkerStatistics {
+    CampaignStatistics local;
+    std::atomic<uint32_t> sequence{ 0 };
+    CampaignStatistics published;
+};
+
+void PublishStatistics(WorkerStatistics& worker);
+
+// Adds the worker's last consistent copy; skips it if the worker kept it busy
+void MergePublished(const WorkerStatistics& worker, CampaignStatistics& into, CampaignStatistics& scratch);
+
+// Estimate so far, or at the end
+struct CampaignResult {
+    long runs = 0;              // Counted: the first runs up to the stopping point, in run order
+    long successes = 0;
+    double probability = 0.0;
+    double low = 0.0, high = 0.0; // Wilson score interval at the chosen confidence
+    bool stoppedEarly = false;
+    bool cancelled = false;
+    long simulated = 0;         // Including runs in flight when the campaign stopped
+    double seconds = 0.0;
+    long engineOutRuns = 0, engineOutFailures = 0;
+    long gimbalStuckRuns = 0, gimbalStuckFailures = 0;
+    CampaignStatistics statistics;
+};
+
+struct CampaignOptions {
+    long maxRuns = 100000;
+    long minRuns = 200;         // Before the interval may stop the campaign
+    double confidence = 0.95;   // Of the success probability interval
+    double halfWidth = 0.01;    // Stop once the interval is this tight each way; 0 runs them all
+    int workers = 0;            // Threads, 0 = one per core
+    bool pinWorkers = false;    // Each worker pinned to a CPU, spread over the NUMA nodes (SpreadCpu); its statistics are allocated there
+    float duration = 60.0f;     // Simulated s per run at most, from liftoff
+    float timeStep = 0.02f;     // s
+    void (*progress)(const CampaignResult& sofar, void* context) = nullptr; // About once a second, on the calling thread
+    void* progressContext = nullptr;
+    const std::atomic<bool>* cancel = nullptr; // Stops the campaign where it is once set
+};
+
+// A finished run in an outcome table; 0 means not finished yet
+enum RunFlags : uint8_t {
+    RUN_DONE = 1,
+    RUN_SUCCESS = 2,
+    RUN_ENGINE_OUT = 4,
+    RUN_GIMBAL_STUCK = 8
+};
+
+uint8_t RunFlagsOf(const RunOutcome& outcome);
+
+// Flies campaign run number run to burnout, or for duration at most
+RunOutcome FlyCampaignRun(const Scenario& scenario, uint32_t run, float timeStep, float duration);
+
+// Run 0 without faults: what the design does, with run 0's sensor noise
+RunOutcome FlyNominalRun(const Scenario& scenario, float timeStep, float duration);
+
+// The same histogram ranges for every partial statistics, so they merge bin
+// for bin, set around what a flight without faults does
+void SetHistogramRanges(CampaignStatistics& statistics, const RunOutcome& nominal);
+
+// z of a two-sided normal interval holding the given confidence
+double NormalQuantile(double confidence);
+
+// Counts the next run in run order into the estimate; true once the interval
+// is tight enough to stop there. z is NormalQuantile(options.confidence).
+bool CountRun(CampaignResult& result, uint8_t flags, const CampaignOptions& options, double z);
+
+// Workers claim runs in small batches; the calling thread folds finished
+// runs into the estimate in run order and stops the campaign at the first
+// run after which the interval is tight enough. Counting in run order makes
+// the estimate independent of the worker count and of timing. Each worker
+// keeps its own statistics and publishes a copy under a seqlock after every
+// batch for the progress reports; they are merged once the workers are done.
+CampaignResult RunCampaign(const Scenario& scenario, const CampaignOptions& options);
+
+// Paths of the first runs of a campaign, for the 3D view: each run to
+// burnout, sampled at evenly spaced steps
+struct CampaignTraces {
+    std::vector<glm::vec3> points;
+    std::vector<int> firsts;    // Into points, one per run
+    std::vector<int> counts;
+    std::vector<uint8_t> flags; // RunFlagsOf each run
+};
+
+// Flies runs [0, runs) again, keeping at most pointsPerRun positions of
+// each; stops early once cancel is set
+void TraceCampaignRuns(const Scenario& scenario, long runs, int pointsPerRun, float timeStep, float duration,
+    CampaignTraces& traces, const std::atomic<bool>* cancel = nullptr);
+
+// A campaign on a thread of its own, for the dashboard: it polls latest()
+// every frame while the campaign runs and keeps showing the final result
+class BackgroundCampaign {
+public:
+    ~BackgroundCampaign();
+
+    // False while one is already running
+    bool start(const Scenario& scenario, const CampaignOptions& options);
+    void stop();                // Cancels a running campaign and waits for it
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Copies the last report, false before the first one
+    bool latest(CampaignResult& out) const;
+
+    // Paths of the first TRACED_RUNS counted runs, flown once the campaign
+    // has finished; null while it runs or if it was cancelled
+    const CampaignTraces* traces() const;
+
+    static const long TRACED_RUNS = 1000;
+    static const int TRACE_POINTS = 100;  // Per run: 100K points at most, like a long trail
+
+private:
+    static void report(const CampaignResult& sofar, void* context);
+
+    Scenario scenario;          // Own copy, whatever happens to the caller's
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> cancel{ false };
+    mutable std::mutex mutex;   // Guards the report, copied once a second and once per frame
+    CampaignResult result;
+    bool reported = false;
+    CampaignTraces finishedTraces; // Written by the campaign thread before running clears
+    bool traced = false;
+};
+
+// The final report RunCampaignMode prints
+void PrintCampaignResult(const CampaignResult& result);
+
+// Runs a campaign on the active scenario and prints its progress and result
+int RunCampaignMode(const CampaignOptions& options);
+
+#endif
@@ -0,0 +1,307 @@
+#include "CommandServer.h"
+#include "Flight.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+const size_t MAX_LINE_LENGTH = 256;
+const size_t MAX_PENDING_OUTPUT = 64 * 1024; // A client this far behind is not reading
+const int POLL_INTERVAL_MS = 5;              // Bounds how long a reply waits for the network thread
+
+static const char* ProgressName(ProgressState progress) {
+    switch (progress) {
+    case LOAD_FUEL: return "load_fuel";
+    case COUNTDOWN: return "countdown";
+    case START_ENGINES: return "engines";
+    case LIFTOFF: return "liftoff";
+    default: return "?";
+    }
+}
+
+static void FormatReply(char* text, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(text, size, format, args);
+    va_end(args);
+}
+
+CommandServer::CommandServer()
+    : commands(new SpscQueue<Command, 256>()), replies(new SpscQueue<Reply, 256>()) {
+}
+
+CommandServer::~CommandServer() {
+    stop();
+}
+
+bool CommandServer::start(uint16_t port) {
+    stop();
+    listener = OpenLoopbackServer(SOCKET_TCP, port);
+    if (listener == INVALID_SOCKET_HANDLE) {
+        std::cerr << "Command server cannot bind 127.0.0.1:" << port << std::endl;
+        return false;
+    }
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&CommandServer::run, this);
+    return true;
+}
+
+void CommandServer::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+    for (Connection& connection : connections) CloseSocket(connection.socket);
+    connections.clear();
+    CloseSocket(listener);
+    listener = INVALID_SOCKET_HANDLE;
+
+    // Nothing may carry over to the next start; the physics side is not running apply() now
+    Command command;
+    while (commands->tryPop(command)) {}
+    Reply reply;
+    while (replies->tryPop(reply)) {}
+}
+
+int CommandServer::apply(FlightState& flight, float time, SimulationControl& control) {
+    int applied = 0;
+    Command command;
+    while (commands->tryPop(command)) {
+        Reply reply;
+        reply.connection = command.connection;
+        char* text = reply.text;
+        size_t size = sizeof(reply.text);
+
+        switch (command.type) {
+        case COMMAND_LAUNCH:
+            if (flight.isLiftoffInitiated) {
+                FormatReply(text, size, "error already launched");
+                break;
+            }
+            LaunchFlight(flight, time);
+            FormatReply(text, size, "ok launch t=%.3f", time);
+            break;
+        case COMMAND_ABORT:
+            AbortFlight(flight);
+            FormatReply(text, size, "ok abort");
+            break;
+        case COMMAND_THROTTLE:
+            SetThrottle(flight, command.engine, command.value);
+            FormatReply(text, size, "ok throttle %.1f,%.1f,%.1f,%.1f,%.1f", flight.thrustLevels[0], flight.thrustLevels[1],
+                flight.thrustLevels[2], flight.thrustLevels[3], flight.thrustLevels[4]);
+            break;
+        case COMMAND_THROTTLE_AUTO:
+            ReleaseThrottle(flight);
+            FormatReply(text, size, "ok throttle auto");
+            break;
+        case COMMAND_TIMESTEP:
+            control.timeStep = command.value;
+            FormatReply(text, size, "ok timestep %g", control.timeStep);
+            break;
+        case COMMAND_STATE:
+            FormatReply(text, size, "ok t=%.3f progress=%s altitude=%.2f speed=%.2f acceleration=%.2f fuel=%.2f mass=%.1f"
+                " thrust=%.1f,%.1f,%.1f,%.1f,%.1f throttle=%s timestep=%g",
+                time, ProgressName(flight.currentProgress), flight.rocket.position.y, flight.rocket.velocity.y,
+                flight.acceleration, flight.fuelLevel, flight.currentMass,
+                flight.thrustLevels[0], flight.thrustLevels[1], flight.thrustLevels[2], flight.thrustLevels[3],
+                flight.thrustLevels[4], flight.manualThrottle ? "manual" : "auto", control.timeStep);
+            break;
+        case COMMAND_QUIT:
+            control.quitRequested = true;
+            FormatReply(text, size, "ok quit");
+            break;
+        }
+        replies->tryPush(reply); // Only fails with 256 replies unsent; the client then misses one line
+        applied++;
+    }
+    return applied;
+}
+
+// Splits off the next space-separated word in place, "" at the end of the line
+static const char* NextWord(char*& cursor) {
+    while (*cursor == ' ' || *cursor == '\t') cursor++;
+    const char* word = cursor;
+    while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t') cursor++;
+    if (*cursor != '\0') *cursor++ = '\0';
+    return word;
+}
+
+// Parses one line on the network thread. Malformed input is answered here and
+// never reaches the physics loop. The line is tokenized where it lies in the
+// connection's input, so a command costs no allocation.
+void CommandServer::handleLine(Connection& connection, char* line) {
+    const char* name = NextWord(line);
+    const char* first = NextWord(line);
+    const char* second = NextWord(line);
+    if (*name == '\0') return;
+
+    Command command;
+    command.connection = connection.id;
+    command.engine = -1;
+    command.value = 0.0f;
+    if (std::strcmp(name, "launch") == 0) command.type = COMMAND_LAUNCH;
+    else if (std::strcmp(name, "abort") == 0) command.type = COMMAND_ABORT;
+    else if (std::strcmp(name, "state") == 0) command.type = COMMAND_STATE;
+    else if (std::strcmp(name, "quit") == 0) command.type = COMMAND_QUIT;
+    else if (std::strcmp(name, "throttle") == 0 && std::strcmp(first, "auto") == 0) command.type = COMMAND_THROTTLE_AUTO;
+    else if (std::strcmp(name, "throttle") == 0) {
+        char* end = nullptr;
+        bool all = std::strcmp(first, "all") == 0;
+        command.type = COMMAND_THROTTLE;
+        command.engine = all ? -1 : static_cast<int>(std::strtol(first, &end, 10)) - 1;
+        bool engineValid = all || (end != first && *end == '\0' && command.engine >= 0 && command.engine < 5);
+        command.value = std::strtof(second, &end);
+        if (!engineValid || *second == '\0' || *end != '\0' || !(command.value >= 0.0f && command.value <= 100.0f)) {
+            connection.output += "error usage: throttle <1-5|all> <0-100> | throttle auto\n";
+            return;
+        }
+    }
+    else if (std::strcmp(name, "timestep") == 0) {
+        char* end = nullptr;
+        command.type = COMMAND_TIMESTEP;
+        command.value = std::strtof(first, &end);
+        if (*first == '\0' || *end != '\0' || !(command.value >= 0.0f) || command.value > 1.0f) {
+            connection.output += "error usage: timestep <0-1 seconds>\n";
+            return;
+        }
+    }
+    else if (std::strcmp(name, "help") == 0) {
+        connection.output += "ok launch | abort | throttle <1-5|all> <0-100> | throttle auto | timestep <s> | state | quit\n";
+        return;
+    }
+    else {
+        connection.output += "error unknown command ";
+        connection.output += name;
+        connection.output += '\n';
+        return;
+    }
+
+    if (!commands->tryPush(command)) {
+        connection.output += "error busy\n"; // The physics loop is not draining, e.g. paused in a debugger
+        return;
+    }
+    if (wake != nullptr) wake();
+}
+
+// Lines are handled after every chunk, so the input never holds more than
+// one unfinished line and a chunk
+void CommandServer::readConnection(Connection& connection) {
+    char buffer[1024];
+    for (;;) {
+        long received = ReceiveBytes(connection.socket, buffer, sizeof(buffer));
+        if (received == 0 || (received < 0 && !LastErrorWouldBlock())) {
+            connection.closed = true;
+            return;
+        }
+        if (received < 0) return;
+        connection.input.append(buffer, static_cast<size_t>(received));
+
+        size_t start = 0;
+        for (size_t end; (end = connection.input.find('\n', start)) != std::string::npos; start = end + 1) {
+            char* line = &connection.input[start];
+            connection.input[end] = '\0';
+            if (end > start && connection.input[end - 1] == '\r') connection.input[end - 1] = '\0';
+            handleLine(connection, line);
+        }
+        connection.input.erase(0, start);
+        if (connection.input.size() > MAX_LINE_LENGTH) {
+            // Not a client of this protocol; stop reading it at once
+            connection.output += "error line too long\n";
+            flushConnection(connection);
+            connection.closed = true;
+            return;
+        }
+    }
+}
+
+void CommandServer::flushConnection(Connection& connection) {
+    while (!connection.output.empty()) {
+        long written = SendBytes(connection.socket, connection.output.data(), connection.output.size());
+        if (written < 0) {
+            if (!LastErrorWouldBlock() || connection.output.size() > MAX_PENDING_OUTPUT) connection.closed = true;
+            return;
+        }
+        connection.output.erase(0, static_cast<size_t>(written));
+    }
+}
+
+void CommandServer::run() {
+    std::vector<pollfd> fds;
+    while (running.load(std::memory_order_acquire)) {
+        fds.clear();
+        fds.push_back({ listener, POLLIN, 0 });
+        for (const Connection& connection : connections) {
+            fds.push_back({ connection.socket, static_cast<short>(connection.output.empty() ? POLLIN : POLLIN | POLLOUT), 0 });
+        }
+        if (PollSockets(fds.data(), fds.size(), POLL_INTERVAL_MS) < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        }
+
+        if (fds[0].revents & POLLIN) {
+            for (SocketHandle socket; (socket = accept(listener, nullptr, nullptr)) != INVALID_SOCKET_HANDLE;) {
+                if (!SetNonBlocking(socket)) {
+                    CloseSocket(socket);
+                    continue;
+                }
+                Connection connection;
+                connection.socket = socket;
+                connection.id = nextConnectionId++;
+                connections.push_back(std::move(connection));
+            }
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) readConnection(connections[i - 1]);
+        }
+
+        Reply reply;
+        while (replies->tryPop(reply)) {
+            for (Connection& connection : connections) {
+                if (connection.id != reply.connection) continue;
+                connection.output += reply.text;
+                connection.output += '\n';
+            }
+        }
+
+        connections.erase(std::remove_if(connections.begin(), connections.end(), [&](Connection& connection) {
+            if (!connection.closed) flushConnection(connection);
+            if (connection.closed) CloseSocket(connection.socket);
+            return connection.closed;
+        }), connections.end());
+    }
+}
+
+int RunCommandServer(float duration, uint16_t port, float timeStep) {
+    if (!(timeStep > 0.0f)) {
+        std::cerr << "Command server needs a positive timestep" << std::endl;
+        return -1;
+    }
+
+    CommandServer server;
+    if (!server.start(port)) {
+        return -1;
+    }
+    std::cout << "Listening for commands on 127.0.0.1:" << port << std::endl;
+
+    FlightState flight;
+    SimulationControl control;
+    control.timeStep = timeStep;
+
+    // Real-time paced; a timestep command takes effect from the next step
+    auto start = std::chrono::steady_clock::now();
+    double time = 0.0;
+    long steps = 0;
+    while (!control.quitRequested && (duration <= 0.0f || time < duration)) {
+        server.apply(flight, static_cast<float>(time), control);
+        float step = control.timeStep > 0.0f ? control.timeStep : timeStep;
+        time += step;
+        UpdateFlight(flight, static_cast<float>(time), step);
+        LogFlightEvents(flight);
+        steps++;
+        std::this_thread::sleep_until(start + std::chrono::duration<double>(time));
+    }
+    server.stop();
+
+    std::cout << "Stopped after " << time << " s, " << steps << " steps" << std::endl;
+    return 0;
+}
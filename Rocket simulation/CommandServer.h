@@ -0,0 +1,105 @@
+#ifndef COMMAND_SERVER_H
+#define COMMAND_SERVER_H
+
+#include "Sockets.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FlightState;
+
+// Remote control over a loopback TCP line protocol, one command per line and
+// one "ok ..." or "error ..." line back:
+//
+//   launch                       start the countdown
+//   abort                        stop the sequence and dump fuel
+//   throttle <1-5|all> <0-100>   hold engine thrust (%), overriding the ramp
+//   throttle auto                hand thrust back to the altitude ramp
+//   timestep <seconds>           longest physics step, 0 for the runner's default
+//   state                        one line of key=value flight state
+//   quit                         ask the runner to exit
+//   help
+//
+// A network thread parses lines and queues commands; the physics loop applies
+// them between steps through apply(), which never blocks or allocates.
+
+const uint16_t COMMAND_DEFAULT_PORT = 47801;
+
+// Runner settings the remote side may change, outside of FlightState
+struct SimulationControl {
+    float timeStep = 0.0f;      // Longest physics step (s), 0 for the runner's default
+    bool quitRequested = false;
+};
+
+class CommandServer {
+public:
+    CommandServer();
+    ~CommandServer();
+
+    bool start(uint16_t port = COMMAND_DEFAULT_PORT);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Called on the network thread whenever a command is queued, so a loop
+    // sleeping on something else (glfwPostEmptyEvent) picks it up. Set before start().
+    void setWakeCallback(void (*callback)()) { wake = callback; }
+
+    // Physics thread only: applies every queued command in arrival order and
+    // returns how many ran
+    int apply(FlightState& flight, float time, SimulationControl& control);
+
+private:
+    enum CommandType {
+        COMMAND_LAUNCH,
+        COMMAND_ABORT,
+        COMMAND_THROTTLE,
+        COMMAND_THROTTLE_AUTO,
+        COMMAND_TIMESTEP,
+        COMMAND_STATE,
+        COMMAND_QUIT
+    };
+
+    struct Command {
+        uint32_t connection;
+        CommandType type;
+        int engine;     // COMMAND_THROTTLE, -1 for all
+        float value;    // Throttle percent or timestep
+    };
+
+    struct Reply {
+        uint32_t connection;
+        char text[224];
+    };
+
+    struct Connection {
+        SocketHandle socket;
+        uint32_t id;
+        std::string input;      // Bytes after the last complete line
+        std::string output;     // Replies the socket has not taken yet
+        bool closed = false;
+    };
+
+    void run();
+    void readConnection(Connection& connection);
+    void handleLine(Connection& connection, char* line);
+    void flushConnection(Connection& connection);
+
+    std::unique_ptr<SpscQueue<Command, 256>> commands;  // Network thread to physics
+    std::unique_ptr<SpscQueue<Reply, 256>> replies;     // Physics to network thread
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    SocketHandle listener = INVALID_SOCKET_HANDLE;
+    std::vector<Connection> connections;
+    uint32_t nextConnectionId = 1;
+    void (*wake)() = nullptr;
+};
+
+// Steps one flight in real time, driven only by commands, until quit or duration
+int RunCommandServer(float duration, uint16_t port, float timeStep);
+
+#endif
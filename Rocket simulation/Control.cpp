@@ -0,0 +1,90 @@
+#include "Control.h"
+#include "Scenario.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+const float DEGREES_TO_RADIANS = 0.017453292519943295f;
+
+ControlGains ControlGainsFromScenario(const Scenario& scenario) {
+    ControlGains gains;
+    gains.attitudeKp = scenario.attitudeGains[0];
+    gains.attitudeKi = scenario.attitudeGains[1];
+    gains.attitudeKd = scenario.attitudeGains[2];
+    gains.throttleKp = scenario.throttleGains[0];
+    gains.throttleKi = scenario.throttleGains[1];
+    gains.targetAcceleration = scenario.targetAcceleration;
+    gains.gimbalLimit = scenario.gimbalLimit * DEGREES_TO_RADIANS;
+    gains.gimbalArm = scenario.gimbalArm;
+    gains.gyrationRadius = scenario.gyrationRadius;
+    gains.engines = static_cast<float>(SCENARIO_ENGINES);
+    return gains;
+}
+
+ControllerBank::ControllerBank(size_t count)
+    : pitch(count), yaw(count), pitchRate(count), yawRate(count),
+    thrustAcceleration(count), acceleration(count), mass(count),
+    gimbalPitch(count), gimbalYaw(count), throttle(count),
+    pitchIntegral(count), yawIntegral(count), throttleIntegral(count) {}
+
+void ControllerBank::tick(const ControlGains& gains, float dt) {
+    TickControllers(gains, dt, size(), pitch.data(), yaw.data(), pitchRate.data(), yawRate.data(),
+        thrustAcceleration.data(), acceleration.data(), mass.data(),
+        pitchIntegral.data(), yawIntegral.data(), throttleIntegral.data(),
+        gimbalPitch.data(), gimbalYaw.data(), throttle.data());
+}
+
+int RunControlBenchmark(int vehicles, int ticks) {
+    if (vehicles <= 0 || ticks <= 0) {
+        std::cerr << "Control benchmark needs vehicles and ticks" << std::endl;
+        return -1;
+    }
+    ControlGains gains = ControlGainsFromScenario(DefaultScenario());
+    gains.targetAcceleration = 2.0f;
+    const float dt = 1.0f / DefaultScenario().controlRate;
+
+    // Spread of attitudes and loads so some outputs saturate and some do not
+    ControllerBank bank(static_cast<size_t>(vehicles));
+    for (size_t i = 0; i < bank.size(); i++) {
+        float phase = 2.399963f * i;
+        bank.pitch[i] = 0.05f * std::sin(phase);
+        bank.yaw[i] = 0.05f * std::cos(phase);
+        bank.pitchRate[i] = 0.01f * std::cos(phase);
+        bank.yawRate[i] = -0.01f * std::sin(phase);
+        bank.thrustAcceleration[i] = 400.0f + 100.0f * std::sin(3.0f * phase);
+        bank.acceleration[i] = 1.0f + std::sin(5.0f * phase);
+        bank.mass[i] = 100.0f + 400.0f * (0.5f + 0.5f * std::sin(7.0f * phase));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; tick++) bank.tick(gains, dt);
+    double batched = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // The same work one vehicle at a time, the way FlightState ticks
+    std::vector<ControllerState> states(bank.size());
+    start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; tick++) {
+        for (size_t i = 0; i < states.size(); i++) {
+            ControllerState& state = states[i];
+            TickControllers(gains, dt, 1, &bank.pitch[i], &bank.yaw[i], &bank.pitchRate[i], &bank.yawRate[i],
+                &bank.thrustAcceleration[i], &bank.acceleration[i], &bank.mass[i],
+                &state.pitchIntegral, &state.yawIntegral, &state.throttleIntegral,
+                &state.gimbalPitch, &state.gimbalYaw, &state.throttle);
+        }
+    }
+    double single = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // Both paths must agree to the bit
+    size_t mismatches = 0;
+    for (size_t i = 0; i < states.size(); i++) {
+        if (states[i].gimbalPitch != bank.gimbalPitch[i] || states[i].gimbalYaw != bank.gimbalYaw[i]
+            || states[i].throttle != bank.throttle[i]) mismatches++;
+    }
+
+    double ticksTotal = double(ticks) * vehicles;
+    std::cout << "Controllers: " << vehicles << " vehicles, " << ticks << " ticks" << std::endl;
+    std::cout << "Batched: " << batched / ticksTotal << " ns per vehicle-tick" << std::endl;
+    std::cout << "One at a time: " << single / ticksTotal << " ns per vehicle-tick" << std::endl;
+    std::cout << "Mismatched outputs: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : -1;
+}
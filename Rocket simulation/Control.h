@@ -0,0 +1,114 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+struct Scenario;
+
+// Closed-loop flight control: a PID attitude loop per axis driving the engine
+// gimbals, and a PI throttle loop holding the sensed acceleration. It ticks
+// at its own rate (Scenario::controlRate) and the physics holds its commands
+// between ticks. The attitude loop asks for an angular acceleration and
+// divides by what a radian of gimbal currently buys, so one set of gains
+// works at any thrust.
+struct ControlGains {
+    float attitudeKp;           // 1/s^2
+    float attitudeKi;           // 1/s^3
+    float attitudeKd;           // 1/s
+    float throttleKp;           // Dimensionless, on acceleration error
+    float throttleKi;           // 1/s
+    float targetAcceleration;   // Dashboard units, 0 leaves the throttle to the ramp
+    float gimbalLimit;          // rad each way
+    float gimbalArm;            // m, centre of mass to gimbal pivots
+    float gyrationRadius;       // m
+    float engines;              // Engines sharing the throttle command
+};
+
+ControlGains ControlGainsFromScenario(const Scenario& scenario);
+
+// Integrator memory and held commands for one vehicle
+struct ControllerState {
+    float clock = 0.0f;         // s since the last tick
+    float pitchIntegral = 0.0f;
+    float yawIntegral = 0.0f;
+    float throttleIntegral = 0.0f;
+    float gimbalPitch = 0.0f;   // rad, commanded to every engine
+    float gimbalYaw = 0.0f;
+    float throttle = 0.0f;      // % per engine, used while the throttle loop is on
+};
+
+// One tick for count vehicles, one array per quantity. Branch-free over
+// restrict pointers so the loop vectorizes; a single flight passes count 1.
+// Integrators stop while their output is saturated (anti-windup). Templated
+// on the scalar type like the Rocket step (RocketDynamics.h): the flight
+// runs it in float, the sensitivity analysis on dual numbers.
+template <typename T>
+inline void TickControllers(const ControlGains& gains, T dt, size_t count,
+    const T* __restrict pitch, const T* __restrict yaw,
+    const T* __restrict pitchRate, const T* __restrict yawRate,
+    const T* __restrict thrustAcceleration, const T* __restrict acceleration, const T* __restrict mass,
+    T* __restrict pitchIntegral, T* __restrict yawIntegral, T* __restrict throttleIntegral,
+    T* __restrict gimbalPitch, T* __restrict gimbalYaw, T* __restrict throttle) {
+    const T limit = T(gains.gimbalLimit);
+    const T inertia = T(gains.gyrationRadius * gains.gyrationRadius);
+    for (size_t i = 0; i < count; i++) {
+        // rad of gimbal per rad/s^2 wanted: inertia / authority, and zero with
+        // the engines off. One unconditional division; a guarded one would
+        // be a branch.
+        T authority = thrustAcceleration[i] * gains.gimbalArm;
+        T perAngularAcceleration = inertia * authority / (authority * authority + T(1.0e-12f));
+
+        T pitchError = -pitch[i];
+        T pitchSum = pitchIntegral[i] + pitchError * dt;
+        T pitchWanted = (gains.attitudeKp * pitchError + gains.attitudeKi * pitchSum - gains.attitudeKd * pitchRate[i])
+            * perAngularAcceleration;
+        T pitchCommand = std::min(std::max(pitchWanted, -limit), limit);
+        pitchIntegral[i] = pitchCommand == pitchWanted ? pitchSum : pitchIntegral[i];
+        gimbalPitch[i] = pitchCommand;
+
+        T yawError = -yaw[i];
+        T yawSum = yawIntegral[i] + yawError * dt;
+        T yawWanted = (gains.attitudeKp * yawError + gains.attitudeKi * yawSum - gains.attitudeKd * yawRate[i])
+            * perAngularAcceleration;
+        T yawCommand = std::min(std::max(yawWanted, -limit), limit);
+        yawIntegral[i] = yawCommand == yawWanted ? yawSum : yawIntegral[i];
+        gimbalYaw[i] = yawCommand;
+
+        // Feed-forward of the target through the known mass, PI on the rest
+        T accelerationError = gains.targetAcceleration - acceleration[i];
+        T accelerationSum = throttleIntegral[i] + accelerationError * dt;
+        T throttleWanted = (gains.targetAcceleration + gains.throttleKp * accelerationError
+            + gains.throttleKi * accelerationSum) * mass[i] / gains.engines;
+        T throttleCommand = std::min(std::max(throttleWanted, T(0.0f)), T(100.0f));
+        throttleIntegral[i] = throttleCommand == throttleWanted ? accelerationSum : throttleIntegral[i];
+        throttle[i] = throttleCommand;
+    }
+}
+
+// Controllers for a batch of vehicles stepped together, e.g. a Monte Carlo
+// campaign. Sized once; tick() never allocates.
+class ControllerBank {
+public:
+    explicit ControllerBank(size_t count);
+
+    size_t size() const { return pitch.size(); }
+
+    // Sensed state, written by the caller before each tick
+    std::vector<float> pitch, yaw, pitchRate, yawRate;
+    std::vector<float> thrustAcceleration, acceleration, mass;
+
+    // Held commands
+    std::vector<float> gimbalPitch, gimbalYaw, throttle;
+
+    void tick(const ControlGains& gains, float dt);
+
+private:
+    std::vector<float> pitchIntegral, yawIntegral, throttleIntegral;
+};
+
+// Times ControllerBank::tick per vehicle
+int RunControlBenchmark(int vehicles, int ticks);
+
+#endif
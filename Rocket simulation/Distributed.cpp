@@ -0,0 +1,482 @@
+#include "Distributed.h"
+#include "Sockets.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+const long WORKER_BATCH = 16;                   // Runs a worker flies between reports
+const long STEAL_MINIMUM = 2 * WORKER_BATCH;    // Shorter ranges are left to their worker
+const uint32_t MAX_MESSAGE_SIZE = 64 * 1024;    // Larger payloads mean a peer of another build
+const int POLL_INTERVAL_MS = 100;
+
+// Every message is a MessageHeader and its payload. Both ends are the same
+// build on the same architecture, checked by the hello, so the structs go on
+// the wire as they are in memory.
+enum MessageType : uint32_t {
+    MESSAGE_HELLO,      // Worker: HelloMessage
+    MESSAGE_JOB,        // Coordinator: JobMessage
+    MESSAGE_RANGE,      // Coordinator: RangeMessage, fly [first, last)
+    MESSAGE_SHRINK,     // Coordinator: RangeMessage, the range now ends at last
+    MESSAGE_RESULTS,    // Worker: RunRecords
+    MESSAGE_IDLE,       // Worker: range finished, send more
+    MESSAGE_DONE        // Coordinator: the campaign is over
+};
+
+struct MessageHeader {
+    uint32_t type;
+    uint32_t size;      // Payload bytes that follow
+};
+
+struct HelloMessage {
+    uint32_t version;
+    uint32_t scenarioSize;
+    uint32_t recordSize;
+};
+
+struct JobMessage {
+    Scenario scenario;
+    float timeStep;
+    float duration;
+};
+
+struct RangeMessage {
+    uint32_t first, last;
+};
+
+// One flown run, all the coordinator needs of its RunOutcome
+struct RunRecord {
+    uint32_t run;
+    uint32_t flags;     // RunFlags
+    float apogee;
+    float burnoutTime;
+    float maxAcceleration;
+};
+
+namespace {
+
+void AppendMessage(std::string& output, MessageType type, const void* payload = nullptr, size_t size = 0) {
+    MessageHeader header = { type, static_cast<uint32_t>(size) };
+    output.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (size > 0) output.append(static_cast<const char*>(payload), size);
+}
+
+// Everything that has arrived; false once the peer is gone
+bool ReceiveAvailable(SocketHandle socket, std::string& input) {
+    char buffer[4096];
+    for (;;) {
+        long received = ReceiveBytes(socket, buffer, sizeof(buffer));
+        if (received == 0 || (received < 0 && !LastErrorWouldBlock())) return false;
+        if (received < 0) return true;
+        input.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+// Whatever the socket takes now; false once the peer is gone
+bool SendPending(SocketHandle socket, std::string& output) {
+    while (!output.empty()) {
+        long written = SendBytes(socket, output.data(), output.size());
+        if (written < 0) return LastErrorWouldBlock();
+        output.erase(0, static_cast<size_t>(written));
+    }
+    return true;
+}
+
+// Hands each whole message at the front of input to handle(type, payload,
+// size), which returns false for one it cannot take, and drops it. False on
+// such a message or an oversized one.
+template <typename Handler>
+bool TakeMessages(std::string& input, Handler handle) {
+    size_t offset = 0;
+    bool valid = true;
+    MessageHeader header;
+    while (valid && input.size() - offset >= sizeof(header)) {
+        std::memcpy(&header, input.data() + offset, sizeof(header));
+        if (header.size > MAX_MESSAGE_SIZE) {
+            valid = false;
+            break;
+        }
+        if (input.size() - offset - sizeof(header) < header.size) break;
+        valid = handle(header.type, input.data() + offset + sizeof(header), header.size);
+        offset += sizeof(header) + header.size;
+    }
+    input.erase(0, offset);
+    return valid;
+}
+
+struct WorkerConnection {
+    SocketHandle socket;
+    int id;
+    std::string input, output;
+    bool ready = false;         // Said hello and has the job
+    bool waiting = false;       // Asked for runs and has none
+    bool closed = false;
+    long next = 0, last = 0;    // Runs handed out and not reported yet
+    std::chrono::steady_clock::time_point heard;
+};
+
+class Coordinator {
+public:
+    Coordinator(const Scenario& scenario, const CoordinatorOptions& options, CoordinatorStats& stats)
+        : scenario(scenario), options(options), campaign(options.campaign), stats(stats),
+          outcomes(static_cast<size_t>(options.campaign.maxRuns), 0) {}
+
+    CampaignResult run();
+
+private:
+    bool handle(WorkerConnection& worker, uint32_t type, const char* payload, uint32_t size);
+    void assign(WorkerConnection& worker);
+    bool steal(WorkerConnection& thief, long& first, long& last);
+    void drop(WorkerConnection& worker, const char* why);
+
+    const Scenario& scenario;
+    const CoordinatorOptions& options;
+    const CampaignOptions& campaign;
+    CoordinatorStats& stats;
+    CampaignResult result;
+    std::vector<uint8_t> outcomes;                  // RunFlags by run, 0 until reported
+    std::vector<WorkerConnection> workers;
+    std::vector<std::pair<long, long> > returned;   // Ranges of lost workers, to hand out again
+    long fresh = 0;                                 // First run never handed out
+    bool finished = false;
+};
+
+bool Coordinator::handle(WorkerConnection& worker, uint32_t type, const char* payload, uint32_t size) {
+    switch (type) {
+    case MESSAGE_HELLO: {
+        HelloMessage hello;
+        if (size != sizeof(hello)) return false;
+        std::memcpy(&hello, payload, sizeof(hello));
+        if (hello.version != DISTRIBUTED_PROTOCOL_VERSION || hello.scenarioSize != sizeof(Scenario)
+            || hello.recordSize != sizeof(RunRecord)) {
+            return false;
+        }
+        JobMessage job;
+        std::memset(&job, 0, sizeof(job));
+        job.scenario = scenario;
+        job.timeStep = campaign.timeStep;
+        job.duration = campaign.duration;
+        AppendMessage(worker.output, MESSAGE_JOB, &job, sizeof(job));
+        worker.ready = true;
+        assign(worker);
+        return true;
+    }
+    case MESSAGE_RESULTS: {
+        if (size % sizeof(RunRecord) != 0) return false;
+        for (uint32_t offset = 0; offset < size; offset += sizeof(RunRecord)) {
+            RunRecord record;
+            std::memcpy(&record, payload + offset, sizeof(record));
+            if (record.run >= outcomes.size()) return false;
+            long run = static_cast<long>(record.run);
+            if (run >= worker.next && run < worker.last) worker.next = run + 1;
+            if (outcomes[run] != 0) {
+                stats.duplicateRuns++;
+                continue;
+            }
+            // Streamed straight into the estimate's statistics
+            outcomes[run] = static_cast<uint8_t>(record.flags | RUN_DONE);
+            RunOutcome outcome = RunOutcome();
+            outcome.apogee = record.apogee;
+            outcome.burnoutTime = record.burnoutTime;
+            outcome.maxAcceleration = record.maxAcceleration;
+            result.statistics.add(outcome);
+            result.simulated++;
+        }
+        return true;
+    }
+    case MESSAGE_IDLE:
+        worker.next = worker.last;
+        assign(worker);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// A range for a worker that has none: a lost worker's first, then fresh
+// runs, then half of another worker's. Otherwise it waits.
+void Coordinator::assign(WorkerConnection& worker) {
+    worker.waiting = true;
+    if (finished || !worker.ready) return;
+    long first, last;
+    if (!returned.empty()) {
+        // Lowest first: the estimate cannot move past a missing run
+        auto lowest = std::min_element(returned.begin(), returned.end());
+        first = lowest->first;
+        last = std::min(lowest->second, first + options.rangeRuns);
+        lowest->first = last;
+        if (lowest->first >= lowest->second) returned.erase(lowest);
+    }
+    else if (fresh < campaign.maxRuns) {
+        first = fresh;
+        last = std::min(fresh + options.rangeRuns, campaign.maxRuns);
+        fresh = last;
+    }
+    else if (!steal(worker, first, last)) {
+        return;
+    }
+    worker.next = first;
+    worker.last = last;
+    worker.waiting = false;
+    RangeMessage range = { static_cast<uint32_t>(first), static_cast<uint32_t>(last) };
+    AppendMessage(worker.output, MESSAGE_RANGE, &range, sizeof(range));
+}
+
+// Splits the largest range left in half and gives the thief the back half.
+// The owner may fly a little past the split before it hears; those runs
+// arrive twice and count once.
+bool Coordinator::steal(WorkerConnection& thief, long& first, long& last) {
+    WorkerConnection* victim = nullptr;
+    for (WorkerConnection& worker : workers) {
+        long left = worker.last - worker.next;
+        if (&worker == &thief || worker.closed || left < STEAL_MINIMUM) continue;
+        if (victim == nullptr || left > victim->last - victim->next) victim = &worker;
+    }
+    if (victim == nullptr) return false;
+    first = victim->next + (victim->last - victim->next) / 2;
+    last = victim->last;
+    victim->last = first;
+    RangeMessage shrink = { 0, static_cast<uint32_t>(first) };
+    AppendMessage(victim->output, MESSAGE_SHRINK, &shrink, sizeof(shrink));
+    stats.steals++;
+    return true;
+}
+
+void Coordinator::drop(WorkerConnection& worker, const char* why) {
+    if (worker.closed) return;
+    worker.closed = true;
+    if (worker.next < worker.last) {
+        returned.push_back(std::make_pair(worker.next, worker.last));
+        stats.reassignedRuns += worker.last - worker.next;
+    }
+    if (!finished) {
+        stats.workersLost++;
+        std::cout << "Worker " << worker.id << " " << why << "; runs " << worker.next << "-" << worker.last
+            << " go to the others" << std::endl;
+    }
+    worker.next = worker.last = 0;
+}
+
+CampaignResult Coordinator::run() {
+    SocketHandle listener = OpenLoopbackServer(SOCKET_TCP, options.port);
+    stats.listening = listener != INVALID_SOCKET_HANDLE;
+    if (!stats.listening) {
+        std::cerr << "Coordinator cannot bind 127.0.0.1:" << options.port << std::endl;
+        return result;
+    }
+    const RunOutcome nominal = FlyNominalRun(scenario, campaign.timeStep, campaign.duration);
+    SetHistogramRanges(result.statistics, nominal);
+    const double z = NormalQuantile(campaign.confidence);
+    const auto timeout = std::chrono::duration<float>(options.workerTimeout);
+    auto start = std::chrono::steady_clock::now();
+    auto lastProgress = start;
+
+    std::vector<pollfd> fds;
+    while (!finished) {
+        fds.clear();
+        fds.push_back({ listener, POLLIN, 0 });
+        for (const WorkerConnection& worker : workers) {
+            fds.push_back({ worker.socket, static_cast<short>(worker.output.empty() ? POLLIN : POLLIN | POLLOUT), 0 });
+        }
+        PollSockets(fds.data(), fds.size(), POLL_INTERVAL_MS);
+        auto now = std::chrono::steady_clock::now();
+
+        if (fds[0].revents & POLLIN) {
+            for (SocketHandle socket; (socket = accept(listener, nullptr, nullptr)) != INVALID_SOCKET_HANDLE;) {
+                if (!SetNonBlocking(socket)) {
+                    CloseSocket(socket);
+                    continue;
+                }
+                WorkerConnection worker;
+                worker.socket = socket;
+                worker.id = ++stats.workersSeen;
+                worker.heard = now;
+                workers.push_back(std::move(worker));
+            }
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            WorkerConnection& worker = workers[i - 1];
+            if (!(fds[i].revents & (POLLIN | POLLERR | POLLHUP))) continue;
+            bool connected = ReceiveAvailable(worker.socket, worker.input);
+            worker.heard = now;
+            if (!TakeMessages(worker.input, [&](uint32_t type, const char* payload, uint32_t size) {
+                return handle(worker, type, payload, size);
+            })) {
+                drop(worker, "sent something it should not have");
+            }
+            else if (!connected) {
+                drop(worker, "disconnected");
+            }
+        }
+        for (WorkerConnection& worker : workers) {
+            if (!worker.closed && worker.next < worker.last && now - worker.heard > timeout) drop(worker, "went silent");
+        }
+        workers.erase(std::remove_if(workers.begin(), workers.end(), [](WorkerConnection& worker) {
+            if (worker.closed) CloseSocket(worker.socket);
+            return worker.closed;
+        }), workers.end());
+        for (WorkerConnection& worker : workers) {
+            if (worker.waiting) assign(worker);
+        }
+
+        // Fold in run order, as RunCampaign does
+        while (result.runs < campaign.maxRuns && outcomes[result.runs] != 0) {
+            if (CountRun(result, outcomes[result.runs], campaign, z)) {
+                result.stoppedEarly = true;
+                break;
+            }
+        }
+        result.cancelled = campaign.cancel != nullptr && campaign.cancel->load(std::memory_order_relaxed);
+        finished = result.runs == campaign.maxRuns || result.stoppedEarly || result.cancelled;
+        result.probability = result.runs > 0 ? double(result.successes) / result.runs : 0.0;
+        if (campaign.progress != nullptr && now - lastProgress >= std::chrono::seconds(1) && result.runs > 0) {
+            campaign.progress(result, campaign.progressContext);
+            lastProgress = now;
+        }
+
+        for (WorkerConnection& worker : workers) {
+            if (finished) AppendMessage(worker.output, MESSAGE_DONE);
+            if (!SendPending(worker.socket, worker.output)) drop(worker, "disconnected");
+        }
+    }
+
+    // Give the workers a moment to take DONE before the sockets close
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (WorkerConnection& worker : workers) {
+        while (!worker.closed && !worker.output.empty() && std::chrono::steady_clock::now() < deadline) {
+            pollfd fd = { worker.socket, POLLOUT, 0 };
+            PollSockets(&fd, 1, POLL_INTERVAL_MS);
+            if (!SendPending(worker.socket, worker.output)) break;
+        }
+        CloseSocket(worker.socket);
+    }
+    workers.clear();
+    CloseSocket(listener);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void PrintCoordinatorProgress(const CampaignResult& sofar, void*) {
+    std::cout << "  " << sofar.runs << " runs, success " << sofar.probability
+        << " [" << sofar.low << ", " << sofar.high << "], " << sofar.simulated << " simulated";
+    if (sofar.statistics.apogee.digest.weight > 0.0) { // Empty, and its median NaN, until a worker reports
+        std::cout << ", median apogee " << sofar.statistics.apogee.digest.quantile(0.5) << " m";
+    }
+    std::cout << std::endl;
+}
+
+}
+
+CampaignResult RunCoordinator(const Scenario& scenario, const CoordinatorOptions& options, CoordinatorStats& stats) {
+    stats = CoordinatorStats();
+    Coordinator coordinator(scenario, options, stats);
+    return coordinator.run();
+}
+
+int RunCoordinatorMode(const CoordinatorOptions& options) {
+    const CampaignOptions& campaign = options.campaign;
+    if (campaign.maxRuns <= 0 || !(campaign.confidence > 0.0 && campaign.confidence < 1.0)
+        || !(campaign.halfWidth >= 0.0) || options.rangeRuns <= 0) {
+        std::cerr << "Coordinator needs runs, a confidence in (0, 1), a half-width and a range size" << std::endl;
+        return -1;
+    }
+    const Scenario& scenario = ActiveScenario();
+    std::cout << "Coordinating: " << scenario.name << ", up to " << campaign.maxRuns << " runs";
+    if (campaign.halfWidth > 0.0) std::cout << ", stopping at +/-" << campaign.halfWidth;
+    std::cout << "; workers connect to 127.0.0.1:" << options.port << std::endl;
+
+    CoordinatorOptions reporting = options;
+    reporting.campaign.progress = PrintCoordinatorProgress;
+    CoordinatorStats stats;
+    CampaignResult result = RunCoordinator(scenario, reporting, stats);
+    if (!stats.listening) return -1;
+
+    PrintCampaignResult(result);
+    std::cout << "Workers: " << stats.workersSeen << " connected, " << stats.workersLost << " lost; "
+        << stats.steals << " ranges stolen, " << stats.reassignedRuns << " runs handed out again, "
+        << stats.duplicateRuns << " flown twice" << std::endl;
+    return 0;
+}
+
+int RunCampaignWorker(uint16_t port) {
+    SocketHandle socket = ConnectLoopback(SOCKET_TCP, port);
+    if (socket == INVALID_SOCKET_HANDLE) {
+        std::cerr << "No coordinator on 127.0.0.1:" << port << std::endl;
+        return -1;
+    }
+    std::string input, output;
+    HelloMessage hello = { DISTRIBUTED_PROTOCOL_VERSION, sizeof(Scenario), sizeof(RunRecord) };
+    AppendMessage(output, MESSAGE_HELLO, &hello, sizeof(hello));
+
+    JobMessage job;
+    bool haveJob = false, done = false, askedForRuns = false, connected = true;
+    long next = 0, last = 0, flown = 0;
+    RunRecord records[WORKER_BATCH];
+    auto start = std::chrono::steady_clock::now();
+    while (!done && connected) {
+        // Block only with nothing to fly
+        bool busy = haveJob && next < last;
+        pollfd fd = { socket, static_cast<short>(output.empty() ? POLLIN : POLLIN | POLLOUT), 0 };
+        PollSockets(&fd, 1, busy ? 0 : POLL_INTERVAL_MS);
+        connected = SendPending(socket, output) && ReceiveAvailable(socket, input);
+        bool valid = TakeMessages(input, [&](uint32_t type, const char* payload, uint32_t size) {
+            RangeMessage range;
+            switch (type) {
+            case MESSAGE_JOB:
+                if (size != sizeof(job)) return false;
+                std::memcpy(&job, payload, sizeof(job));
+                haveJob = true;
+                return true;
+            case MESSAGE_RANGE:
+            case MESSAGE_SHRINK:
+                if (size != sizeof(range)) return false;
+                std::memcpy(&range, payload, sizeof(range));
+                if (type == MESSAGE_RANGE) {
+                    next = range.first;
+                    askedForRuns = false;
+                }
+                last = type == MESSAGE_RANGE ? static_cast<long>(range.last) : std::min(last, static_cast<long>(range.last));
+                return true;
+            case MESSAGE_DONE:
+                done = true;
+                return true;
+            default:
+                return false;
+            }
+        });
+        if (!valid) {
+            std::cerr << "Unexpected message from the coordinator" << std::endl;
+            break;
+        }
+        if (done || !haveJob) continue;
+
+        if (next < last) {
+            long end = std::min(next + WORKER_BATCH, last);
+            int count = 0;
+            for (long run = next; run < end; run++) {
+                RunOutcome outcome = FlyCampaignRun(job.scenario, static_cast<uint32_t>(run), job.timeStep, job.duration);
+                records[count++] = { static_cast<uint32_t>(run), RunFlagsOf(outcome), outcome.apogee, outcome.burnoutTime,
+                    outcome.maxAcceleration };
+            }
+            AppendMessage(output, MESSAGE_RESULTS, records, count * sizeof(RunRecord));
+            flown += count;
+            next = end;
+        }
+        else if (!askedForRuns) {
+            AppendMessage(output, MESSAGE_IDLE);
+            askedForRuns = true;
+        }
+    }
+    CloseSocket(socket);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Worker flew " << flown << " runs in " << seconds << " s" << std::endl;
+    if (!done) {
+        std::cerr << "Lost the coordinator before the campaign was done" << std::endl;
+        return -1;
+    }
+    return 0;
+}
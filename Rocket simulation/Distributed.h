@@ -0,0 +1,52 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "Campaign.h"
+#include <cstdint>
+
+// A campaign spread over worker processes. The coordinator listens on TCP,
+// sends each worker the scenario and hands out ranges of run numbers; the
+// workers fly them (FlyCampaignRun, the same runs a local campaign flies)
+// and stream back one record per run. The coordinator folds the records in
+// run order exactly as RunCampaign does, so the estimate is the same
+// whatever the number of workers, their speed or their failures.
+//
+// A worker that runs dry takes the back half of the largest range another
+// worker still has (work stealing); the other worker is told where its range
+// now ends. A worker that disconnects or goes silent has the rest of its
+// range handed out again. Runs flown twice count once.
+//
+// Like the other servers this binds to loopback: workers on other machines
+// reach it through a tunnel, e.g. ssh -R.
+
+const uint16_t COORDINATOR_DEFAULT_PORT = 47802;
+const uint32_t DISTRIBUTED_PROTOCOL_VERSION = 1;
+
+struct CoordinatorOptions {
+    CampaignOptions campaign;   // workers is ignored: the worker processes decide
+    uint16_t port = COORDINATOR_DEFAULT_PORT;
+    long rangeRuns = 256;       // Runs handed out at a time
+    float workerTimeout = 10.0f; // s of silence after which a worker's range is handed out again
+};
+
+// How the work got done
+struct CoordinatorStats {
+    bool listening = false;     // False if the port could not be opened
+    int workersSeen = 0;
+    int workersLost = 0;        // Disconnected or silent before the end
+    long steals = 0;            // Ranges split to feed an idle worker
+    long reassignedRuns = 0;    // Handed out again after their worker was lost
+    long duplicateRuns = 0;     // Flown again by a thief or a replacement, counted once
+};
+
+// Runs the campaign on whatever workers connect, waiting for them as long as
+// it takes
+CampaignResult RunCoordinator(const Scenario& scenario, const CoordinatorOptions& options, CoordinatorStats& stats);
+
+// Coordinates a campaign of the active scenario and prints it like --campaign
+int RunCoordinatorMode(const CoordinatorOptions& options);
+
+// Connects to a coordinator and flies what it hands out until it is done
+int RunCampaignWorker(uint16_t port);
+
+#endif
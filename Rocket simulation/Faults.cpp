@@ -0,0 +1,36 @@
+#include "Faults.h"
+#include "Random.h"
+#include <algorithm>
+
+const uint32_t FAULT_EVENT_CHANNEL = 0x200;      // Which faults strike, where and when
+const uint32_t FAULT_DISPERSION_CHANNEL = 0x201; // Thrust and Isp spreads
+
+static int PickEngine(float uniform) {
+    return std::min(static_cast<int>(uniform * SCENARIO_ENGINES), SCENARIO_ENGINES - 1);
+}
+
+FaultPlan DrawFaults(const Scenario& scenario, uint32_t run) {
+    FaultPlan plan;
+    float events[8], dispersions[8];
+    PhiloxUniforms(scenario.sensorSeed, FAULT_EVENT_CHANNEL, 0, 1, &run, events);
+    PhiloxUniforms(scenario.sensorSeed, FAULT_EVENT_CHANNEL, 1, 1, &run, events + 4);
+    PhiloxNormals(scenario.sensorSeed, FAULT_DISPERSION_CHANNEL, 0, 1, &run, dispersions);
+    PhiloxNormals(scenario.sensorSeed, FAULT_DISPERSION_CHANNEL, 1, 1, &run, dispersions + 4);
+
+    const float windowStart = scenario.faultWindow[0];
+    const float windowLength = scenario.faultWindow[1] - scenario.faultWindow[0];
+    if (events[0] < scenario.engineOutProbability) {
+        plan.engineOut = PickEngine(events[1]);
+        plan.engineOutTime = windowStart + windowLength * events[2];
+    }
+    if (events[3] < scenario.gimbalStuckProbability) {
+        plan.stuckGimbal = PickEngine(events[4]);
+        plan.stuckGimbalTime = windowStart + windowLength * events[5];
+    }
+
+    for (int i = 0; i < SCENARIO_ENGINES; i++) {
+        plan.thrustScale[i] = std::max(0.0f, 1.0f + scenario.thrustDispersion * dispersions[i]);
+    }
+    plan.fuelScale = 1.0f / std::max(0.1f, 1.0f + scenario.ispDispersion * dispersions[SCENARIO_ENGINES]);
+    return plan;
+}
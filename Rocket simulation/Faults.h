@@ -0,0 +1,24 @@
+#ifndef FAULTS_H
+#define FAULTS_H
+
+#include <cstdint>
+#include "Scenario.h"
+
+// Faults one flight carries. Dispersions apply from launch, engine-out and
+// the stuck gimbal at their time after liftoff. The default is a nominal
+// flight, which is what every flight outside a campaign flies.
+struct FaultPlan {
+    float thrustScale[SCENARIO_ENGINES] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f }; // Delivered over commanded
+    float fuelScale = 1.0f;         // Fuel per thrust over nominal, the inverse of the Isp ratio
+    int engineOut = -1;             // Engine that fails, -1 for none
+    float engineOutTime = 0.0f;     // s after liftoff
+    int stuckGimbal = -1;           // Engine whose gimbal freezes, -1 for none
+    float stuckGimbalTime = 0.0f;   // s after liftoff
+};
+
+// The faults of campaign run number run, from the scenario's fault model.
+// Counter-based like the sensor noise: the same run always draws the same
+// faults, whichever thread flies it and whatever ran before.
+FaultPlan DrawFaults(const Scenario& scenario, uint32_t run);
+
+#endif
@@ -0,0 +1,147 @@
+#include "Fleet.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+// Spread of low orbits: 300-1000 km, equatorial to sun-synchronous, every
+// second vehicle doing a one-minute prograde burn at the start
+template <typename FleetType>
+void AddOrbitVehicle(FleetType& fleet, size_t i, size_t vehicles) {
+    double fraction = vehicles > 1 ? double(i) / (vehicles - 1) : 0.0;
+    double radius = EARTH_EQUATORIAL_RADIUS + 300000.0 + 700000.0 * fraction;
+    double inclination = 98.0 * fraction * 0.017453292519943295;
+    double phase = 2.399963229728653 * i; // Golden angle, no two vehicles together
+    double speed = std::sqrt(EARTH_MU / radius);
+    glm::dvec3 position(radius * std::cos(phase), radius * std::sin(phase) * std::cos(inclination),
+        radius * std::sin(phase) * std::sin(inclination));
+    glm::dvec3 velocity(-speed * std::sin(phase), speed * std::cos(phase) * std::cos(inclination),
+        speed * std::cos(phase) * std::sin(inclination));
+    fleet.add(position, velocity, i % 2 == 0 ? 0.5 : 0.0, 60.0);
+}
+
+template <typename FleetType>
+void PopulateFleet(FleetType& fleet, int vehicles) {
+    fleet.reserve(static_cast<size_t>(vehicles));
+    for (int i = 0; i < vehicles; i++) AddOrbitVehicle(fleet, static_cast<size_t>(i), static_cast<size_t>(vehicles));
+}
+
+struct FleetRun {
+    double nsPerVehicleStep;
+    std::vector<glm::dvec3> positions;
+};
+
+template <typename Precision>
+FleetRun FlyFleet(int vehicles, long steps, float timeStep) {
+    Fleet<Precision> fleet;
+    PopulateFleet(fleet, vehicles);
+
+    auto start = std::chrono::steady_clock::now();
+    for (long step = 0; step < steps; step++) {
+        fleet.step(typename Precision::Derivative(timeStep));
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    FleetRun run;
+    run.nsPerVehicleStep = elapsed / (double(steps) * vehicles);
+    for (size_t i = 0; i < fleet.size(); i++) run.positions.push_back(fleet.position(i));
+    return run;
+}
+
+// ns per vehicle step of a partitioned fleet, timed after a warm-up step
+double TimePartitioned(PartitionedFleet<>& fleet, size_t vehicles, long steps) {
+    fleet.build(vehicles, [vehicles](size_t i, PartitionedFleet<>::Partition& partition) {
+        AddOrbitVehicle(partition, i, vehicles);
+    });
+    fleet.advance(1, 1.0f);
+    auto start = std::chrono::steady_clock::now();
+    fleet.advance(steps, 1.0f);
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / (double(steps) * vehicles);
+}
+
+template <typename Precision>
+void Report(const FleetRun& run, const FleetRun& reference) {
+    double worst = 0.0, sum = 0.0;
+    for (size_t i = 0; i < run.positions.size(); i++) {
+        double error = glm::length(run.positions[i] - reference.positions[i]);
+        worst = std::max(worst, error);
+        sum += error;
+    }
+    size_t bytes = 3 * sizeof(typename Precision::Position) + 5 * sizeof(typename Precision::Derivative);
+    std::cout << std::left << std::setw(8) << Precision::name() << std::right
+        << std::setw(10) << std::fixed << std::setprecision(2) << run.nsPerVehicleStep
+        << std::setw(10) << bytes
+        << std::setw(14) << std::setprecision(3) << sum / run.positions.size()
+        << std::setw(14) << worst << std::endl;
+}
+
+}
+
+int RunFleetBenchmark(int vehicles, float duration, float timeStep) {
+    if (vehicles <= 0 || !(duration > 0.0f) || !(timeStep > 0.0f)) {
+        std::cerr << "Fleet benchmark needs vehicles, a positive duration and a timestep" << std::endl;
+        return -1;
+    }
+    long steps = static_cast<long>(duration / timeStep);
+
+    // Same initial state and step in every precision, so the differences are
+    // rounding alone; double is the reference
+    FleetRun doubleRun = FlyFleet<DoublePrecision>(vehicles, steps, timeStep);
+    FleetRun mixedRun = FlyFleet<MixedPrecision>(vehicles, steps, timeStep);
+    FleetRun floatRun = FlyFleet<SinglePrecision>(vehicles, steps, timeStep);
+
+    std::cout << "Fleet of " << vehicles << " vehicles, J2 gravity, " << steps << " steps of "
+        << timeStep << " s" << std::endl;
+    std::cout << "state   ns/step  bytes/veh   mean err (m)   max err (m)" << std::endl;
+    Report<SinglePrecision>(floatRun, doubleRun);
+    Report<MixedPrecision>(mixedRun, doubleRun);
+    Report<DoublePrecision>(doubleRun, doubleRun);
+    return 0;
+}
+
+int RunFleetNumaBenchmark(int vehicles, long steps, int maxThreads) {
+    CpuTopology topology = DetectTopology();
+    if (maxThreads <= 0) maxThreads = topology.cpuCount();
+    if (vehicles <= 0 || steps <= 0) {
+        std::cerr << "NUMA fleet benchmark needs vehicles and steps" << std::endl;
+        return -1;
+    }
+    std::cout << "Fleet of " << vehicles << " vehicles, " << DefaultFleetPrecision::name() << " precision, "
+        << steps << " steps; " << topology.nodes.size() << " NUMA node(s):";
+    for (size_t node = 0; node < topology.nodes.size(); node++) {
+        std::cout << " node " << node << " has " << topology.nodes[node].size() << " CPU(s)"
+            << (node + 1 < topology.nodes.size() ? "," : "");
+    }
+    std::cout << std::endl;
+
+    // Doubling up to maxThreads, and maxThreads itself
+    std::vector<int> counts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) counts.push_back(threads);
+    counts.push_back(maxThreads);
+
+    std::cout << "threads   naive ns   placed ns   naive x   placed x   placed/naive" << std::endl;
+    double naiveOne = 0.0, placedOne = 0.0, worstDifference = 0.0;
+    for (int threads : counts) {
+        PartitionedFleet<> naive(threads, topology, false);
+        PartitionedFleet<> placed(threads, topology, true);
+        double naiveNs = TimePartitioned(naive, static_cast<size_t>(vehicles), steps);
+        double placedNs = TimePartitioned(placed, static_cast<size_t>(vehicles), steps);
+        if (threads == 1) {
+            naiveOne = naiveNs;
+            placedOne = placedNs;
+        }
+        for (size_t i = 0; i < naive.size(); i++) {
+            worstDifference = std::max(worstDifference, glm::length(naive.position(i) - placed.position(i)));
+        }
+        std::cout << std::setw(7) << threads << std::fixed << std::setprecision(3)
+            << std::setw(11) << naiveNs << std::setw(12) << placedNs << std::setprecision(2)
+            << std::setw(10) << naiveOne / naiveNs << std::setw(11) << placedOne / placedNs
+            << std::setw(15) << naiveNs / placedNs << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6) << "Largest naive-placed position difference: " << worstDifference << " m" << std::endl;
+    return 0;
+}
@@ -0,0 +1,211 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "Gravity.h"
+#include "Topology.h"
+#include <glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Precision policies for vehicle state. Position is what accumulates over a
+// long flight; Derivative is velocity, acceleration and everything computed
+// per step. float doubles the SIMD width but holds only ~0.5 m at orbital
+// radius; mixed keeps the position in double and does the per-step math in
+// float, which is where most of the width is.
+struct SinglePrecision {
+    typedef float Position;
+    typedef float Derivative;
+    static const char* name() { return "float"; }
+};
+
+struct MixedPrecision {
+    typedef double Position;
+    typedef float Derivative;
+    static const char* name() { return "mixed"; }
+};
+
+struct DoublePrecision {
+    typedef double Position;
+    typedef double Derivative;
+    static const char* name() { return "double"; }
+};
+
+// Precision a Fleet uses unless it asks for another: 0 float, 1 mixed, 2 double.
+// Only the fleet and its benchmarks are templated on it; campaigns, sweeps
+// and their process and distributed runs fly the float FlightState.
+#ifndef ROCKET_FLEET_PRECISION
+#define ROCKET_FLEET_PRECISION 1
+#endif
+
+#if ROCKET_FLEET_PRECISION == 0
+typedef SinglePrecision DefaultFleetPrecision;
+#elif ROCKET_FLEET_PRECISION == 1
+typedef MixedPrecision DefaultFleetPrecision;
+#else
+typedef DoublePrecision DefaultFleetPrecision;
+#endif
+
+// Many vehicles stepped together, one array per component so the step loop
+// vectorizes. Vehicles thrust prograde at a constant acceleration until
+// their burn time runs out, then coast. The gravity model is any policy from
+// Gravity.h, evaluated in Derivative precision.
+template <typename Precision = DefaultFleetPrecision, typename Gravity = J2Gravity>
+class Fleet {
+public:
+    typedef typename Precision::Position Position;
+    typedef typename Precision::Derivative Derivative;
+
+    explicit Fleet(const Gravity& gravity = Gravity()) : gravity(gravity) {}
+
+    size_t size() const { return x.size(); }
+
+    void reserve(size_t count) {
+        for (std::vector<Position>* component : { &x, &y, &z }) component->reserve(count);
+        for (std::vector<Derivative>* component : { &vx, &vy, &vz, &thrust, &burnLeft }) component->reserve(count);
+    }
+
+    // thrustAcceleration in m/s^2, burnTime in s
+    size_t add(const glm::dvec3& position, const glm::dvec3& velocity, double thrustAcceleration, double burnTime) {
+        x.push_back(Position(position.x));
+        y.push_back(Position(position.y));
+        z.push_back(Position(position.z));
+        vx.push_back(Derivative(velocity.x));
+        vy.push_back(Derivative(velocity.y));
+        vz.push_back(Derivative(velocity.z));
+        thrust.push_back(Derivative(thrustAcceleration));
+        burnLeft.push_back(Derivative(burnTime));
+        return x.size() - 1;
+    }
+
+    glm::dvec3 position(size_t i) const { return glm::dvec3(x[i], y[i], z[i]); }
+    glm::dvec3 velocity(size_t i) const { return glm::dvec3(vx[i], vy[i], vz[i]); }
+
+    // Semi-implicit Euler for every vehicle
+    void step(Derivative dt) {
+        StepVehicles(x.size(), x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data(),
+            thrust.data(), burnLeft.data(), gravity, dt);
+    }
+
+private:
+    // Branch-free over restrict parameters: with eight arrays the compiler
+    // gives up on runtime alias checks, so it has to be told they are distinct
+    static void StepVehicles(size_t count, Position* __restrict px, Position* __restrict py, Position* __restrict pz,
+        Derivative* __restrict dx, Derivative* __restrict dy, Derivative* __restrict dz,
+        Derivative* __restrict accel, Derivative* __restrict burn, const Gravity model, Derivative dt) {
+        for (size_t i = 0; i < count; i++) {
+            Derivative ax, ay, az;
+            model.accelerationAt(Derivative(px[i]), Derivative(py[i]), Derivative(pz[i]), ax, ay, az);
+
+            // Selects rather than branches, and the thrust is stored back
+            // unconditionally so its load may be hoisted out of the select. The
+            // floor on speed only matters at rest.
+            Derivative burning = burn[i] > Derivative(0) ? accel[i] : Derivative(0);
+            accel[i] = burning;
+            burn[i] -= dt;
+            Derivative speed = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i]);
+            Derivative prograde = burning / std::max(speed, Derivative(1e-3));
+
+            dx[i] += (ax + dx[i] * prograde) * dt;
+            dy[i] += (ay + dy[i] * prograde) * dt;
+            dz[i] += (az + dz[i] * prograde) * dt;
+            px[i] += Position(dx[i]) * Position(dt);
+            py[i] += Position(dy[i]) * Position(dt);
+            pz[i] += Position(dz[i]) * Position(dt);
+        }
+    }
+
+    Gravity gravity;
+    std::vector<Position> x, y, z;
+    std::vector<Derivative> vx, vy, vz;
+    std::vector<Derivative> thrust;     // m/s^2, zeroed when the burn ends
+    std::vector<Derivative> burnLeft;   // s of burn remaining, negative once coasting
+};
+
+// A fleet split into contiguous partitions, each stepped by a thread of its
+// own pinned to a CPU spread over the NUMA nodes (SpreadCpu). Placed, every
+// partition is allocated and filled by the thread that steps it, so first
+// touch puts its arrays on that thread's node and no step reaches across
+// sockets. Unplaced is the naive layout, for comparison: built on the calling
+// thread and stepped by unpinned threads. Vehicles never interact, so the
+// threads only meet at the end of advance().
+template <typename Precision = DefaultFleetPrecision, typename Gravity = J2Gravity>
+class PartitionedFleet {
+public:
+    typedef Fleet<Precision, Gravity> Partition;
+    typedef typename Precision::Derivative Derivative;
+
+    PartitionedFleet(int partitionCount, const CpuTopology& topology, bool placed = true, const Gravity& gravity = Gravity())
+        : partitions(static_cast<size_t>(std::max(1, partitionCount))), placed(placed), gravity(gravity) {
+        for (size_t p = 0; p < partitions.size(); p++) cpus.push_back(SpreadCpu(topology, static_cast<int>(p)));
+    }
+
+    size_t size() const { return firsts.empty() ? 0 : firsts.back(); }
+    int partitionCount() const { return static_cast<int>(partitions.size()); }
+    int cpuOf(int partition) const { return cpus[partition]; }
+
+    // Replaces the vehicles with count new ones, split evenly in index order;
+    // addVehicle(i, partition) adds vehicle i with Fleet::add
+    template <typename AddVehicle>
+    void build(size_t count, AddVehicle addVehicle) {
+        size_t partitionTotal = partitions.size();
+        firsts.assign(1, 0);
+        for (size_t p = 1; p <= partitionTotal; p++) firsts.push_back(count * p / partitionTotal);
+        auto fill = [&](size_t p) {
+            partitions[p].reset(new Partition(gravity));
+            partitions[p]->reserve(firsts[p + 1] - firsts[p]);
+            for (size_t i = firsts[p]; i < firsts[p + 1]; i++) addVehicle(i, *partitions[p]);
+        };
+        if (placed) {
+            onPartitions(fill);
+        }
+        else {
+            for (size_t p = 0; p < partitionTotal; p++) fill(p);
+        }
+    }
+
+    // steps semi-implicit Euler steps of every vehicle
+    void advance(long steps, Derivative dt) {
+        onPartitions([&](size_t p) {
+            for (long step = 0; step < steps; step++) partitions[p]->step(dt);
+        });
+    }
+
+    glm::dvec3 position(size_t i) const {
+        size_t p = std::upper_bound(firsts.begin(), firsts.end(), i) - firsts.begin() - 1;
+        return partitions[p]->position(i - firsts[p]);
+    }
+
+private:
+    // work(p) on a thread per partition, pinned to the partition's CPU if placed
+    template <typename Work>
+    void onPartitions(Work work) {
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < partitions.size(); p++) {
+            threads.emplace_back([this, &work, p] {
+                if (placed) PinThreadToCpu(cpus[p]);
+                work(p);
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    std::vector<std::unique_ptr<Partition> > partitions; // Each allocated by the thread that fills it
+    std::vector<size_t> firsts;         // First vehicle of each partition, then the total
+    std::vector<int> cpus;
+    bool placed;
+    Gravity gravity;
+};
+
+// Times one fleet step in every precision and reports how far the float and
+// mixed trajectories drift from the double one
+int RunFleetBenchmark(int vehicles, float duration, float timeStep);
+
+// Times a partitioned fleet at 1, 2, 4... threads up to maxThreads (0 = every
+// CPU), naive and placed, and reports the scaling of each
+int RunFleetNumaBenchmark(int vehicles, long steps, int maxThreads);
+
+#endif
@@ -0,0 +1,412 @@
+#include "Flight.h"
+#include "Gravity.h"
+#include "Instrumentation.h"
+#include "Kepler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+const double GROUND_CONTACT_TOLERANCE = 1.0e-3; // m
+
+void LaunchFlight(FlightState& flight, float currentTime) {
+    if (flight.isLiftoffInitiated) {
+        return;
+    }
+    StartCountdown(flight, currentTime);
+    std::cout << "Liftoff initiated, countdown started!" << std::endl;
+}
+
+void StartCountdown(FlightState& flight, float currentTime) {
+    flight.isLiftoffInitiated = true;
+    flight.isLiftoffComplete = false;
+    flight.hasLanded = false;
+    flight.liftoffStartTime = currentTime;
+    const Scenario& scenario = *flight.scenario;
+    flight.rocket = Rocket();      // Reset rocket state
+    flight.rocket.gravity = scenario.gravity;
+    flight.rocket.gimbalArm = scenario.gimbalArm;
+    flight.rocket.engineSpacing = scenario.engineSpacing;
+    flight.rocket.gyrationRadius = scenario.gyrationRadius;
+    flight.rocket.misalignmentPitch = scenario.misalignment[0] * 0.017453292519943295f;
+    flight.rocket.misalignmentYaw = scenario.misalignment[1] * 0.017453292519943295f;
+    for (size_t i = 0; i < flight.rocket.thrustFactor.size(); i++) flight.rocket.thrustFactor[i] = flight.faults.thrustScale[i];
+    flight.rocket.fuelFactor = flight.faults.fuelScale;
+    flight.control = ControllerState();
+    flight.sensors = SensorState();
+    flight.navigation.reset(scenario);
+    flight.fuelLevel = 100.0f;     // Reset fuel level
+    flight.currentMass = scenario.wetMass; // Reset mass
+    if (!flight.manualThrottle) {
+        for (size_t i = 0; i < flight.thrustLevels.size(); i++) flight.thrustLevels[i] = scenario.initialThrust[i];
+    }
+    flight.altitude = 0.0f;        // Reset altitude
+    flight.speed = 0.0f;           // Reset speed
+    flight.currentProgress = LOAD_FUEL;
+    if (scenario.gravityModel != GRAVITY_FLAT) {
+        // On the pad, turning with the Earth; ECI and ECEF coincide at liftoff
+        double flattening = scenario.gravityModel == GRAVITY_J2 ? EARTH_FLATTENING : 0.0;
+        flight.inertialPosition = GeodeticToEcef(scenario.launchLatitude, scenario.launchLongitude, 0.0,
+            EARTH_EQUATORIAL_RADIUS, flattening);
+        flight.inertialVelocity = SurfaceVelocity(flight.inertialPosition);
+    }
+}
+
+void AbortFlight(FlightState& flight) {
+    flight.isLiftoffInitiated = false;
+    flight.fuelLevel = 0.0f;
+    flight.currentProgress = LOAD_FUEL;
+}
+
+void SetThrottle(FlightState& flight, int engine, float percent) {
+    percent = percent > 100.0f ? 100.0f : (percent >= 0.0f ? percent : 0.0f); // NaN to 0
+    for (size_t i = 0; i < flight.thrustLevels.size(); i++) {
+        if (engine < 0 || static_cast<size_t>(engine) == i) flight.thrustLevels[i] = percent;
+    }
+    flight.manualThrottle = true;
+}
+
+void ReleaseThrottle(FlightState& flight) {
+    flight.manualThrottle = false;
+}
+
+Arena& StepArena() {
+    thread_local Arena arena(4 * 1024);
+    arena.reserve(); // On the first step rather than at the first event
+    return arena;
+}
+
+const char* FlightEventName(FlightEventType type) {
+    switch (type) {
+    case EVENT_LIFTOFF: return "Liftoff";
+    case EVENT_FUEL_DEPLETED: return "Fuel depleted";
+    case EVENT_GROUND_IMPACT: return "Ground impact";
+    case EVENT_ENGINE_OUT: return "Engine out";
+    case EVENT_GIMBAL_STUCK: return "Gimbal stuck";
+    default: return "?";
+    }
+}
+
+void LogFlightEvents(const FlightState& flight) {
+    for (const FlightEvent* event = flight.events; event != nullptr; event = event->next) {
+        if (event->type == EVENT_LIFTOFF) std::cout << "Liftoff complete!" << std::endl;
+        if (event->type == EVENT_GROUND_IMPACT) std::cout << "Ground impact at t=" << event->time << " s" << std::endl;
+        if (event->type == EVENT_ENGINE_OUT) std::cout << "Engine #" << flight.faults.engineOut + 1 << " out at t=" << event->time << " s" << std::endl;
+        if (event->type == EVENT_GIMBAL_STUCK) std::cout << "Engine #" << flight.faults.stuckGimbal + 1 << " gimbal stuck at t=" << event->time << " s" << std::endl;
+    }
+}
+
+// The flat model: the original float integration in Rocket, unchanged
+static void MoveVehicle(FlightState& flight, const FlatGravity&, float deltaTime) {
+    flight.rocket.applyThrust(flight.thrustLevels, deltaTime); // Apply thrust to all engines
+    flight.rocket.update(deltaTime);
+}
+
+// Altitude and climb rate relative to the turning surface, which is what
+// Rocket carries for the dashboard and telemetry on the round-Earth models
+static void ShowSurfaceRelative(FlightState& flight, const SurfaceFrame& frame) {
+    glm::dvec3 relativeVelocity = flight.inertialVelocity - SurfaceVelocity(flight.inertialPosition);
+    flight.rocket.position = glm::vec3(0.0f, static_cast<float>(frame.altitude), 0.0f);
+    flight.rocket.velocity = glm::vec3(0.0f, static_cast<float>(glm::dot(relativeVelocity, frame.up)), 0.0f);
+}
+
+// Round-Earth models integrate the double ECI state. Rocket::applyThrust still
+// owns the engines (its own tank, cut-off and attitude); the delta-v it adds
+// is applied in the local frame instead: y along the local vertical, x east
+// and z north. Rocket then carries altitude and climb rate relative to the
+// turning surface for the dashboard and telemetry.
+template <typename Gravity>
+static void MoveVehicle(FlightState& flight, const Gravity& gravity, float deltaTime) {
+    if (!(deltaTime > 0.0f) || !std::isfinite(deltaTime)) {
+        ROCKET_COUNT(INTEGRATOR_REJECTIONS);
+        return;
+    }
+    Rocket& rocket = flight.rocket;
+    rocket.velocity = glm::vec3(0.0f);
+    rocket.applyThrust(flight.thrustLevels, deltaTime);
+    glm::dvec3 thrustDeltaV(rocket.velocity.x, rocket.velocity.y, rocket.velocity.z);
+    double dt = deltaTime;
+    ROCKET_COUNT(PHYSICS_STEPS);
+    ROCKET_RECORD(STEP_DELTA_TIME_US, dt * 1.0e6);
+
+    // Semi-implicit Euler like Rocket::update: velocity first, then position
+    SurfaceFrame frame = gravity.surface(flight.inertialPosition);
+    glm::dvec3 east = glm::cross(glm::dvec3(0.0, 0.0, 1.0), frame.up);
+    double eastLength = glm::length(east);
+    east = eastLength > 1.0e-9 ? east / eastLength : glm::dvec3(0.0, 1.0, 0.0); // Any horizontal at the poles
+    glm::dvec3 north = glm::cross(frame.up, east);
+    glm::dvec3 thrust = frame.up * thrustDeltaV.y + east * thrustDeltaV.x + north * thrustDeltaV.z;
+    flight.inertialVelocity += thrust + gravity.acceleration(flight.inertialPosition) * dt;
+    flight.inertialPosition += flight.inertialVelocity * dt;
+
+    frame = gravity.surface(flight.inertialPosition);
+    if (frame.altitude < 0.0) {
+        // Back on the ground, turning with it
+        flight.inertialPosition -= frame.up * frame.altitude;
+        flight.inertialVelocity = SurfaceVelocity(flight.inertialPosition);
+        frame.altitude = 0.0;
+        ROCKET_COUNT(GROUND_CLAMPS);
+    }
+    ShowSurfaceRelative(flight, frame);
+}
+
+// Gravity along the local vertical where the filter thinks the vehicle is,
+// which its prediction uses in place of a constant g
+static double EstimatedGravity(const FlightState& flight, const FlatGravity&) {
+    return flight.rocket.gravity;
+}
+
+// The round-Earth models at the estimated altitude above the point under the
+// vehicle; the filter has no horizontal offset large enough to matter
+template <typename Gravity>
+static double EstimatedGravity(const FlightState& flight, const Gravity& gravity) {
+    SurfaceFrame frame = gravity.surface(flight.inertialPosition);
+    glm::dvec3 estimated = flight.inertialPosition + frame.up * (flight.navigation.state[NAV_Y] - frame.altitude);
+    return glm::dot(gravity.acceleration(estimated), frame.up);
+}
+
+static void RaiseEvent(FlightEvent**& tail, float time, FlightEventType type) {
+    FlightEvent* event = StepArena().create<FlightEvent>();
+    event->time = time;
+    event->type = type;
+    event->next = nullptr;
+    *tail = event;
+    tail = &event->next;
+}
+
+// The true state in sensor terms
+static SensorValues TrueSensorValues(const FlightState& flight) {
+    const Rocket& rocket = flight.rocket;
+    SensorValues truth;
+    truth.attitude[0] = rocket.pitch;
+    truth.attitude[1] = rocket.yaw;
+    truth.rate[0] = rocket.pitchRate;
+    truth.rate[1] = rocket.yawRate;
+    truth.acceleration[0] = flight.thrustAcceleration;
+    truth.position[0] = rocket.position.x;
+    truth.position[1] = rocket.position.y;
+    truth.position[2] = rocket.position.z;
+    truth.velocity[0] = rocket.velocity.x;
+    truth.velocity[1] = rocket.velocity.y;
+    truth.velocity[2] = rocket.velocity.z;
+    truth.altitude[0] = rocket.position.y;
+    return truth;
+}
+
+// One controller tick on what the vehicle estimates now. Every engine takes the
+// same gimbal command; the throttle command replaces the ramp only while the
+// scenario asks for a target acceleration and nobody holds the throttle.
+static void TickFlightController(FlightState& flight, float dt) {
+    Rocket& rocket = flight.rocket;
+    ControllerState& control = flight.control;
+    const NavigationFilter<double>& navigation = flight.navigation;
+    const SensorValues& sensed = flight.sensors.reading;
+    const ControlGains gains = ControlGainsFromScenario(*flight.scenario);
+    float thrustAcceleration = 0.0f;
+    for (float level : flight.thrustLevels) thrustAcceleration += level;
+    float pitch = static_cast<float>(navigation.state[NAV_PITCH]);
+    float yaw = static_cast<float>(navigation.state[NAV_YAW]);
+    float pitchRate = static_cast<float>(navigation.pitchRate(sensed));
+    float yawRate = static_cast<float>(navigation.yawRate(sensed));
+
+    TickControllers(gains, dt, 1, &pitch, &yaw, &pitchRate, &yawRate,
+        &thrustAcceleration, &sensed.acceleration[0], &flight.currentMass,
+        &control.pitchIntegral, &control.yawIntegral, &control.throttleIntegral,
+        &control.gimbalPitch, &control.gimbalYaw, &control.throttle);
+
+    for (size_t i = 0; i < rocket.gimbalStuck.size(); i++) {
+        if (rocket.gimbalStuck[i]) continue;
+        rocket.gimbalPitch[i] = control.gimbalPitch;
+        rocket.gimbalYaw[i] = control.gimbalYaw;
+    }
+    if (IsThrottleLoopClosed(flight)) flight.thrustLevels.fill(control.throttle);
+}
+
+// Engine-out and the stuck gimbal strike once their time after liftoff comes
+static void InjectFaults(FlightState& flight, float currentTime, FlightEvent**& tail) {
+    const FaultPlan& faults = flight.faults;
+    Rocket& rocket = flight.rocket;
+    float sinceLiftoff = currentTime - flight.liftoffStartTime - flight.scenario->countdown;
+    if (faults.engineOut >= 0 && rocket.thrustFactor[faults.engineOut] != 0.0f && sinceLiftoff >= faults.engineOutTime) {
+        rocket.thrustFactor[faults.engineOut] = 0.0f;
+        RaiseEvent(tail, currentTime, EVENT_ENGINE_OUT);
+    }
+    if (faults.stuckGimbal >= 0 && !rocket.gimbalStuck[faults.stuckGimbal] && sinceLiftoff >= faults.stuckGimbalTime) {
+        rocket.gimbalStuck[faults.stuckGimbal] = true;
+        RaiseEvent(tail, currentTime, EVENT_GIMBAL_STUCK);
+    }
+}
+
+// First moment within a drift of the given length that the vehicle touches
+// the model's surface, or infinity if it stays clear. The ellipsoid lies
+// inside the sphere of its equatorial radius, so the crossing of that sphere
+// (exact for the spherical model) brackets the contact from below.
+template <typename Gravity>
+static double GroundContact(const Gravity& gravity, const glm::dvec3& position, const glm::dvec3& velocity, double drift) {
+    double low = TimeToRadius(gravity.mu, position, velocity, gravity.radius);
+    if (low > drift) return std::numeric_limits<double>::infinity();
+
+    auto altitudeAt = [&](double t) {
+        glm::dvec3 p = position, v = velocity;
+        PropagateKepler(gravity.mu, p, v, t);
+        return gravity.surface(p).altitude;
+    };
+    if (altitudeAt(low) <= GROUND_CONTACT_TOLERANCE) return low;
+    double high = drift;
+    if (altitudeAt(high) > 0.0) return std::numeric_limits<double>::infinity();
+    for (int i = 0; i < 64 && high - low > 1.0e-6; i++) {
+        double middle = 0.5 * (low + high);
+        if (altitudeAt(middle) > 0.0) low = middle;
+        else high = middle;
+    }
+    return high;
+}
+
+// Unpowered flight: Kepler drifts with the model's perturbation applied as a
+// half kick either side (kick-drift-kick, symplectic). The point mass is
+// exact whatever the step, so only the perturbation bounds a drift, to
+// Gravity::coastStep(), and a whole coast can be crossed in one call.
+template <typename Gravity>
+static void CoastVehicle(FlightState& flight, const Gravity& gravity, float startTime, float deltaTime, FlightEvent**& tail) {
+    if (!(deltaTime > 0.0f) || !std::isfinite(deltaTime)) {
+        ROCKET_COUNT(INTEGRATOR_REJECTIONS);
+        return;
+    }
+    glm::dvec3& position = flight.inertialPosition;
+    glm::dvec3& velocity = flight.inertialVelocity;
+    double elapsed = 0.0;
+    while (elapsed < deltaTime) {
+        double drift = deltaTime - elapsed;
+        if (Gravity::coastStep() > 0.0) drift = std::min(drift, Gravity::coastStep());
+        ROCKET_COUNT(KEPLER_DRIFTS);
+
+        velocity += gravity.perturbation(position) * (0.5 * drift);
+        double contact = GroundContact(gravity, position, velocity, drift);
+        if (contact <= drift) {
+            // Down: stop on the surface and turn with it from here on
+            PropagateKepler(gravity.mu, position, velocity, contact);
+            SurfaceFrame frame = gravity.surface(position);
+            position -= frame.up * frame.altitude;
+            velocity = SurfaceVelocity(position);
+            flight.hasLanded = true;
+            RaiseEvent(tail, startTime + static_cast<float>(elapsed + contact), EVENT_GROUND_IMPACT);
+            break;
+        }
+        PropagateKepler(gravity.mu, position, velocity, drift);
+        velocity += gravity.perturbation(position) * (0.5 * drift);
+        elapsed += drift;
+    }
+    ShowSurfaceRelative(flight, gravity.surface(position));
+}
+
+void UpdateFlight(FlightState& flight, float currentTime, float deltaTime) {
+    const Scenario& scenario = *flight.scenario;
+    StepArena().reset();
+    flight.events = nullptr;
+    FlightEvent** eventTail = &flight.events;
+
+    // Liftoff countdown logic
+    if (flight.isLiftoffInitiated && !flight.isLiftoffComplete) {
+        flight.currentProgress = COUNTDOWN;
+        if (currentTime - flight.liftoffStartTime >= scenario.countdown) {
+            flight.isLiftoffComplete = true;
+            flight.currentProgress = LIFTOFF;
+            RaiseEvent(eventTail, currentTime, EVENT_LIFTOFF);
+        }
+    }
+
+    // Apply thrust if liftoff is complete and fuel is available
+    if (flight.isLiftoffComplete && flight.fuelLevel > 0.0f) {
+        Rocket& rocket = flight.rocket;
+        InjectFaults(flight, currentTime, eventTail);
+        UpdateSensors(flight.sensors, scenario, flight.vehicle, TrueSensorValues(flight), deltaTime);
+        flight.navigation.correct(scenario, flight.sensors.reading, flight.sensors.fresh);
+
+        // Flight control ticks at its own rate and the engines hold its
+        // commands in between. Ticks falling inside one long physics step
+        // merge into a single tick over their combined time.
+        if (scenario.controlRate > 0.0f) {
+            float period = 1.0f / scenario.controlRate;
+            flight.control.clock += deltaTime;
+            if (flight.control.clock >= period) {
+                float elapsed = std::floor(flight.control.clock / period) * period;
+                flight.control.clock -= elapsed;
+                TickFlightController(flight, elapsed);
+            }
+        }
+
+        // The thrust the engines deliver this step, which is what the filter
+        // predicts with; Rocket stops them once its own tank runs dry
+        float deliveredThrust = 0.0f;
+        if (rocket.fuel > 0.0f) {
+            for (float level : flight.thrustLevels) deliveredThrust += level;
+        }
+
+        // One instantiation per model, picked once per step
+        double gravity = 0.0;
+        switch (scenario.gravityModel) {
+        case GRAVITY_INVERSE_SQUARE:
+            MoveVehicle(flight, InverseSquareGravity(), deltaTime);
+            gravity = EstimatedGravity(flight, InverseSquareGravity());
+            break;
+        case GRAVITY_J2:
+            MoveVehicle(flight, J2Gravity(), deltaTime);
+            gravity = EstimatedGravity(flight, J2Gravity());
+            break;
+        default:
+            MoveVehicle(flight, FlatGravity{ scenario.gravity }, deltaTime);
+            gravity = EstimatedGravity(flight, FlatGravity{ scenario.gravity });
+            break;
+        }
+        flight.currentProgress = START_ENGINES;
+        flight.navigation.predict(scenario, flight.sensors.reading, deliveredThrust, gravity, deltaTime);
+
+        // Update fuel level based on the thrust delivered and decrease mass accordingly
+        const std::array<float, 5>& thrustLevels = flight.thrustLevels;
+        const std::array<float, 5>& factor = rocket.thrustFactor;
+        float totalThrust = thrustLevels[0] * factor[0] + thrustLevels[1] * factor[1] + thrustLevels[2] * factor[2]
+            + thrustLevels[3] * factor[3] + thrustLevels[4] * factor[4];
+        float fuelConsumption = PropellantBurned(totalThrust, scenario.fuelPerThrust, rocket.fuelFactor, deltaTime);
+        flight.fuelLevel -= fuelConsumption;
+        if (flight.fuelLevel <= 0.0f) {
+            flight.fuelLevel = 0.0f;
+            RaiseEvent(eventTail, currentTime, EVENT_FUEL_DEPLETED);
+        }
+
+        // Update the mass of the rocket as fuel burns
+        flight.currentMass = VehicleMass(scenario.dryMass, scenario.wetMass, flight.fuelLevel);
+
+        // Calculate acceleration based on thrust and current mass
+        flight.thrustAcceleration = deliveredThrust > 0.0f ? totalThrust / flight.currentMass : 0.0f;
+        flight.acceleration = flight.thrustAcceleration;
+
+        // Clamp acceleration to maximum value for visual representation
+        if (flight.acceleration > scenario.maxAcceleration) flight.acceleration = scenario.maxAcceleration;
+
+        // Update altitude and speed
+        flight.altitude = rocket.position.y;
+        flight.speed = rocket.velocity.y;
+
+        // Ensure the altitude bar fills up to the maximum defined value
+        if (flight.altitude > scenario.rampAltitude) flight.altitude = scenario.rampAltitude;
+
+        // Dynamically adjust thrust levels based on the estimated altitude
+        float sensedAltitude = static_cast<float>(flight.navigation.state[NAV_Y]);
+        for (size_t i = 0; i < flight.thrustLevels.size() && !flight.manualThrottle && !IsThrottleLoopClosed(flight); i++) {
+            flight.thrustLevels[i] = RampThrustLevel(scenario.rampBase, scenario.rampGain, sensedAltitude, scenario.rampAltitude);
+        }
+    }
+    else if (IsFlightCoasting(flight)) {
+        float startTime = currentTime - deltaTime;
+        switch (scenario.gravityModel) {
+        case GRAVITY_INVERSE_SQUARE: CoastVehicle(flight, InverseSquareGravity(), startTime, deltaTime, eventTail); break;
+        case GRAVITY_J2: CoastVehicle(flight, J2Gravity(), startTime, deltaTime, eventTail); break;
+        default: break;
+        }
+        flight.acceleration = 0.0f;
+        flight.thrustAcceleration = 0.0f;
+        flight.altitude = std::min(flight.rocket.position.y, scenario.rampAltitude);
+        flight.speed = flight.rocket.velocity.y;
+        UpdateSensors(flight.sensors, scenario, flight.vehicle, TrueSensorValues(flight), deltaTime);
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef FLIGHT_H
+#define FLIGHT_H
+
+#include <array>
+#include "Control.h"
+#include "Faults.h"
+#include "Gravity.h"
+#include "Rocket.h"
+#include "Memory.h"
+#include "Navigation.h"
+#include "Scenario.h"
+#include "Sensors.h"
+
+// Progress state variables
+enum ProgressState { LOAD_FUEL, COUNTDOWN, START_ENGINES, LIFTOFF };
+
+enum FlightEventType { EVENT_LIFTOFF, EVENT_FUEL_DEPLETED, EVENT_GROUND_IMPACT, EVENT_ENGINE_OUT, EVENT_GIMBAL_STUCK };
+
+// Something that happened during one UpdateFlight call. Events are allocated
+// from the calling thread's step arena and are only valid until that thread's
+// next UpdateFlight.
+struct FlightEvent {
+    float time;
+    FlightEventType type;
+    FlightEvent* next;
+};
+
+// Everything one flight needs: the vehicle plus the launch sequence and the
+// derived values shown on the dashboard. The GUI owns one of these, the
+// headless runner creates its own.
+struct FlightState {
+    const Scenario* scenario = &ActiveScenario(); // Vehicle and sequence, shared and never modified
+    Rocket rocket;               // Flat model state; altitude and climb rate for the round-Earth models
+    glm::dvec3 inertialPosition = glm::dvec3(0.0); // ECI (m), round-Earth gravity models only
+    glm::dvec3 inertialVelocity = glm::dvec3(0.0); // ECI (m/s)
+    float fuelLevel = 100.0f;    // Full fuel (100%)
+    float altitude = 0.0f;       // Starting altitude
+    float speed = 0.0f;          // Rocket speed (m/s)
+    float acceleration = 0.0f;   // Rocket acceleration (m/s^2), clamped to the bar's full scale
+    float thrustAcceleration = 0.0f; // Unclamped, from the thrust delivered last step; what the accelerometer measures
+    float currentMass = scenario->wetMass;
+    std::array<float, 5> thrustLevels = { 100.0f, 100.0f, 100.0f, 100.0f, 100.0f }; // Initial thrust for 5 engines
+    bool manualThrottle = false; // Thrust set by SetThrottle instead of the altitude ramp
+    ControllerState control;     // Gimbal and throttle loops, ticking at scenario->controlRate
+    SensorState sensors;         // Readings of the true state
+    NavigationFilter<double> navigation; // Estimate from the readings; the control loops and the thrust ramp fly on it
+    uint32_t vehicle = 0;        // Sensor noise stream; give each flight of a campaign its own
+    FaultPlan faults;            // Injected at launch and at their times; nominal outside campaigns
+
+    bool isLiftoffInitiated = false;
+    bool isLiftoffComplete = false;
+    bool hasLanded = false;      // Came back down after the engines stopped; round-Earth models only
+    float liftoffStartTime = 0.0f;
+    ProgressState currentProgress = LOAD_FUEL;
+
+    FlightEvent* events = nullptr; // Raised by the last UpdateFlight, oldest first
+};
+
+// The flight's own bookkeeping around Rocket's step, templated on the scalar
+// type like the step itself (RocketDynamics.h) so the sensitivity analysis
+// follows the same formulas.
+
+// Thrust % per engine the altitude ramp asks for
+template <typename T>
+T RampThrustLevel(T base, T gain, T altitude, T rampAltitude) {
+    return base + gain * (altitude / rampAltitude);
+}
+
+// Highest point of the climb from here on over flat ground, where nothing
+// but constant gravity acts once the engines stop
+template <typename T>
+T FlatCoastApogee(T altitude, T climbRate, T gravity) {
+    T climb = climbRate > T(0.0f) ? climbRate : T(0.0f);
+    return altitude + climb * climb / (T(-2.0f) * gravity);
+}
+
+// Propellant (% of the load) the delivered thrust burns in deltaTime
+template <typename T>
+T PropellantBurned(T totalThrust, T fuelPerThrust, T fuelFactor, T deltaTime) {
+    return totalThrust * fuelPerThrust * fuelFactor * deltaTime;
+}
+
+// Dry mass plus the remaining propellant
+template <typename T>
+T VehicleMass(T dryMass, T wetMass, T fuelLevel) {
+    return dryMass + (fuelLevel / T(100.0f)) * (wetMass - dryMass);
+}
+
+// Reset the vehicle and start the countdown at currentTime
+void LaunchFlight(FlightState& flight, float currentTime);
+
+// LaunchFlight without the console message and regardless of a launch in
+// progress, for runs that must not print, e.g. campaign workers
+void StartCountdown(FlightState& flight, float currentTime);
+
+// Stop the launch sequence and dump the remaining fuel
+void AbortFlight(FlightState& flight);
+
+// Hold one engine (0-4), or all of them with engine -1, at percent thrust
+// until ReleaseThrottle hands control back to the altitude ramp. percent is
+// clamped to 0-100, NaN to 0.
+void SetThrottle(FlightState& flight, int engine, float percent);
+void ReleaseThrottle(FlightState& flight);
+
+// The throttle loop holds the acceleration instead of the ramp
+inline bool IsThrottleLoopClosed(const FlightState& flight) {
+    return flight.scenario->controlRate > 0.0f && flight.scenario->targetAcceleration > 0.0f && !flight.manualThrottle;
+}
+
+// Engines out on a round-Earth model and not back on the ground yet. The
+// vehicle then follows its orbit in closed form, so one UpdateFlight may
+// cover any length of time; it stops at ground contact by itself.
+inline bool IsFlightCoasting(const FlightState& flight) {
+    return flight.isLiftoffInitiated && flight.isLiftoffComplete && flight.fuelLevel <= 0.0f
+        && !flight.hasLanded && flight.scenario->gravityModel != GRAVITY_FLAT;
+}
+
+// True while the countdown runs, the engines burn or the vehicle coasts, i.e.
+// while the flight state changes on its own from one frame to the next
+inline bool IsFlightActive(const FlightState& flight) {
+    return flight.isLiftoffInitiated && (!(flight.isLiftoffComplete && flight.fuelLevel <= 0.0f) || IsFlightCoasting(flight));
+}
+
+// Per-thread scratch for one physics step, rewound at the start of every UpdateFlight
+Arena& StepArena();
+
+const char* FlightEventName(FlightEventType type);
+
+// Prints the last step's events to stdout. Kept out of UpdateFlight so a
+// step does no I/O; callers log once the step is done.
+void LogFlightEvents(const FlightState& flight);
+
+// Advance the countdown and, after liftoff, the physics by deltaTime. Takes no
+// locks, does no I/O and, once the step arena is warm, never allocates, so it
+// can run under the real-time loop.
+void UpdateFlight(FlightState& flight, float currentTime, float deltaTime);
+
+#endif
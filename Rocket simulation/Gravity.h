@@ -0,0 +1,172 @@
+#ifndef GRAVITY_H
+#define GRAVITY_H
+
+#include <glm.hpp>
+#include <cmath>
+
+// Gravity models as policy types. The step code is a template over the model,
+// so each instantiation inlines its own field and nothing is decided per
+// evaluation. The flat model keeps the original float Rocket path; the
+// round-Earth models integrate a double-precision state in an Earth-centred
+// inertial frame (ECI: z through the north pole, x through Greenwich at
+// liftoff), because float cannot hold centimetres at 6378 km.
+//
+// Each round-Earth model provides
+//   glm::dvec3 acceleration(const glm::dvec3& position) const;   // m/s^2, ECI
+//   SurfaceFrame surface(const glm::dvec3& position) const;      // altitude and local up
+//   template <typename T> void accelerationAt(T x, T y, T z, T& ax, T& ay, T& az) const;
+//   glm::dvec3 perturbation(const glm::dvec3& position) const;   // beyond the point mass
+//   static double coastStep();                                    // longest Kepler drift, 0 for any
+// accelerationAt in any precision, for the structure-of-arrays fleet. The
+// last two drive the coast: Kepler drifts with the perturbation as kicks.
+
+enum GravityModel {
+    GRAVITY_FLAT,           // Constant g along y over a flat ground plane
+    GRAVITY_INVERSE_SQUARE, // Point-mass Earth, spherical surface
+    GRAVITY_J2              // Oblate Earth: point mass plus J2, WGS-84 ellipsoid surface
+};
+
+// WGS-84 / EGM96 values
+const double EARTH_MU = 3.986004418e14;             // m^3/s^2
+const double EARTH_EQUATORIAL_RADIUS = 6378137.0;   // m
+const double EARTH_FLATTENING = 1.0 / 298.257223563;
+const double EARTH_J2 = 1.08262668e-3;
+const double EARTH_ROTATION_RATE = 7.2921159e-5;    // rad/s
+
+struct SurfaceFrame {
+    double altitude;    // m above the model's surface
+    glm::dvec3 up;      // Unit local vertical, the thrust direction
+};
+
+// The original model, integrated in float by Rocket::update
+struct FlatGravity {
+    float g;
+
+    template <typename T>
+    void accelerationAt(T, T, T, T& ax, T& ay, T& az) const {
+        ax = T(0);
+        ay = T(g);
+        az = T(0);
+    }
+};
+
+struct InverseSquareGravity {
+    double mu = EARTH_MU;
+    double radius = EARTH_EQUATORIAL_RADIUS;
+
+    template <typename T>
+    void accelerationAt(T x, T y, T z, T& ax, T& ay, T& az) const {
+        T r2 = x * x + y * y + z * z;
+        T scale = T(-mu) / (r2 * std::sqrt(r2));
+        ax = x * scale;
+        ay = y * scale;
+        az = z * scale;
+    }
+
+    glm::dvec3 acceleration(const glm::dvec3& position) const {
+        glm::dvec3 result;
+        accelerationAt(position.x, position.y, position.z, result.x, result.y, result.z);
+        return result;
+    }
+
+    // Pure point mass: the Kepler drift is the whole answer
+    glm::dvec3 perturbation(const glm::dvec3&) const { return glm::dvec3(0.0); }
+    static double coastStep() { return 0.0; }
+
+    SurfaceFrame surface(const glm::dvec3& position) const {
+        double r = glm::length(position);
+        return { r - radius, position / r };
+    }
+};
+
+struct J2Gravity {
+    double mu = EARTH_MU;
+    double radius = EARTH_EQUATORIAL_RADIUS;
+    double j2 = EARTH_J2;
+    double flattening = EARTH_FLATTENING;
+
+    template <typename T>
+    void accelerationAt(T x, T y, T z, T& ax, T& ay, T& az) const {
+        T r2 = x * x + y * y + z * z;
+        T r = std::sqrt(r2);
+        T z2OverR2 = z * z / r2;
+        T pointMass = T(-mu) / (r2 * r);
+        T oblateness = T(-1.5 * j2 * mu * radius * radius) / (r2 * r2 * r);
+        T equatorial = pointMass + oblateness * (T(1) - T(5) * z2OverR2);
+        ax = x * equatorial;
+        ay = y * equatorial;
+        az = z * (pointMass + oblateness * (T(3) - T(5) * z2OverR2));
+    }
+
+    glm::dvec3 acceleration(const glm::dvec3& position) const {
+        glm::dvec3 result;
+        accelerationAt(position.x, position.y, position.z, result.x, result.y, result.z);
+        return result;
+    }
+
+    glm::dvec3 perturbation(const glm::dvec3& position) const {
+        double r2 = glm::dot(position, position);
+        double z2OverR2 = position.z * position.z / r2;
+        double oblateness = -1.5 * j2 * mu * radius * radius / (r2 * r2 * std::sqrt(r2));
+        return glm::dvec3(
+            position.x * oblateness * (1.0 - 5.0 * z2OverR2),
+            position.y * oblateness * (1.0 - 5.0 * z2OverR2),
+            position.z * oblateness * (3.0 - 5.0 * z2OverR2));
+    }
+
+    // Kick-drift-kick error grows with the square of this: 10 s stays within
+    // a few metres per low orbit of a fine RK4 reference
+    static double coastStep() { return 10.0; }
+
+    // Geodetic height and ellipsoid normal. Both are independent of longitude,
+    // so ECI works as well as ECEF here. Three fixed-point iterations reach
+    // well below a millimetre in the atmosphere and low orbit.
+    SurfaceFrame surface(const glm::dvec3& position) const {
+        double e2 = flattening * (2.0 - flattening);
+        double p = std::sqrt(position.x * position.x + position.y * position.y);
+        double latitude = std::atan2(position.z, p * (1.0 - e2));
+        double height = 0.0;
+        for (int i = 0; i < 3; i++) {
+            double sinLatitude = std::sin(latitude);
+            double n = radius / std::sqrt(1.0 - e2 * sinLatitude * sinLatitude);
+            height = p * std::cos(latitude) + position.z * sinLatitude - radius * std::sqrt(1.0 - e2 * sinLatitude * sinLatitude);
+            latitude = std::atan2(position.z, p * (1.0 - e2 * n / (n + height)));
+        }
+        double cosLatitude = std::cos(latitude);
+        glm::dvec3 up = p > 0.0
+            ? glm::dvec3(cosLatitude * position.x / p, cosLatitude * position.y / p, std::sin(latitude))
+            : glm::dvec3(0.0, 0.0, position.z >= 0.0 ? 1.0 : -1.0);
+        return { height, up };
+    }
+};
+
+// Launch site on the WGS-84 ellipsoid (or a sphere with flattening 0), ECEF
+inline glm::dvec3 GeodeticToEcef(double latitudeDeg, double longitudeDeg, double height,
+    double radius = EARTH_EQUATORIAL_RADIUS, double flattening = EARTH_FLATTENING) {
+    double latitude = latitudeDeg * 0.017453292519943295;
+    double longitude = longitudeDeg * 0.017453292519943295;
+    double e2 = flattening * (2.0 - flattening);
+    double n = radius / std::sqrt(1.0 - e2 * std::sin(latitude) * std::sin(latitude));
+    return glm::dvec3(
+        (n + height) * std::cos(latitude) * std::cos(longitude),
+        (n + height) * std::cos(latitude) * std::sin(longitude),
+        (n * (1.0 - e2) + height) * std::sin(latitude));
+}
+
+// ECI and ECEF coincide at liftoff; the Earth has turned by rate * t since
+inline glm::dvec3 EcefToEci(const glm::dvec3& ecef, double secondsSinceLiftoff) {
+    double angle = EARTH_ROTATION_RATE * secondsSinceLiftoff;
+    double c = std::cos(angle), s = std::sin(angle);
+    return glm::dvec3(c * ecef.x - s * ecef.y, s * ecef.x + c * ecef.y, ecef.z);
+}
+
+inline glm::dvec3 EciToEcef(const glm::dvec3& eci, double secondsSinceLiftoff) {
+    return EcefToEci(eci, -secondsSinceLiftoff);
+}
+
+// Inertial velocity of a point fixed to the rotating Earth
+inline glm::dvec3 SurfaceVelocity(const glm::dvec3& position) {
+    return glm::dvec3(-EARTH_ROTATION_RATE * position.y, EARTH_ROTATION_RATE * position.x, 0.0);
+}
+
+#endif
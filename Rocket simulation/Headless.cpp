@@ -0,0 +1,293 @@
+#include "Headless.h"
+#include "Campaign.h"
+#include "CommandServer.h"
+#include "Control.h"
+#include "Distributed.h"
+#include "Fleet.h"
+#include "Flight.h"
+#include "Instrumentation.h"
+#include "Navigation.h"
+#include "Offscreen.h"
+#include "ProcessCampaign.h"
+#include "RealTime.h"
+#include "Scenario.h"
+#include "Sensitivity.h"
+#include "Sensors.h"
+#include "SharedState.h"
+#include "Sweep.h"
+#include "TelemetryServer.h"
+#include "Viewport.h"
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+static void PrintUsage() {
+    std::cout << "Usage: RocketSimulation [--scenario <file>] [--shm-name <name>] [mode]" << std::endl;
+    std::cout << "       RocketSimulation --headless [seconds] [timestep]" << std::endl;
+    std::cout << "       RocketSimulation --render-frames <dir> [seconds] [interval] [workers]" << std::endl;
+    std::cout << "       RocketSimulation --watch-state [seconds]" << std::endl;
+    std::cout << "       RocketSimulation --telemetry-server [seconds] [steps-per-second] [port]" << std::endl;
+    std::cout << "       RocketSimulation --telemetry-client [seconds] [tcp|udp] [port]" << std::endl;
+    std::cout << "       RocketSimulation --serve-commands [seconds, 0 until quit] [timestep] [port]" << std::endl;
+    std::cout << "       RocketSimulation --realtime [seconds] [steps-per-second] [cpu] [fifo]" << std::endl;
+    std::cout << "       RocketSimulation --benchmark-fleet [vehicles] [seconds] [timestep]" << std::endl;
+    std::cout << "       RocketSimulation --benchmark-fleet-numa [vehicles] [steps] [max-threads]" << std::endl;
+    std::cout << "       RocketSimulation --benchmark-viewport [trail-points] [vehicles] [trajectories] [points-each] [frames]" << std::endl;
+    std::cout << "       RocketSimulation --benchmark-control [vehicles] [ticks]" << std::endl;
+    std::cout << "       RocketSimulation --benchmark-sensors [vehicles] [samples]" << std::endl;
+    std::cout << "       RocketSimulation --benchmark-navigation [vehicles] [seconds] [timestep]" << std::endl;
+    std::cout << "       RocketSimulation --campaign [max-runs] [half-width, 0 runs all] [workers] [pin]" << std::endl;
+    std::cout << "       RocketSimulation --campaign-processes [max-runs] [half-width, 0 runs all] [processes]" << std::endl;
+    std::cout << "       RocketSimulation --coordinate [max-runs] [half-width, 0 runs all] [port]" << std::endl;
+    std::cout << "       RocketSimulation --campaign-worker [port]" << std::endl;
+    std::cout << "       RocketSimulation --sensitivity [timestep] [target-apogee]" << std::endl;
+    std::cout << "       RocketSimulation --sweep <key>=<first>:<last>:<count>... [cache-file]" << std::endl;
+    std::cout << "       RocketSimulation --compile-scenario <scenario.json> <scenario.bin>" << std::endl;
+}
+
+int RunHeadless(const HeadlessOptions& options) {
+    if (!(options.duration > 0.0f) || !(options.timeStep > 0.0f)) {
+        std::cerr << "Headless run needs a positive duration and timestep" << std::endl;
+        return -1;
+    }
+
+    Instrumentation::reset();
+
+    FlightState flight;
+    LaunchFlight(flight, 0.0f);
+
+    long steps = static_cast<long>(options.duration / options.timeStep);
+    long updates = 0;
+    for (long step = 1; step <= steps; step++, updates++) {
+        if (IsFlightCoasting(flight)) {
+            // Nothing left to decide on the way: one update to the end, which
+            // stops early at ground contact
+            UpdateFlight(flight, steps * options.timeStep, (steps - step + 1) * options.timeStep);
+            LogFlightEvents(flight);
+            updates++;
+            break;
+        }
+        UpdateFlight(flight, step * options.timeStep, options.timeStep);
+        LogFlightEvents(flight);
+    }
+
+    std::cout << "Simulated " << steps * options.timeStep << " s in " << updates << " steps" << std::endl;
+    std::cout << "Altitude: " << flight.rocket.position.y << " m" << std::endl;
+    std::cout << "Speed: " << flight.rocket.velocity.y << " m/s" << std::endl;
+    std::cout << "Fuel: " << flight.fuelLevel << " %" << std::endl;
+    Instrumentation::writeReport(std::cout);
+    return 0;
+}
+
+int WatchSharedState(float duration) {
+    SharedStateBlock* block = OpenSharedState(SharedStateName());
+    if (block == nullptr || !IsSharedStateValid(*block)) {
+        std::cerr << "No simulation is publishing " << SharedStateName() << std::endl;
+        CloseSharedState(block);
+        return -1;
+    }
+
+    // Polls ten times a second and prints whenever the writer moved on
+    uint64_t lastStep = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<float>(duration);
+    while (std::chrono::steady_clock::now() < end) {
+        SharedStateSample sample;
+        if (ReadSharedState(*block, sample) && sample.step != lastStep) {
+            lastStep = sample.step;
+            std::cout << "t=" << sample.time << " s  step " << sample.step << "  altitude " << sample.position[1]
+                << " m  speed " << sample.velocity[1] << " m/s  fuel " << sample.fuelLevel << " %" << std::endl;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    CloseSharedState(block);
+    return 0;
+}
+
+bool RunCommandLineMode(int argc, char** argv, int& exitCode, const DashboardHooks& dashboard) {
+    // Apply to every mode and the GUI, so they are consumed before the mode is picked
+    while (argc > 2 && (std::strcmp(argv[1], "--scenario") == 0 || std::strcmp(argv[1], "--shm-name") == 0)) {
+        if (std::strcmp(argv[1], "--shm-name") == 0) {
+            SetSharedStateName(argv[2]);
+        }
+        else {
+            Scenario scenario;
+            if (!LoadScenario(argv[2], scenario)) {
+                exitCode = -1;
+                return true;
+            }
+            SetActiveScenario(scenario);
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc < 2) {
+        return false;
+    }
+
+    if (std::strcmp(argv[1], "--headless") == 0) {
+        HeadlessOptions options;
+        if (argc > 2) options.duration = static_cast<float>(std::atof(argv[2]));
+        if (argc > 3) options.timeStep = static_cast<float>(std::atof(argv[3]));
+        exitCode = RunHeadless(options);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--render-frames") == 0 && argc > 2) {
+        OffscreenOptions options;
+        options.outputDir = argv[2];
+        if (argc > 3) options.duration = static_cast<float>(std::atof(argv[3]));
+        if (argc > 4) options.frameInterval = static_cast<float>(std::atof(argv[4]));
+        if (argc > 5) options.workers = std::atoi(argv[5]);
+        exitCode = RunOffscreenRender(options, dashboard);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--watch-state") == 0) {
+        exitCode = WatchSharedState(argc > 2 ? static_cast<float>(std::atof(argv[2])) : 60.0f);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--telemetry-server") == 0) {
+        float duration = argc > 2 ? static_cast<float>(std::atof(argv[2])) : 60.0f;
+        float stepRate = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 1000.0f;
+        uint16_t port = argc > 4 ? static_cast<uint16_t>(std::atoi(argv[4])) : TELEMETRY_DEFAULT_PORT;
+        exitCode = RunTelemetryServer(duration, port, stepRate);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--telemetry-client") == 0) {
+        float duration = argc > 2 ? static_cast<float>(std::atof(argv[2])) : 10.0f;
+        bool udp = argc > 3 && std::strcmp(argv[3], "udp") == 0;
+        uint16_t port = argc > 4 ? static_cast<uint16_t>(std::atoi(argv[4])) : TELEMETRY_DEFAULT_PORT;
+        exitCode = RunTelemetryClient(duration, port, udp);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--serve-commands") == 0) {
+        float duration = argc > 2 ? static_cast<float>(std::atof(argv[2])) : 0.0f;
+        float timeStep = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 0.01f;
+        uint16_t port = argc > 4 ? static_cast<uint16_t>(std::atoi(argv[4])) : COMMAND_DEFAULT_PORT;
+        exitCode = RunCommandServer(duration, port, timeStep);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--realtime") == 0) {
+        RealTimeOptions options;
+        if (argc > 2) options.duration = static_cast<float>(std::atof(argv[2]));
+        if (argc > 3) options.rate = static_cast<float>(std::atof(argv[3]));
+        if (argc > 4) options.cpu = std::atoi(argv[4]);
+        options.fifo = argc > 5 && std::strcmp(argv[5], "fifo") == 0;
+        exitCode = RunRealTime(options);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--benchmark-fleet") == 0) {
+        int vehicles = argc > 2 ? std::atoi(argv[2]) : 4096;
+        float duration = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 5400.0f;
+        float timeStep = argc > 4 ? static_cast<float>(std::atof(argv[4])) : 1.0f;
+        exitCode = RunFleetBenchmark(vehicles, duration, timeStep);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--benchmark-fleet-numa") == 0) {
+        int vehicles = argc > 2 ? std::atoi(argv[2]) : 1 << 20;
+        long steps = argc > 3 ? std::atol(argv[3]) : 50;
+        int maxThreads = argc > 4 ? std::atoi(argv[4]) : 0;
+        exitCode = RunFleetNumaBenchmark(vehicles, steps, maxThreads);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--benchmark-viewport") == 0) {
+        int trailPoints = argc > 2 ? std::atoi(argv[2]) : RocketViewport::MAX_TRAIL_POINTS;
+        int vehicles = argc > 3 ? std::atoi(argv[3]) : RocketViewport::MAX_VEHICLES;
+        int trajectories = argc > 4 ? std::atoi(argv[4]) : 1000;
+        int pointsEach = argc > 5 ? std::atoi(argv[5]) : 100;
+        int frames = argc > 6 ? std::atoi(argv[6]) : 300;
+        exitCode = RunViewportBenchmark(trailPoints, vehicles, trajectories, pointsEach, frames);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--benchmark-control") == 0) {
+        int vehicles = argc > 2 ? std::atoi(argv[2]) : 4096;
+        int ticks = argc > 3 ? std::atoi(argv[3]) : 10000;
+        exitCode = RunControlBenchmark(vehicles, ticks);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--benchmark-sensors") == 0) {
+        int vehicles = argc > 2 ? std::atoi(argv[2]) : 4096;
+        int samples = argc > 3 ? std::atoi(argv[3]) : 1000;
+        exitCode = RunSensorBenchmark(vehicles, samples);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--benchmark-navigation") == 0) {
+        int vehicles = argc > 2 ? std::atoi(argv[2]) : 256;
+        float duration = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 30.0f;
+        float timeStep = argc > 4 ? static_cast<float>(std::atof(argv[4])) : 0.01f;
+        exitCode = RunNavigationBenchmark(vehicles, duration, timeStep);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--campaign") == 0) {
+        CampaignOptions options;
+        if (argc > 2) options.maxRuns = std::atol(argv[2]);
+        if (argc > 3) options.halfWidth = std::atof(argv[3]);
+        if (argc > 4) options.workers = std::atoi(argv[4]);
+        if (argc > 5) options.pinWorkers = std::strcmp(argv[5], "pin") == 0;
+        exitCode = RunCampaignMode(options);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--campaign-processes") == 0) {
+        CampaignOptions options;
+        if (argc > 2) options.maxRuns = std::atol(argv[2]);
+        if (argc > 3) options.halfWidth = std::atof(argv[3]);
+        if (argc > 4) options.workers = std::atoi(argv[4]);
+        exitCode = RunProcessCampaignMode(options);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--coordinate") == 0) {
+        CoordinatorOptions options;
+        if (argc > 2) options.campaign.maxRuns = std::atol(argv[2]);
+        if (argc > 3) options.campaign.halfWidth = std::atof(argv[3]);
+        if (argc > 4) options.port = static_cast<uint16_t>(std::atoi(argv[4]));
+        exitCode = RunCoordinatorMode(options);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--campaign-worker") == 0) {
+        uint16_t port = argc > 2 ? static_cast<uint16_t>(std::atoi(argv[2])) : COORDINATOR_DEFAULT_PORT;
+        exitCode = RunCampaignWorker(port);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--sensitivity") == 0) {
+        float timeStep = argc > 2 ? static_cast<float>(std::atof(argv[2])) : 0.02f;
+        float targetApogee = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 0.0f;
+        exitCode = RunSensitivityMode(timeStep, targetApogee);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--sweep") == 0 && argc > 2) {
+        // Axes first, then the cache file if given
+        int axisCount = 0;
+        while (2 + axisCount < argc && std::strchr(argv[2 + axisCount], '=') != nullptr) axisCount++;
+        const char* cachePath = 2 + axisCount < argc ? argv[2 + axisCount] : "sweep.cache";
+        exitCode = RunSweepMode(axisCount, argv + 2, cachePath);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--compile-scenario") == 0 && argc > 3) {
+        Scenario scenario;
+        exitCode = LoadScenario(argv[2], scenario) && SaveScenarioBinary(argv[3], scenario) ? 0 : -1;
+        return true;
+    }
+
+    PrintUsage();
+    exitCode = -1;
+    return true;
+}
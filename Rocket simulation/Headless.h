@@ -0,0 +1,23 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+struct DashboardHooks;
+
+struct HeadlessOptions {
+    float duration = 60.0f;         // Simulated seconds, countdown included
+    float timeStep = 1.0f / 60.0f;  // Fixed physics step (s)
+};
+
+// Fly one launch without a window and print the final state and stats
+int RunHeadless(const HeadlessOptions& options);
+
+// Prints the state a running simulation publishes in shared memory
+int WatchSharedState(float duration);
+
+// Handles the command-line modes that run without a window. A leading
+// --scenario <file> selects the vehicle for every mode and the GUI. Returns
+// true and sets exitCode when argv selected a mode; false means start the GUI.
+// The dashboard hooks let --render-frames draw the same console as the window.
+bool RunCommandLineMode(int argc, char** argv, int& exitCode, const DashboardHooks& dashboard);
+
+#endif
@@ -0,0 +1,113 @@
+#include "Instrumentation.h"
+#include <mutex>
+
+namespace Instrumentation {
+
+namespace {
+
+// Blocks are pushed once per thread and never freed, so counts from threads
+// that have already exited still show up in the totals.
+std::atomic<ThreadCounters*> threadList{ nullptr };
+
+std::mutex baselineMutex;
+Snapshot baseline;
+
+Snapshot aggregate() {
+    Snapshot total;
+    for (ThreadCounters* block = threadList.load(std::memory_order_acquire); block != nullptr; block = block->next) {
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            total.counters[i] += block->counters[i].value.load(std::memory_order_relaxed);
+        }
+        for (int h = 0; h < HISTOGRAM_COUNT; h++) {
+            for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+                total.histograms[h][b] += block->histograms[h].buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return total;
+}
+
+ThreadCounters* registerThread() {
+    ThreadCounters* block = new ThreadCounters();
+    block->next = threadList.load(std::memory_order_relaxed);
+    while (!threadList.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    return block;
+}
+
+}
+
+ThreadCounters& localCounters() {
+    thread_local ThreadCounters* block = registerThread();
+    return *block;
+}
+
+Snapshot snapshot() {
+    Snapshot total = aggregate();
+    std::lock_guard<std::mutex> lock(baselineMutex);
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        total.counters[i] -= baseline.counters[i];
+    }
+    for (int h = 0; h < HISTOGRAM_COUNT; h++) {
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            total.histograms[h][b] -= baseline.histograms[h][b];
+        }
+    }
+    return total;
+}
+
+void reset() {
+    Snapshot total = aggregate();
+    std::lock_guard<std::mutex> lock(baselineMutex);
+    baseline = total;
+}
+
+void writeReport(std::ostream& out) {
+    if (!enabled()) {
+        out << "Instrumentation disabled (build with ROCKET_INSTRUMENTATION=1)" << std::endl;
+        return;
+    }
+
+    Snapshot stats = snapshot();
+    out << "Instrumentation:" << std::endl;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        out << "  " << counterName(static_cast<Counter>(i)) << ": " << stats.counters[i] << std::endl;
+    }
+    for (int h = 0; h < HISTOGRAM_COUNT; h++) {
+        out << "  " << histogramName(static_cast<Histogram>(h)) << ":" << std::endl;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            if (stats.histograms[h][b] == 0) {
+                continue;
+            }
+            uint64_t low = b == 0 ? 0 : (uint64_t(1) << (b - 1));
+            uint64_t high = uint64_t(1) << b;
+            out << "    [" << low << ", " << high << "): " << stats.histograms[h][b] << std::endl;
+        }
+    }
+}
+
+bool enabled() {
+    return ROCKET_INSTRUMENTATION != 0;
+}
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+    case PHYSICS_STEPS: return "Physics steps";
+    case THRUST_APPLICATIONS: return "Thrust applications";
+    case FUEL_CLAMPS: return "Fuel clamps";
+    case GROUND_CLAMPS: return "Ground clamps";
+    case INTEGRATOR_REJECTIONS: return "Integrator rejections";
+    case KEPLER_DRIFTS: return "Kepler drifts";
+    default: return "?";
+    }
+}
+
+const char* histogramName(Histogram histogram) {
+    switch (histogram) {
+    case STEP_DELTA_TIME_US: return "Step size (us)";
+    case RENDER_TIME_US: return "Render upload+draw (us)";
+    default: return "?";
+    }
+}
+
+}
@@ -0,0 +1,112 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Hot-path counters are compiled in only when ROCKET_INSTRUMENTATION is 1.
+// Debug builds default to on, Release builds to off, so production physics
+// pays nothing; define ROCKET_INSTRUMENTATION=1 to profile an optimized build.
+#ifndef ROCKET_INSTRUMENTATION
+#ifdef NDEBUG
+#define ROCKET_INSTRUMENTATION 0
+#else
+#define ROCKET_INSTRUMENTATION 1
+#endif
+#endif
+
+namespace Instrumentation {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+enum Counter {
+    PHYSICS_STEPS,
+    THRUST_APPLICATIONS,
+    FUEL_CLAMPS,
+    GROUND_CLAMPS,
+    INTEGRATOR_REJECTIONS,
+    KEPLER_DRIFTS,
+    COUNTER_COUNT
+};
+
+enum Histogram {
+    STEP_DELTA_TIME_US, // Physics step size in microseconds
+    RENDER_TIME_US,     // CPU time spent uploading and submitting ImGui draw data
+    HISTOGRAM_COUNT
+};
+
+// Histogram bucket i holds values in [2^(i-1), 2^i), bucket 0 holds values below 1
+constexpr int HISTOGRAM_BUCKETS = 32;
+
+// One counter per cache line so the owning thread never shares a line with
+// another counter or another thread's block.
+struct alignas(CACHE_LINE_SIZE) PaddedCounter {
+    std::atomic<uint64_t> value{ 0 };
+};
+
+struct alignas(CACHE_LINE_SIZE) HistogramBuckets {
+    std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+};
+
+// Per-thread storage. Only the owning thread writes; readers aggregate with
+// relaxed loads, so an increment is a plain load/add/store with no lock prefix.
+struct ThreadCounters {
+    std::array<PaddedCounter, COUNTER_COUNT> counters;
+    std::array<HistogramBuckets, HISTOGRAM_COUNT> histograms;
+    ThreadCounters* next = nullptr;
+};
+
+struct Snapshot {
+    std::array<uint64_t, COUNTER_COUNT> counters{};
+    std::array<std::array<uint64_t, HISTOGRAM_BUCKETS>, HISTOGRAM_COUNT> histograms{};
+};
+
+// Registers a block for the calling thread on first use
+ThreadCounters& localCounters();
+
+inline void increment(Counter counter, uint64_t amount = 1) {
+    std::atomic<uint64_t>& value = localCounters().counters[counter].value;
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline void record(Histogram histogram, double value) {
+    int bucket = 0;
+    uint64_t scaled = value > 0.0 ? static_cast<uint64_t>(value) : 0;
+    while (scaled != 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+        scaled >>= 1;
+        bucket++;
+    }
+    std::atomic<uint64_t>& slot = localCounters().histograms[histogram].buckets[bucket];
+    slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// Sum of all threads' counters since the last reset()
+Snapshot snapshot();
+
+// Start counting from zero again. Implemented as a baseline so no thread
+// ever writes to another thread's block.
+void reset();
+
+// Stats block printed by the headless runner
+void writeReport(std::ostream& out);
+
+bool enabled();
+const char* counterName(Counter counter);
+const char* histogramName(Histogram histogram);
+
+}
+
+#if ROCKET_INSTRUMENTATION
+#define ROCKET_COUNT(counter) ::Instrumentation::increment(::Instrumentation::counter)
+#define ROCKET_COUNT_N(counter, amount) ::Instrumentation::increment(::Instrumentation::counter, (amount))
+#define ROCKET_RECORD(histogram, value) ::Instrumentation::record(::Instrumentation::histogram, (value))
+#else
+#define ROCKET_COUNT(counter) ((void)0)
+#define ROCKET_COUNT_N(counter, amount) ((void)0)
+#define ROCKET_RECORD(histogram, value) ((void)0)
+#endif
+
+#endif
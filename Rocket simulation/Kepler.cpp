@@ -0,0 +1,108 @@
+#include "Kepler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const double TWO_PI = 6.283185307179586;
+const int KEPLER_MAX_ITERATIONS = 50;
+
+// Stumpff functions C(z) and S(z), with their series near z = 0 where the
+// closed forms cancel
+static void Stumpff(double z, double& c, double& s) {
+    if (z > 1.0e-6) {
+        double root = std::sqrt(z);
+        c = (1.0 - std::cos(root)) / z;
+        s = (root - std::sin(root)) / (z * root);
+    }
+    else if (z < -1.0e-6) {
+        double root = std::sqrt(-z);
+        c = (std::cosh(root) - 1.0) / -z;
+        s = (std::sinh(root) - root) / (-z * root);
+    }
+    else {
+        c = 0.5 - z / 24.0 + z * z / 720.0;
+        s = 1.0 / 6.0 - z / 120.0 + z * z / 5040.0;
+    }
+}
+
+void PropagateKepler(double mu, glm::dvec3& position, glm::dvec3& velocity, double dt) {
+    const double sqrtMu = std::sqrt(mu);
+    const double r0 = glm::length(position);
+    const double radialVelocity = glm::dot(position, velocity) / r0;
+    const double alpha = 2.0 / r0 - glm::dot(velocity, velocity) / mu; // 1 / semi-major axis
+
+    // Whole revolutions of a closed orbit change nothing, and dropping them
+    // keeps the universal anomaly small enough for Newton to start near it
+    double chi;
+    if (alpha > 1.0e-12) {
+        dt = std::fmod(dt, TWO_PI / std::sqrt(mu * alpha * alpha * alpha));
+        chi = sqrtMu * alpha * dt;
+    }
+    else if (alpha < -1.0e-12) {
+        double a = 1.0 / alpha;
+        double direction = dt < 0.0 ? -1.0 : 1.0;
+        chi = direction * std::sqrt(-a) * std::log(-2.0 * mu * alpha * std::abs(dt)
+            / (glm::dot(position, velocity) + direction * std::sqrt(-mu * a) * (1.0 - r0 * alpha)));
+    }
+    else {
+        chi = sqrtMu * dt / r0;
+    }
+
+    double z = 0.0, c = 0.5, s = 1.0 / 6.0;
+    for (int i = 0; i < KEPLER_MAX_ITERATIONS; i++) {
+        z = alpha * chi * chi;
+        Stumpff(z, c, s);
+        double f = r0 * radialVelocity / sqrtMu * chi * chi * c + (1.0 - alpha * r0) * chi * chi * chi * s
+            + r0 * chi - sqrtMu * dt;
+        double slope = r0 * radialVelocity / sqrtMu * chi * (1.0 - z * s) + (1.0 - alpha * r0) * chi * chi * c + r0;
+        double correction = f / slope;
+        chi -= correction;
+        if (std::abs(correction) <= 1.0e-12 * std::max(1.0, std::abs(chi))) break;
+    }
+    z = alpha * chi * chi;
+    Stumpff(z, c, s);
+
+    // Lagrange coefficients
+    double f = 1.0 - chi * chi / r0 * c;
+    double g = dt - chi * chi * chi / sqrtMu * s;
+    glm::dvec3 newPosition = f * position + g * velocity;
+    double r = glm::length(newPosition);
+    double fDot = sqrtMu / (r * r0) * (z * s - 1.0) * chi;
+    double gDot = 1.0 - chi * chi / r * c;
+    velocity = fDot * position + gDot * velocity;
+    position = newPosition;
+}
+
+double TimeToRadius(double mu, const glm::dvec3& position, const glm::dvec3& velocity, double radius) {
+    const double never = std::numeric_limits<double>::infinity();
+    const double r = glm::length(position);
+    if (r <= radius) return 0.0;
+
+    glm::dvec3 momentum = glm::cross(position, velocity);
+    double e = glm::length(glm::cross(velocity, momentum) / mu - position / r);
+    double periapsis = glm::dot(momentum, momentum) / mu / (1.0 + e);
+    if (periapsis >= radius) return never;
+
+    // Mean anomaly now and at the descending crossing, from the eccentric
+    // (or hyperbolic) anomaly: e cos E = 1 - r / a, e sin E = r.v / sqrt(mu a)
+    const double alpha = 2.0 / r - glm::dot(velocity, velocity) / mu;
+    const double rv = glm::dot(position, velocity);
+    if (alpha > 0.0) {
+        double a = 1.0 / alpha;
+        double eSinE = rv / std::sqrt(mu * a);
+        double anomaly = std::atan2(eSinE, 1.0 - r / a);
+        double crossing = -std::acos(std::min(1.0, std::max(-1.0, (1.0 - radius / a) / e)));
+        double dM = (crossing - e * std::sin(crossing)) - (anomaly - eSinE);
+        dM = std::fmod(dM, TWO_PI);
+        if (dM < 0.0) dM += TWO_PI;
+        return dM / std::sqrt(mu * alpha * alpha * alpha);
+    }
+
+    // Open orbit: only comes down if it is falling now
+    if (rv >= 0.0) return never;
+    double a = 1.0 / alpha;
+    double anomaly = std::asinh(rv / (e * std::sqrt(-mu * a)));
+    double crossing = -std::acosh(std::max(1.0, (1.0 - radius / a) / e));
+    double dM = (e * std::sinh(crossing) - crossing) - (e * std::sinh(anomaly) - anomaly);
+    return std::max(0.0, dM / std::sqrt(-mu * alpha * alpha * alpha));
+}
@@ -0,0 +1,19 @@
+#ifndef KEPLER_H
+#define KEPLER_H
+
+#include <glm.hpp>
+
+// Two-body motion in closed form, for unpowered coasting. Any step length
+// costs the same few Newton iterations, so a coast can jump straight to the
+// next event instead of being stepped at the frame rate.
+
+// Moves position and velocity (m, m/s, inertial) dt seconds along their
+// Kepler orbit about a point mass mu. Elliptic, parabolic and hyperbolic
+// orbits alike (universal-variable formulation).
+void PropagateKepler(double mu, glm::dvec3& position, glm::dvec3& velocity, double dt);
+
+// Seconds until the orbit next descends through the given radius: 0 when
+// already at or inside it, infinity when it never comes down that far.
+double TimeToRadius(double mu, const glm::dvec3& position, const glm::dvec3& velocity, double radius);
+
+#endif
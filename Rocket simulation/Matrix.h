@@ -0,0 +1,65 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+// Small dense matrices for filters. The dimensions are template parameters
+// and the storage is inline, so nothing allocates, a size mismatch does not
+// compile, and the compiler sees every loop bound.
+template <typename T, int Rows, int Cols>
+struct Matrix {
+    T m[Rows][Cols];
+
+    static Matrix zero() {
+        Matrix result = {};
+        return result;
+    }
+
+    static Matrix identity() {
+        Matrix result = {};
+        for (int i = 0; i < Rows && i < Cols; i++) result.m[i][i] = T(1);
+        return result;
+    }
+
+    T& operator()(int row, int col) { return m[row][col]; }
+    const T& operator()(int row, int col) const { return m[row][col]; }
+};
+
+template <typename T, int Rows, int Inner, int Cols>
+Matrix<T, Rows, Cols> operator*(const Matrix<T, Rows, Inner>& a, const Matrix<T, Inner, Cols>& b) {
+    Matrix<T, Rows, Cols> result = {};
+    for (int i = 0; i < Rows; i++) {
+        for (int k = 0; k < Inner; k++) {
+            T aik = a.m[i][k];
+            for (int j = 0; j < Cols; j++) result.m[i][j] += aik * b.m[k][j];
+        }
+    }
+    return result;
+}
+
+template <typename T, int Rows, int Cols>
+Matrix<T, Rows, Cols> operator+(const Matrix<T, Rows, Cols>& a, const Matrix<T, Rows, Cols>& b) {
+    Matrix<T, Rows, Cols> result;
+    for (int i = 0; i < Rows; i++) {
+        for (int j = 0; j < Cols; j++) result.m[i][j] = a.m[i][j] + b.m[i][j];
+    }
+    return result;
+}
+
+template <typename T, int Rows, int Cols>
+Matrix<T, Rows, Cols> operator-(const Matrix<T, Rows, Cols>& a, const Matrix<T, Rows, Cols>& b) {
+    Matrix<T, Rows, Cols> result;
+    for (int i = 0; i < Rows; i++) {
+        for (int j = 0; j < Cols; j++) result.m[i][j] = a.m[i][j] - b.m[i][j];
+    }
+    return result;
+}
+
+template <typename T, int Rows, int Cols>
+Matrix<T, Cols, Rows> Transpose(const Matrix<T, Rows, Cols>& a) {
+    Matrix<T, Cols, Rows> result;
+    for (int i = 0; i < Rows; i++) {
+        for (int j = 0; j < Cols; j++) result.m[j][i] = a.m[i][j];
+    }
+    return result;
+}
+
+#endif
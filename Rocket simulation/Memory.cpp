@@ -0,0 +1,200 @@
+#include "Memory.h"
+#include "AllocationTracker.h"
+#include <cstdlib>
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+Arena::Arena(size_t chunkSize)
+    : chunkSize(chunkSize)
+{}
+
+Arena::~Arena() {
+    Chunk* chunk = first;
+    while (chunk != nullptr) {
+        Chunk* next = chunk->next;
+        std::free(chunk);
+        chunk = next;
+    }
+}
+
+unsigned char* Arena::chunkData(Chunk* chunk) {
+    return reinterpret_cast<unsigned char*>(chunk) + alignUp(sizeof(Chunk), alignof(std::max_align_t));
+}
+
+Arena::Chunk* Arena::newChunk(size_t minimumSize) {
+    size_t size = minimumSize > chunkSize ? minimumSize : chunkSize;
+    void* memory = std::malloc(alignUp(sizeof(Chunk), alignof(std::max_align_t)) + size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    AllocationTracker::noteAllocation();
+
+    Chunk* chunk = static_cast<Chunk*>(memory);
+    chunk->next = nullptr;
+    chunk->size = size;
+    totalCapacity += size;
+    return chunk;
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    if (current == nullptr) {
+        first = current = newChunk(size + alignment);
+        offset = 0;
+    }
+
+    size_t start = alignUp(offset, alignment);
+    while (start + size > current->size) {
+        // Move on to the next kept chunk, or grow the chain
+        usedInFullChunks += current->size;
+        if (current->next == nullptr || current->next->size < size + alignment) {
+            Chunk* chunk = newChunk(size + alignment);
+            chunk->next = current->next;
+            current->next = chunk;
+        }
+        current = current->next;
+        offset = 0;
+        start = 0;
+    }
+
+    offset = start + size;
+    return chunkData(current) + start;
+}
+
+void Arena::reserve() {
+    if (first == nullptr) {
+        first = current = newChunk(chunkSize);
+        offset = 0;
+    }
+}
+
+void Arena::reset() {
+    current = first;
+    offset = 0;
+    usedInFullChunks = 0;
+}
+
+FixedPool::FixedPool(size_t blockSize, size_t blockAlignment, size_t blocksPerChunk)
+    : arena(alignUp(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize, blockAlignment) * blocksPerChunk),
+    blockSize(alignUp(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize, blockAlignment)),
+    blockAlignment(blockAlignment < alignof(FreeBlock) ? alignof(FreeBlock) : blockAlignment)
+{}
+
+void* FixedPool::acquire() {
+    live++;
+    if (freeList != nullptr) {
+        FreeBlock* block = freeList;
+        freeList = block->next;
+        return block;
+    }
+    return arena.allocate(blockSize, blockAlignment);
+}
+
+void FixedPool::release(void* block) {
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = freeList;
+    freeList = freeBlock;
+    live--;
+}
+
+namespace ImGuiHeap {
+
+namespace {
+
+const int MIN_CLASS_SHIFT = 4;   // 16 bytes
+const int MAX_CLASS_SHIFT = 20;  // 1 MB; larger blocks go straight to malloc
+const int CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+const int OVERSIZED = CLASS_COUNT;
+
+// Every block starts with a header recording its class so free() can find
+// the right list; the header keeps the payload max_align_t aligned.
+struct alignas(std::max_align_t) BlockHeader {
+    int sizeClass;
+    size_t size;
+};
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct Heap {
+    Arena arena{ 256 * 1024 };
+    FreeBlock* freeLists[CLASS_COUNT] = {};
+    size_t liveBytes = 0;
+};
+
+Heap& heap() {
+    static Heap instance;
+    return instance;
+}
+
+int sizeClassFor(size_t size) {
+    int shift = MIN_CLASS_SHIFT;
+    while ((size_t(1) << shift) < size && shift <= MAX_CLASS_SHIFT) {
+        shift++;
+    }
+    return shift > MAX_CLASS_SHIFT ? OVERSIZED : shift - MIN_CLASS_SHIFT;
+}
+
+}
+
+void* allocate(size_t size, void*) {
+    Heap& h = heap();
+    size_t total = size + sizeof(BlockHeader);
+    int sizeClass = sizeClassFor(total);
+
+    void* memory;
+    if (sizeClass == OVERSIZED) {
+        memory = std::malloc(total);
+        if (memory == nullptr) {
+            return nullptr;
+        }
+        AllocationTracker::noteAllocation();
+        h.liveBytes += total;
+    }
+    else if (h.freeLists[sizeClass] != nullptr) {
+        memory = h.freeLists[sizeClass];
+        h.freeLists[sizeClass] = h.freeLists[sizeClass]->next;
+        h.liveBytes += size_t(1) << (sizeClass + MIN_CLASS_SHIFT);
+    }
+    else {
+        size_t blockSize = size_t(1) << (sizeClass + MIN_CLASS_SHIFT);
+        memory = h.arena.allocate(blockSize, alignof(BlockHeader));
+        h.liveBytes += blockSize;
+    }
+
+    BlockHeader* header = static_cast<BlockHeader*>(memory);
+    header->sizeClass = sizeClass;
+    header->size = sizeClass == OVERSIZED ? total : size_t(1) << (sizeClass + MIN_CLASS_SHIFT);
+    return header + 1;
+}
+
+void free(void* ptr, void*) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    Heap& h = heap();
+    BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+    int sizeClass = header->sizeClass;
+    h.liveBytes -= header->size;
+    if (sizeClass == OVERSIZED) {
+        std::free(header);
+        return;
+    }
+
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
+    block->next = h.freeLists[sizeClass];
+    h.freeLists[sizeClass] = block;
+}
+
+size_t capacity() {
+    return heap().arena.capacity();
+}
+
+size_t liveBytes() {
+    return heap().liveBytes;
+}
+
+}
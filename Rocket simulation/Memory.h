@@ -0,0 +1,121 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Bump allocator for data that dies together: one frame of UI scratch or one
+// physics step's events. reset() rewinds to the first chunk and keeps every
+// chunk, so after warm-up an arena never goes back to malloc. Not thread-safe;
+// each thread uses its own arena.
+class Arena {
+public:
+    explicit Arena(size_t chunkSize = 64 * 1024);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void reset();
+
+    // Takes the first chunk now if there is none yet, so the first allocate()
+    // does not reach malloc at an inconvenient moment
+    void reserve();
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    size_t bytesUsed() const { return usedInFullChunks + offset; }
+    size_t capacity() const { return totalCapacity; }
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    Chunk* newChunk(size_t minimumSize);
+    static unsigned char* chunkData(Chunk* chunk);
+
+    size_t chunkSize;
+    Chunk* first = nullptr;
+    Chunk* current = nullptr;
+    size_t offset = 0;
+    size_t usedInFullChunks = 0;
+    size_t totalCapacity = 0;
+};
+
+// Fixed-size block pool with an intrusive free list. Blocks are carved from
+// an Arena and recycled, so the footprint only grows to the high-water mark.
+// Single owner thread, like Arena.
+class FixedPool {
+public:
+    FixedPool(size_t blockSize, size_t blockAlignment, size_t blocksPerChunk = 256);
+
+    void* acquire();
+    void release(void* block);
+
+    size_t liveBlocks() const { return live; }
+    size_t capacity() const { return arena.capacity(); }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    Arena arena;
+    size_t blockSize;
+    size_t blockAlignment;
+    FreeBlock* freeList = nullptr;
+    size_t live = 0;
+};
+
+template <typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t objectsPerChunk = 256)
+        : pool(sizeof(T), alignof(T), objectsPerChunk) {}
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        return new (pool.acquire()) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object) {
+        if (object != nullptr) {
+            object->~T();
+            pool.release(object);
+        }
+    }
+
+    size_t liveObjects() const { return pool.liveBlocks(); }
+    size_t capacity() const { return pool.capacity(); }
+
+private:
+    FixedPool pool;
+};
+
+// ImGui keeps its buffers across frames, so it cannot use a resetting arena.
+// It gets power-of-two size classes recycled through free lists instead;
+// only refills and oversized blocks reach malloc. ImGui is single-threaded,
+// so the UI thread owns this heap and never contends with the physics thread.
+namespace ImGuiHeap {
+
+void* allocate(size_t size, void* userData);
+void free(void* ptr, void* userData);
+
+size_t capacity();
+size_t liveBytes();
+
+}
+
+#endif
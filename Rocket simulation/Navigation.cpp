@@ -0,0 +1,149 @@
+#include "Navigation.h"
+#include "Rocket.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+const double RADIANS_TO_DEGREES = 57.29577951308232;
+
+namespace {
+
+struct NavigationRun {
+    double seconds = 0.0;       // In the filters alone
+    long updates = 0;           // One predict and the corrections due, per vehicle-step
+    double position = 0.0, velocity = 0.0, attitude = 0.0;  // Summed squared errors
+    double gpsPosition = 0.0, gpsVelocity = 0.0, sensedAttitude = 0.0;
+    double worstPosition = 0.0;
+    long samples = 0;
+    bool finite = true;
+};
+
+// Every vehicle burns 10 s at 100 m/s^2 and coasts. A slow gimbal wobble
+// with its own phase per vehicle keeps the attitude moving.
+void FlyVehicles(std::vector<Rocket>& rockets, float time, float dt, std::vector<float>& thrust) {
+    const std::array<float, 5> levels = { 20.0f, 20.0f, 20.0f, 20.0f, 20.0f };
+    for (size_t i = 0; i < rockets.size(); i++) {
+        Rocket& rocket = rockets[i];
+        float phase = 2.399963f * i;
+        rocket.gimbalPitch.fill(2.0e-4f * std::sin(time + phase));
+        rocket.gimbalYaw.fill(2.0e-4f * std::cos(0.7f * time + phase));
+        thrust[i] = rocket.fuel > 0.0f ? 100.0f : 0.0f; // What the engines deliver this step
+        rocket.applyThrust(levels, dt);
+        rocket.update(dt);
+    }
+}
+
+void WriteTruth(const Rocket& rocket, SensorBank& bank, size_t i) {
+    bank.truthOf(offsetof(SensorValues, attitude) / sizeof(float))[i] = rocket.pitch;
+    bank.truthOf(offsetof(SensorValues, attitude) / sizeof(float) + 1)[i] = rocket.yaw;
+    bank.truthOf(offsetof(SensorValues, rate) / sizeof(float))[i] = rocket.pitchRate;
+    bank.truthOf(offsetof(SensorValues, rate) / sizeof(float) + 1)[i] = rocket.yawRate;
+    for (int axis = 0; axis < 3; axis++) {
+        bank.truthOf(offsetof(SensorValues, position) / sizeof(float) + axis)[i] = rocket.position[axis];
+        bank.truthOf(offsetof(SensorValues, velocity) / sizeof(float) + axis)[i] = rocket.velocity[axis];
+    }
+    bank.truthOf(offsetof(SensorValues, altitude) / sizeof(float))[i] = rocket.position.y;
+}
+
+template <typename T>
+NavigationRun FlyFilters(const Scenario& scenario, int vehicles, long steps, float dt) {
+    NavigationRun run;
+    std::vector<Rocket> rockets(vehicles);
+    for (Rocket& rocket : rockets) rocket.gravity = scenario.gravity;
+    std::vector<float> thrust(vehicles);
+    SensorBank bank(static_cast<size_t>(vehicles));
+    std::vector<SensorValues> sensed(vehicles);
+    std::vector<NavigationFilter<T> > filters(vehicles);
+    for (NavigationFilter<T>& filter : filters) filter.reset(scenario);
+    float clocks[SENSOR_COUNT] = {};
+    uint32_t samples[SENSOR_COUNT] = {};
+
+    for (long step = 0; step < steps; step++) {
+        // Sample what is due, all vehicles at once, and hand each filter its readings
+        for (size_t i = 0; i < rockets.size(); i++) WriteTruth(rockets[i], bank, i);
+        uint32_t fresh = 0;
+        for (int channel = 0; channel < SENSOR_COUNT; channel++) {
+            float rate = scenario.sensors[channel].rate;
+            if (rate > 0.0f && !AdvanceSensorClock(clocks[channel], samples[channel], rate, dt)) continue;
+            bank.sample(scenario, static_cast<SensorChannel>(channel), samples[channel]++);
+            fresh |= 1u << channel;
+        }
+        for (size_t value = 0; value < SENSOR_VALUES; value++) {
+            const float* reading = bank.readingOf(value);
+            for (size_t i = 0; i < sensed.size(); i++) reinterpret_cast<float*>(&sensed[i])[value] = reading[i];
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < filters.size(); i++) filters[i].correct(scenario, sensed[i], fresh);
+        run.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Error after the correction, against the state the sensors saw
+        for (size_t i = 0; i < filters.size(); i++) {
+            const Rocket& rocket = rockets[i];
+            const T* x = filters[i].state;
+            double position = 0.0, velocity = 0.0, gpsPosition = 0.0, gpsVelocity = 0.0;
+            for (int axis = 0; axis < 3; axis++) {
+                position += std::pow(double(x[NAV_X + axis]) - rocket.position[axis], 2);
+                velocity += std::pow(double(x[NAV_VX + axis]) - rocket.velocity[axis], 2);
+                gpsPosition += std::pow(double(sensed[i].position[axis]) - rocket.position[axis], 2);
+                gpsVelocity += std::pow(double(sensed[i].velocity[axis]) - rocket.velocity[axis], 2);
+            }
+            run.position += position;
+            run.velocity += velocity;
+            run.gpsPosition += gpsPosition;
+            run.gpsVelocity += gpsVelocity;
+            run.attitude += std::pow(double(x[NAV_PITCH]) - rocket.pitch, 2) + std::pow(double(x[NAV_YAW]) - rocket.yaw, 2);
+            run.sensedAttitude += std::pow(double(sensed[i].attitude[0]) - rocket.pitch, 2)
+                + std::pow(double(sensed[i].attitude[1]) - rocket.yaw, 2);
+            run.worstPosition = std::max(run.worstPosition, std::sqrt(position));
+            run.finite = run.finite && std::isfinite(position) && std::isfinite(velocity);
+        }
+        run.samples += vehicles;
+
+        FlyVehicles(rockets, step * dt, dt, thrust);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < filters.size(); i++) {
+            filters[i].predict(scenario, sensed[i], T(thrust[i]), T(scenario.gravity), T(dt));
+        }
+        run.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        run.updates += vehicles;
+    }
+    return run;
+}
+
+void Report(const char* name, const NavigationRun& run) {
+    double n = double(run.samples);
+    std::cout << name << ": " << run.seconds * 1.0e9 / run.updates << " ns per update, "
+        << run.updates / run.seconds << " updates/s" << std::endl;
+    std::cout << "  RMS position error " << std::sqrt(run.position / n) << " m (GPS " << std::sqrt(run.gpsPosition / n)
+        << " m), worst " << run.worstPosition << " m" << std::endl;
+    std::cout << "  RMS velocity error " << std::sqrt(run.velocity / n) << " m/s (GPS " << std::sqrt(run.gpsVelocity / n)
+        << " m/s)" << std::endl;
+    std::cout << "  RMS attitude error " << std::sqrt(run.attitude / n) * RADIANS_TO_DEGREES << " deg (sensor "
+        << std::sqrt(run.sensedAttitude / n) * RADIANS_TO_DEGREES << " deg)" << std::endl;
+}
+
+}
+
+int RunNavigationBenchmark(int vehicles, float duration, float timeStep) {
+    if (vehicles <= 0 || !(duration > 0.0f) || !(timeStep > 0.0f)) {
+        std::cerr << "Navigation benchmark needs vehicles, a duration and a timestep" << std::endl;
+        return -1;
+    }
+    const Scenario& scenario = ActiveScenario();
+    long steps = static_cast<long>(duration / timeStep);
+    std::cout << "Navigation filter: " << vehicles << " vehicles, " << steps << " steps of " << timeStep << " s" << std::endl;
+
+    NavigationRun precise = FlyFilters<double>(scenario, vehicles, steps, timeStep);
+    Report("double", precise);
+    NavigationRun single = FlyFilters<float>(scenario, vehicles, steps, timeStep);
+    Report("float", single);
+
+    if (!precise.finite || !single.finite) {
+        std::cerr << "Navigation filter diverged" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+#ifndef NAVIGATION_H
+#define NAVIGATION_H
+
+#include "Matrix.h"
+#include "Scenario.h"
+#include "Sensors.h"
+#include <algorithm>
+#include <cmath>
+
+// What the navigation filter estimates, in the Rocket frame
+enum NavigationState {
+    NAV_X, NAV_Y, NAV_Z,                    // m
+    NAV_VX, NAV_VY, NAV_VZ,                 // m/s
+    NAV_PITCH, NAV_YAW,                     // rad
+    NAV_GYRO_BIAS_PITCH, NAV_GYRO_BIAS_YAW, // rad/s
+    NAV_STATES
+};
+
+// Process noise: what the prediction leaves out
+const double NAV_ACCELERATION_NOISE = 0.1;  // m/s^2 per root s, unmodelled forces
+const double NAV_ATTITUDE_NOISE = 1.0e-3;   // rad per root s, rate changes between gyro samples
+const double NAV_GYRO_BIAS_DRIFT = 1.0e-5;  // rad/s per root s
+const double NAV_MIN_VARIANCE = 1.0e-10;    // Floor for perfect sensors
+
+// Extended Kalman filter for one vehicle. The gyros and the engines' thrust
+// drive the prediction, mirroring Rocket::applyThrust and Rocket::update;
+// attitude, GPS and altimeter samples correct it as they arrive, one scalar
+// at a time (each measures a single state, so there is no matrix to invert).
+// Gyro biases are estimated alongside. Every matrix is fixed-size: the
+// filter never allocates and can live in FlightState or a plain vector.
+template <typename T>
+class NavigationFilter {
+public:
+    typedef Matrix<T, NAV_STATES, NAV_STATES> Covariance;
+
+    T state[NAV_STATES];
+    Covariance covariance;
+
+    NavigationFilter() { reset(DefaultScenario()); }
+
+    // On the pad: upright and still, gyro biases as the scenario expects them
+    void reset(const Scenario& scenario) {
+        for (T& value : state) value = T(0);
+        covariance = Covariance::zero();
+        for (int i = NAV_X; i <= NAV_Z; i++) covariance(i, i) = T(0.01);
+        for (int i = NAV_VX; i <= NAV_VZ; i++) covariance(i, i) = T(1.0e-4);
+        covariance(NAV_PITCH, NAV_PITCH) = covariance(NAV_YAW, NAV_YAW) = T(7.6e-5); // (0.5 deg)^2
+        T biasVariance = T(std::max(double(SensorVariance(scenario, SENSOR_GYRO)), NAV_MIN_VARIANCE));
+        covariance(NAV_GYRO_BIAS_PITCH, NAV_GYRO_BIAS_PITCH) = covariance(NAV_GYRO_BIAS_YAW, NAV_GYRO_BIAS_YAW) = biasVariance;
+    }
+
+    T pitchRate(const SensorValues& sensed) const { return T(sensed.rate[0]) - state[NAV_GYRO_BIAS_PITCH]; }
+    T yawRate(const SensorValues& sensed) const { return T(sensed.rate[1]) - state[NAV_GYRO_BIAS_YAW]; }
+
+    // Corrects with every sensor the last UpdateSensors read anew (fresh is
+    // SensorState::fresh). The gyros feed predict() instead.
+    void correct(const Scenario& scenario, const SensorValues& sensed, uint32_t fresh) {
+        if (fresh & (1u << SENSOR_ATTITUDE)) {
+            T variance = measurementVariance(scenario, SENSOR_ATTITUDE);
+            correctState(NAV_PITCH, sensed.attitude[0], variance);
+            correctState(NAV_YAW, sensed.attitude[1], variance);
+        }
+        if (fresh & (1u << SENSOR_GPS_POSITION)) {
+            T variance = measurementVariance(scenario, SENSOR_GPS_POSITION);
+            for (int i = 0; i < 3; i++) correctState(NAV_X + i, sensed.position[i], variance);
+        }
+        if (fresh & (1u << SENSOR_GPS_VELOCITY)) {
+            T variance = measurementVariance(scenario, SENSOR_GPS_VELOCITY);
+            for (int i = 0; i < 3; i++) correctState(NAV_VX + i, sensed.velocity[i], variance);
+        }
+        if (fresh & (1u << SENSOR_ALTIMETER)) {
+            correctState(NAV_Y, sensed.altitude[0], measurementVariance(scenario, SENSOR_ALTIMETER));
+        }
+    }
+
+    // Advances by dt with thrustAcceleration along the body axis (0 with the
+    // engines out) and gravity along y, the flight's model where it thinks it is
+    void predict(const Scenario& scenario, const SensorValues& sensed, T thrustAcceleration, T gravity, T dt) {
+        state[NAV_PITCH] += pitchRate(sensed) * dt;
+        state[NAV_YAW] += yawRate(sensed) * dt;
+        T sp = std::sin(state[NAV_PITCH]), cp = std::cos(state[NAV_PITCH]);
+        T sy = std::sin(state[NAV_YAW]), cy = std::cos(state[NAV_YAW]);
+        T kick = thrustAcceleration * dt;
+        const T axis[3] = { sp * cy, cp * cy, sy };
+        const T axisByPitch[3] = { cp * cy, -sp * cy, T(0) };
+        const T axisByYaw[3] = { -sp * sy, -cp * sy, cy };
+        for (int i = 0; i < 3; i++) state[NAV_VX + i] += axis[i] * kick;
+        state[NAV_VY] += gravity * dt;
+        for (int i = 0; i < 3; i++) state[NAV_X + i] += state[NAV_VX + i] * dt;
+        if (state[NAV_Y] < T(0)) {
+            // Held up by the ground, like Rocket::update
+            state[NAV_Y] = T(0);
+            state[NAV_VY] = std::max(state[NAV_VY], T(0));
+        }
+
+        // Jacobian: the attitude picks up the bias, the velocity the turned
+        // thrust, and the position the new velocity
+        Covariance jacobian = Covariance::identity();
+        jacobian(NAV_PITCH, NAV_GYRO_BIAS_PITCH) = -dt;
+        jacobian(NAV_YAW, NAV_GYRO_BIAS_YAW) = -dt;
+        for (int i = 0; i < 3; i++) {
+            T byPitch = axisByPitch[i] * kick, byYaw = axisByYaw[i] * kick;
+            T row[NAV_STATES] = {};
+            row[NAV_VX + i] = T(1);
+            row[NAV_PITCH] = byPitch;
+            row[NAV_YAW] = byYaw;
+            row[NAV_GYRO_BIAS_PITCH] = -dt * byPitch;
+            row[NAV_GYRO_BIAS_YAW] = -dt * byYaw;
+            for (int j = 0; j < NAV_STATES; j++) {
+                jacobian(NAV_VX + i, j) = row[j];
+                jacobian(NAV_X + i, j) = (j == NAV_X + i ? T(1) : T(0)) + dt * row[j];
+            }
+        }
+
+        covariance = jacobian * covariance * Transpose(jacobian);
+        const SensorNoise& gyro = scenario.sensors[SENSOR_GYRO];
+        T gyroPeriod = gyro.rate > 0.0f ? T(1) / T(gyro.rate) : dt;
+        T attitudeNoise = (T(SensorVariance(scenario, SENSOR_GYRO)) * gyroPeriod
+            + T(NAV_ATTITUDE_NOISE * NAV_ATTITUDE_NOISE)) * dt;
+        T accelerationNoise = T(NAV_ACCELERATION_NOISE * NAV_ACCELERATION_NOISE) * dt;
+        for (int i = 0; i < 3; i++) {
+            covariance(NAV_VX + i, NAV_VX + i) += accelerationNoise;
+            covariance(NAV_X + i, NAV_X + i) += accelerationNoise * dt * dt / T(3);
+        }
+        covariance(NAV_PITCH, NAV_PITCH) += attitudeNoise;
+        covariance(NAV_YAW, NAV_YAW) += attitudeNoise;
+        covariance(NAV_GYRO_BIAS_PITCH, NAV_GYRO_BIAS_PITCH) += T(NAV_GYRO_BIAS_DRIFT * NAV_GYRO_BIAS_DRIFT) * dt;
+        covariance(NAV_GYRO_BIAS_YAW, NAV_GYRO_BIAS_YAW) += T(NAV_GYRO_BIAS_DRIFT * NAV_GYRO_BIAS_DRIFT) * dt;
+
+        // Rounding makes the product drift from symmetric
+        for (int i = 0; i < NAV_STATES; i++) {
+            for (int j = 0; j < i; j++) {
+                T mean = T(0.5) * (covariance(i, j) + covariance(j, i));
+                covariance(i, j) = covariance(j, i) = mean;
+            }
+        }
+    }
+
+private:
+    static T measurementVariance(const Scenario& scenario, SensorChannel channel) {
+        return T(std::max(double(SensorVariance(scenario, channel)), NAV_MIN_VARIANCE));
+    }
+
+    // Update with one reading of a single state
+    void correctState(int index, T measured, T variance) {
+        T innovationVariance = covariance(index, index) + variance;
+        T gain[NAV_STATES], row[NAV_STATES];
+        for (int i = 0; i < NAV_STATES; i++) {
+            gain[i] = covariance(i, index) / innovationVariance;
+            row[i] = covariance(index, i);
+        }
+        T innovation = measured - state[index];
+        for (int i = 0; i < NAV_STATES; i++) {
+            state[i] += gain[i] * innovation;
+            for (int j = 0; j < NAV_STATES; j++) covariance(i, j) -= gain[i] * row[j];
+        }
+    }
+};
+
+// Flies a batch of vehicles on Rocket with sensors, runs a filter per
+// vehicle in double and in float, and reports updates per second and the
+// estimation error against the true state
+int RunNavigationBenchmark(int vehicles, float duration, float timeStep);
+
+#endif
@@ -0,0 +1,320 @@
+#include "Offscreen.h"
+#include "Flight.h"
+#include "Png.h"
+#include "imgui.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int JOBS_PER_WORKER = 2;
+const ImTextureID FONT_TEXTURE = reinterpret_cast<ImTextureID>(static_cast<intptr_t>(1));
+const uint8_t CLEAR_COLOR[4] = { 115, 140, 153, 255 }; // Same as the window's glClearColor
+
+struct DrawCommand {
+    ImVec4 clipRect;
+    unsigned int vertexOffset;
+    unsigned int indexOffset;
+    unsigned int elementCount;
+    ImTextureID texture;
+};
+
+// One frame's draw data, flattened out of ImGui so a worker can render it
+// while the main thread builds the next frame. Jobs are recycled.
+struct FrameJob {
+    int index = 0;
+    std::vector<ImDrawVert> vertices;
+    std::vector<ImDrawIdx> indices;
+    std::vector<DrawCommand> commands;
+};
+
+struct FontTexture {
+    const unsigned char* alpha = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+// Bounded hand-off between the frame builder and the workers. Free jobs go
+// back to the builder, which blocks when every job is in flight.
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t jobs) : storage(jobs) {
+        for (FrameJob& job : storage) freeJobs.push_back(&job);
+    }
+
+    FrameJob* acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        freeReady.wait(lock, [this] { return !freeJobs.empty(); });
+        FrameJob* job = freeJobs.front();
+        freeJobs.pop_front();
+        return job;
+    }
+
+    void submit(FrameJob* job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(job);
+        pendingReady.notify_one();
+    }
+
+    // Null once the queue is closed and drained
+    FrameJob* take() {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingReady.wait(lock, [this] { return !pending.empty() || closed; });
+        if (pending.empty()) return nullptr;
+        FrameJob* job = pending.front();
+        pending.pop_front();
+        return job;
+    }
+
+    void release(FrameJob* job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeJobs.push_back(job);
+        freeReady.notify_one();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        pendingReady.notify_all();
+    }
+
+private:
+    std::vector<FrameJob> storage;
+    std::deque<FrameJob*> freeJobs;
+    std::deque<FrameJob*> pending;
+    std::mutex mutex;
+    std::condition_variable freeReady;
+    std::condition_variable pendingReady;
+    bool closed = false;
+};
+
+void captureDrawData(const ImDrawData* drawData, int index, FrameJob& job) {
+    job.index = index;
+    job.vertices.clear();
+    job.indices.clear();
+    job.commands.clear();
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList* list = drawData->CmdLists[n];
+        unsigned int vertexBase = static_cast<unsigned int>(job.vertices.size());
+        unsigned int indexBase = static_cast<unsigned int>(job.indices.size());
+        job.vertices.insert(job.vertices.end(), list->VtxBuffer.begin(), list->VtxBuffer.end());
+        job.indices.insert(job.indices.end(), list->IdxBuffer.begin(), list->IdxBuffer.end());
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            if (cmd.UserCallback != nullptr) continue; // Only the GL backend knows what to do with these
+            ImVec4 clip(cmd.ClipRect.x - drawData->DisplayPos.x, cmd.ClipRect.y - drawData->DisplayPos.y,
+                cmd.ClipRect.z - drawData->DisplayPos.x, cmd.ClipRect.w - drawData->DisplayPos.y);
+            job.commands.push_back({ clip, vertexBase + cmd.VtxOffset, indexBase + cmd.IdxOffset, cmd.ElemCount, cmd.GetTexID() });
+        }
+    }
+}
+
+// Bounding-box rasterizer for ImGui triangles: edge functions over the
+// bounding box, interpolated colour and UV, nearest font texel, alpha blend.
+class SoftwareRasterizer {
+public:
+    void render(const FrameJob& job, const FontTexture& font, int width, int height) {
+        this->width = width;
+        this->height = height;
+        pixels.resize(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            std::copy(CLEAR_COLOR, CLEAR_COLOR + 4, &pixels[i]);
+        }
+
+        for (const DrawCommand& cmd : job.commands) {
+            if (cmd.texture != FONT_TEXTURE) continue; // GL textures such as the 3D view do not exist here
+            int clipX0 = std::max(0, static_cast<int>(std::floor(cmd.clipRect.x)));
+            int clipY0 = std::max(0, static_cast<int>(std::floor(cmd.clipRect.y)));
+            int clipX1 = std::min(width, static_cast<int>(std::ceil(cmd.clipRect.z)));
+            int clipY1 = std::min(height, static_cast<int>(std::ceil(cmd.clipRect.w)));
+            if (clipX0 >= clipX1 || clipY0 >= clipY1) continue;
+
+            const ImDrawIdx* indices = &job.indices[cmd.indexOffset];
+            const ImDrawVert* vertices = &job.vertices[cmd.vertexOffset];
+            for (unsigned int i = 0; i + 2 < cmd.elementCount; i += 3) {
+                triangle(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]],
+                    clipX0, clipY0, clipX1, clipY1, font);
+            }
+        }
+    }
+
+    const uint8_t* data() const { return pixels.data(); }
+
+private:
+    struct Edge {
+        float a, b, c;   // w(x, y) = a * x + b * y + c
+        bool inclusive;  // Owns pixels exactly on the edge, so shared edges are drawn once
+    };
+
+    static Edge makeEdge(const ImVec2& from, const ImVec2& to) {
+        float dx = to.x - from.x, dy = to.y - from.y;
+        return { -dy, dx, dy * from.x - dx * from.y, dy > 0.0f || (dy == 0.0f && dx > 0.0f) };
+    }
+
+    static bool inside(float w, const Edge& edge) {
+        return w > 0.0f || (w == 0.0f && edge.inclusive);
+    }
+
+    void triangle(const ImDrawVert& v0, ImDrawVert v1, ImDrawVert v2,
+        int clipX0, int clipY0, int clipX1, int clipY1, const FontTexture& font) {
+        float area = (v1.pos.x - v0.pos.x) * (v2.pos.y - v0.pos.y) - (v1.pos.y - v0.pos.y) * (v2.pos.x - v0.pos.x);
+        if (area == 0.0f) return;
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        int x0 = std::max(clipX0, static_cast<int>(std::floor(std::min({ v0.pos.x, v1.pos.x, v2.pos.x }))));
+        int y0 = std::max(clipY0, static_cast<int>(std::floor(std::min({ v0.pos.y, v1.pos.y, v2.pos.y }))));
+        int x1 = std::min(clipX1, static_cast<int>(std::ceil(std::max({ v0.pos.x, v1.pos.x, v2.pos.x }))));
+        int y1 = std::min(clipY1, static_cast<int>(std::ceil(std::max({ v0.pos.y, v1.pos.y, v2.pos.y }))));
+        if (x0 >= x1 || y0 >= y1) return;
+
+        // Weight of vertex k comes from the edge opposite to it
+        Edge e0 = makeEdge(v1.pos, v2.pos), e1 = makeEdge(v2.pos, v0.pos), e2 = makeEdge(v0.pos, v1.pos);
+        float inverseArea = 1.0f / area;
+        bool flat = v0.col == v1.col && v1.col == v2.col
+            && v0.uv.x == v1.uv.x && v1.uv.x == v2.uv.x && v0.uv.y == v1.uv.y && v1.uv.y == v2.uv.y;
+        float flatColor[4];
+        if (flat) shade(v0, v1, v2, 1.0f, 0.0f, 0.0f, font, flatColor); // Solid fills: one colour for the whole triangle
+
+        for (int y = y0; y < y1; y++) {
+            float py = y + 0.5f;
+            float w0 = e0.a * (x0 + 0.5f) + e0.b * py + e0.c;
+            float w1 = e1.a * (x0 + 0.5f) + e1.b * py + e1.c;
+            float w2 = e2.a * (x0 + 0.5f) + e2.b * py + e2.c;
+            uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x0) * 4];
+            for (int x = x0; x < x1; x++, pixel += 4, w0 += e0.a, w1 += e1.a, w2 += e2.a) {
+                if (!inside(w0, e0) || !inside(w1, e1) || !inside(w2, e2)) continue;
+                float color[4];
+                if (flat) std::copy(flatColor, flatColor + 4, color);
+                else shade(v0, v1, v2, w0 * inverseArea, w1 * inverseArea, w2 * inverseArea, font, color);
+                blend(pixel, color);
+            }
+        }
+    }
+
+    static void shade(const ImDrawVert& v0, const ImDrawVert& v1, const ImDrawVert& v2,
+        float l0, float l1, float l2, const FontTexture& font, float* color) {
+        for (int c = 0; c < 4; c++) {
+            int shift = c * 8; // IM_COL32 packs R in the low byte
+            color[c] = l0 * ((v0.col >> shift) & 0xFF) + l1 * ((v1.col >> shift) & 0xFF) + l2 * ((v2.col >> shift) & 0xFF);
+        }
+        float u = l0 * v0.uv.x + l1 * v1.uv.x + l2 * v2.uv.x;
+        float v = l0 * v0.uv.y + l1 * v1.uv.y + l2 * v2.uv.y;
+        int tx = std::min(font.width - 1, std::max(0, static_cast<int>(u * font.width)));
+        int ty = std::min(font.height - 1, std::max(0, static_cast<int>(v * font.height)));
+        color[3] *= font.alpha[ty * font.width + tx] / 255.0f;
+    }
+
+    static void blend(uint8_t* pixel, const float* color) {
+        float alpha = color[3] / 255.0f;
+        for (int c = 0; c < 3; c++) {
+            pixel[c] = static_cast<uint8_t>(color[c] * alpha + pixel[c] * (1.0f - alpha) + 0.5f);
+        }
+        pixel[3] = static_cast<uint8_t>(color[3] + pixel[3] * (1.0f - alpha) + 0.5f);
+    }
+
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+};
+
+}
+
+int RunOffscreenRender(const OffscreenOptions& options, const DashboardHooks& dashboard) {
+    if (dashboard.flight == nullptr || dashboard.buildFrame == nullptr) {
+        std::cerr << "Offscreen rendering needs the dashboard" << std::endl;
+        return -1;
+    }
+    if (!(options.duration > 0.0f) || !(options.timeStep > 0.0f) || !(options.frameInterval > 0.0f)
+        || options.width <= 0 || options.height <= 0) {
+        std::cerr << "Offscreen rendering needs a positive duration, timestep, frame interval and size" << std::endl;
+        return -1;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(options.outputDir, error);
+    if (error) {
+        std::cerr << "Cannot create " << options.outputDir << ": " << error.message() << std::endl;
+        return -1;
+    }
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr; // Same layout on every build machine
+    io.DisplaySize = ImVec2(static_cast<float>(options.width), static_cast<float>(options.height));
+    io.DeltaTime = options.frameInterval;
+    ImGui::StyleColorsDark();
+    FontTexture font;
+    unsigned char* fontPixels = nullptr;
+    io.Fonts->GetTexDataAsAlpha8(&fontPixels, &font.width, &font.height);
+    font.alpha = fontPixels;
+    io.Fonts->SetTexID(FONT_TEXTURE);
+
+    int workerCount = options.workers > 0 ? options.workers : static_cast<int>(std::thread::hardware_concurrency());
+    if (workerCount < 1) workerCount = 1;
+    FrameQueue queue(static_cast<size_t>(workerCount) * JOBS_PER_WORKER);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back([&] {
+            SoftwareRasterizer rasterizer;
+            PngEncoder encoder;
+            char path[1024];
+            while (FrameJob* job = queue.take()) {
+                rasterizer.render(*job, font, options.width, options.height);
+                std::snprintf(path, sizeof(path), "%s/frame_%05d.png", options.outputDir, job->index);
+                if (!encoder.write(path, rasterizer.data(), options.width, options.height)) {
+                    failures++;
+                }
+                queue.release(job);
+            }
+        });
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    FlightState& flight = *dashboard.flight;
+    LaunchFlight(flight, 0.0f);
+
+    int frames = 0;
+    auto renderFrame = [&](float currentTime) {
+        ImGui::NewFrame();
+        dashboard.buildFrame(currentTime);
+        ImGui::Render();
+        FrameJob* job = queue.acquire();
+        captureDrawData(ImGui::GetDrawData(), frames++, *job);
+        queue.submit(job);
+    };
+
+    renderFrame(0.0f);
+    float nextFrame = options.frameInterval;
+    long steps = static_cast<long>(options.duration / options.timeStep);
+    for (long step = 1; step <= steps; step++) {
+        float currentTime = step * options.timeStep;
+        UpdateFlight(flight, currentTime, options.timeStep);
+        if (dashboard.afterStep != nullptr) dashboard.afterStep(currentTime);
+        if (currentTime + options.timeStep * 0.5f >= nextFrame) {
+            renderFrame(currentTime);
+            nextFrame += options.frameInterval;
+        }
+    }
+
+    queue.close();
+    for (std::thread& worker : workers) worker.join();
+    ImGui::DestroyContext();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "Wrote " << frames - failures << " of " << frames << " frames to " << options.outputDir
+        << " in " << seconds << " s with " << workerCount << " workers" << std::endl;
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,29 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+struct FlightState;
+
+struct OffscreenOptions {
+    const char* outputDir = "frames";
+    float duration = 60.0f;         // Simulated seconds, countdown included
+    float timeStep = 1.0f / 60.0f;  // Fixed physics step (s)
+    float frameInterval = 0.5f;     // Simulated seconds between two images
+    int width = 2660;               // Wide enough for the side window at x = 2000
+    int height = 720;
+    int workers = 0;                // Rasterizer/encoder threads, 0 = one per core
+};
+
+// What a replay needs from the GUI so it renders the same dashboard as the window
+struct DashboardHooks {
+    FlightState* flight = nullptr;                   // The state the dashboard shows
+    void (*afterStep)(float currentTime) = nullptr;  // Runs after every physics step, e.g. telemetry
+    void (*buildFrame)(float currentTime) = nullptr; // Lays out one ImGui frame
+};
+
+// Replays a launch with a fixed step and writes the dashboard as a PNG
+// sequence, without a window or GL context. The main thread builds the ImGui
+// frames; worker threads rasterize the draw data in software and encode the
+// images, a few frames in flight per worker.
+int RunOffscreenRender(const OffscreenOptions& options, const DashboardHooks& dashboard);
+
+#endif
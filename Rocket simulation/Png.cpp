@@ -0,0 +1,234 @@
+#include "Png.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const int WINDOW_SIZE = 32768;
+const int MIN_MATCH = 3;
+const int MAX_MATCH = 258;
+const int HASH_BITS = 15;
+
+const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Code index for every match length, built once
+const std::array<uint8_t, MAX_MATCH + 1>& lengthCodes() {
+    static const std::array<uint8_t, MAX_MATCH + 1> table = [] {
+        std::array<uint8_t, MAX_MATCH + 1> codes{};
+        for (int code = 0; code < 29; code++) {
+            int end = code + 1 < 29 ? LENGTH_BASE[code + 1] : MAX_MATCH + 1;
+            for (int length = LENGTH_BASE[code]; length < end; length++) codes[length] = static_cast<uint8_t>(code);
+        }
+        return codes;
+    }();
+    return table;
+}
+
+int distanceCode(int distance) {
+    int code = 0;
+    while (code < 29 && DISTANCE_BASE[code + 1] <= distance) code++;
+    return code;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t adler32(const uint8_t* data, size_t size) {
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        size_t block = size < 5552 ? size : 5552; // Largest run before the sums can overflow
+        for (size_t i = 0; i < block; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += block;
+        size -= block;
+    }
+    return (b << 16) | a;
+}
+
+// Deflate packs bits LSB first; Huffman codes go in MSB first
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void bits(uint32_t value, int count) {
+        buffer |= static_cast<uint64_t>(value) << used;
+        used += count;
+        while (used >= 8) {
+            out.push_back(static_cast<uint8_t>(buffer));
+            buffer >>= 8;
+            used -= 8;
+        }
+    }
+
+    void huffman(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+        bits(reversed, length);
+    }
+
+    void flush() {
+        if (used > 0) out.push_back(static_cast<uint8_t>(buffer));
+        buffer = 0;
+        used = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t buffer = 0;
+    int used = 0;
+};
+
+// Fixed Huffman literal/length alphabet from RFC 1951 3.2.6
+void writeSymbol(BitWriter& writer, int symbol) {
+    if (symbol < 144) writer.huffman(0x30 + symbol, 8);
+    else if (symbol < 256) writer.huffman(0x190 + symbol - 144, 9);
+    else if (symbol < 280) writer.huffman(symbol - 256, 7);
+    else writer.huffman(0xC0 + symbol - 280, 8);
+}
+
+void deflateFixed(const uint8_t* data, size_t size, std::vector<int32_t>& table, BitWriter& writer) {
+    const std::array<uint8_t, MAX_MATCH + 1>& codes = lengthCodes();
+    table.assign(size_t(1) << HASH_BITS, -1);
+    writer.bits(1, 1); // Final block
+    writer.bits(1, 2); // Fixed Huffman codes
+
+    auto hash = [data](size_t at) {
+        uint32_t v = data[at] | (data[at + 1] << 8) | (data[at + 2] << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        int length = 0;
+        int distance = 0;
+        if (i + MIN_MATCH <= size) {
+            uint32_t h = hash(i);
+            int32_t candidate = table[h];
+            table[h] = static_cast<int32_t>(i);
+            if (candidate >= 0 && i - candidate <= WINDOW_SIZE) {
+                size_t limit = size - i < MAX_MATCH ? size - i : MAX_MATCH;
+                const uint8_t* a = data + candidate;
+                const uint8_t* b = data + i;
+                while (static_cast<size_t>(length) < limit && a[length] == b[length]) length++;
+                distance = static_cast<int>(i - candidate);
+            }
+        }
+
+        if (length >= MIN_MATCH) {
+            int lengthCode = codes[length];
+            writeSymbol(writer, 257 + lengthCode);
+            writer.bits(length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+            int code = distanceCode(distance);
+            writer.huffman(code, 5);
+            writer.bits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+            // Index the skipped positions too, runs keep finding themselves
+            for (size_t j = i + 1; j < i + length && j + MIN_MATCH <= size; j++) table[hash(j)] = static_cast<int32_t>(j);
+            i += length;
+        }
+        else {
+            writeSymbol(writer, data[i]);
+            i++;
+        }
+    }
+    writeSymbol(writer, 256); // End of block
+    writer.flush();
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Chunk length is patched in once the payload is written
+size_t beginChunk(std::vector<uint8_t>& out, const char* type) {
+    size_t start = out.size();
+    putBigEndian(out, 0);
+    out.insert(out.end(), type, type + 4);
+    return start;
+}
+
+void endChunk(std::vector<uint8_t>& out, size_t start) {
+    uint32_t length = static_cast<uint32_t>(out.size() - start - 8);
+    for (int i = 0; i < 4; i++) out[start + i] = static_cast<uint8_t>(length >> (24 - 8 * i));
+    putBigEndian(out, crc32(&out[start + 4], length + 4));
+}
+
+}
+
+const std::vector<uint8_t>& PngEncoder::encode(const uint8_t* rgba, int width, int height) {
+    // Filter byte 1 (Sub) per row: each byte minus the same channel one pixel left
+    size_t stride = static_cast<size_t>(width) * 3 + 1;
+    filtered.resize(stride * height);
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = &filtered[stride * y];
+        const uint8_t* source = rgba + static_cast<size_t>(width) * 4 * y;
+        row[0] = 1;
+        uint8_t previous[3] = { 0, 0, 0 };
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                uint8_t value = source[x * 4 + c];
+                row[1 + x * 3 + c] = static_cast<uint8_t>(value - previous[c]);
+                previous[c] = value;
+            }
+        }
+    }
+
+    png.clear();
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.insert(png.end(), SIGNATURE, SIGNATURE + 8);
+
+    size_t header = beginChunk(png, "IHDR");
+    putBigEndian(png, static_cast<uint32_t>(width));
+    putBigEndian(png, static_cast<uint32_t>(height));
+    const uint8_t format[5] = { 8, 2, 0, 0, 0 }; // 8-bit RGB, deflate, adaptive filters, no interlace
+    png.insert(png.end(), format, format + 5);
+    endChunk(png, header);
+
+    size_t data = beginChunk(png, "IDAT");
+    png.push_back(0x78); // zlib header: deflate, 32K window
+    png.push_back(0x01);
+    BitWriter writer(png);
+    deflateFixed(filtered.data(), filtered.size(), matchTable, writer);
+    putBigEndian(png, adler32(filtered.data(), filtered.size()));
+    endChunk(png, data);
+
+    size_t end = beginChunk(png, "IEND");
+    endChunk(png, end);
+    return png;
+}
+
+bool PngEncoder::write(const char* path, const uint8_t* rgba, int width, int height) {
+    const std::vector<uint8_t>& bytes = encode(rgba, width, height);
+    std::FILE* file = std::fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && written;
+}
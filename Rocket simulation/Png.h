@@ -0,0 +1,24 @@
+#ifndef PNG_H
+#define PNG_H
+
+#include <cstdint>
+#include <vector>
+
+// Minimal PNG encoder for screenshots: 8-bit RGB, Sub-filtered rows, deflate
+// with fixed Huffman codes and a single-probe LZ77 matcher. Flat dashboard
+// backgrounds compress well with that and it needs no zlib. The output
+// buffer is reused, so an encoder per worker thread stops allocating after
+// the first frame.
+class PngEncoder {
+public:
+    // rgba is width * height * 4 bytes, alpha is dropped
+    const std::vector<uint8_t>& encode(const uint8_t* rgba, int width, int height);
+    bool write(const char* path, const uint8_t* rgba, int width, int height);
+
+private:
+    std::vector<uint8_t> filtered; // Sub-filtered scanlines, the deflate input
+    std::vector<uint8_t> png;
+    std::vector<int32_t> matchTable;
+};
+
+#endif
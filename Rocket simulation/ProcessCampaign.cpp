@@ -0,0 +1,335 @@
+#include "ProcessCampaign.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+const long PROCESS_BATCH = 16; // Runs a worker claims at a time, as on threads
+
+#ifdef _WIN32
+bool ReadProcessMemory(ProcessMemory&) {
+    return false;
+}
+
+bool RunProcessCampaign(const Scenario&, const CampaignOptions&, CampaignResult&, ProcessCampaignReport&) {
+    std::cerr << "Worker processes need fork, which Windows lacks; --campaign runs threads sharing one scenario" << std::endl;
+    return false;
+}
+#else
+static_assert(std::atomic<long>::is_always_lock_free && std::atomic<uint8_t>::is_always_lock_free
+    && std::atomic<bool>::is_always_lock_free, "shared between processes");
+
+namespace {
+
+// The writable shared block: this header, one slot per worker, the owner of
+// every batch, then the outcome table, one byte per run
+struct alignas(64) SharedCampaign {
+    std::atomic<long> nextRun{ 0 };
+    std::atomic<bool> stop{ false };
+};
+
+struct alignas(64) WorkerSlot {
+    WorkerStatistics statistics;
+    std::atomic<long> batchFirst{ 0 }, batchLast{ 0 }; // The batch in hand, empty between batches
+    std::atomic<long> flown{ 0 };
+    std::atomic<bool> measured{ false };
+    ProcessMemory memory;       // Written once, before measured
+};
+
+size_t PageRound(size_t bytes) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (bytes + page - 1) / page * page;
+}
+
+void* MapShared(size_t bytes) {
+    void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return view == MAP_FAILED ? nullptr : view;
+}
+
+// PublishStatistics with the batch marker cleared inside the same write: a
+// worker that dies leaves an even sequence with its batch either in the
+// statistics or still marked, never both, or an odd one with neither to trust
+void PublishBatch(WorkerSlot& slot, long first) {
+    WorkerStatistics& worker = slot.statistics;
+    uint32_t sequence = worker.sequence.load(std::memory_order_relaxed);
+    worker.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&worker.published, &worker.local, sizeof(CampaignStatistics));
+    slot.batchLast.store(first, std::memory_order_relaxed);
+    worker.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Claims batches until the runs run out or the parent says stop, then
+// measures itself. Never returns to the caller's stack frames.
+[[noreturn]] void WorkerProcess(const Scenario& scenario, const CampaignOptions& options,
+    SharedCampaign& shared, WorkerSlot& slot, int32_t worker, int32_t* batchOwners, std::atomic<uint8_t>* outcomes) {
+    const long maxRuns = options.maxRuns;
+    while (!shared.stop.load(std::memory_order_relaxed)) {
+        long first = shared.nextRun.fetch_add(PROCESS_BATCH, std::memory_order_relaxed);
+        if (first >= maxRuns) break;
+        long last = std::min(first + PROCESS_BATCH, maxRuns);
+        batchOwners[first / PROCESS_BATCH] = worker;
+        slot.batchFirst.store(first, std::memory_order_relaxed);
+        slot.batchLast.store(last, std::memory_order_release);
+        for (long run = first; run < last && !shared.stop.load(std::memory_order_relaxed); run++) {
+            RunOutcome outcome = FlyCampaignRun(scenario, static_cast<uint32_t>(run), options.timeStep, options.duration);
+            slot.statistics.local.add(outcome);
+            outcomes[run].store(RunFlagsOf(outcome), std::memory_order_release);
+            slot.flown.fetch_add(1, std::memory_order_relaxed);
+        }
+        PublishBatch(slot, first);
+    }
+    ReadProcessMemory(slot.memory);
+    slot.measured.store(true, std::memory_order_release);
+    _exit(0); // Skip the parent's exit handlers and its buffered output
+}
+
+}
+
+bool ReadProcessMemory(ProcessMemory& memory) {
+    memory = ProcessMemory();
+    std::ifstream rollup("/proc/self/smaps_rollup");
+    std::string line;
+    bool found = false;
+    while (std::getline(rollup, line)) {
+        long kb = 0;
+        if (std::sscanf(line.c_str(), "Rss: %ld", &kb) == 1) memory.rssKb = kb;
+        else if (std::sscanf(line.c_str(), "Pss: %ld", &kb) == 1) memory.pssKb = kb;
+        else if (std::sscanf(line.c_str(), "Private_Clean: %ld", &kb) == 1) memory.privateKb += kb;
+        else if (std::sscanf(line.c_str(), "Private_Dirty: %ld", &kb) == 1) memory.privateKb += kb;
+        else continue;
+        found = true;
+    }
+    return found;
+}
+
+bool RunProcessCampaign(const Scenario& scenario, const CampaignOptions& options,
+    CampaignResult& result, ProcessCampaignReport& report) {
+    result = CampaignResult();
+    report = ProcessCampaignReport();
+    const RunOutcome nominal = FlyNominalRun(scenario, options.timeStep, options.duration);
+    SetHistogramRanges(result.statistics, nominal);
+    const long maxRuns = options.maxRuns;
+    const double z = NormalQuantile(options.confidence);
+    int workerCount = options.workers > 0 ? options.workers : static_cast<int>(std::thread::hardware_concurrency());
+    if (workerCount < 1) workerCount = 1;
+
+    // The one copy of the scenario, read-only from here on in every process
+    report.scenarioBytes = PageRound(sizeof(Scenario));
+    void* scenarioView = MapShared(report.scenarioBytes);
+    if (scenarioView == nullptr) {
+        std::cerr << "Cannot map the shared scenario" << std::endl;
+        return false;
+    }
+    std::memcpy(scenarioView, &scenario, sizeof(Scenario));
+    mprotect(scenarioView, report.scenarioBytes, PROT_READ);
+    const Scenario& sharedScenario = *static_cast<const Scenario*>(scenarioView);
+
+    size_t slotsOffset = sizeof(SharedCampaign);
+    size_t batchCount = static_cast<size_t>((maxRuns + PROCESS_BATCH - 1) / PROCESS_BATCH);
+    size_t ownersOffset = slotsOffset + workerCount * sizeof(WorkerSlot);
+    size_t outcomesOffset = ownersOffset + batchCount * sizeof(int32_t);
+    report.sharedBytes = PageRound(outcomesOffset + static_cast<size_t>(maxRuns));
+    char* block = static_cast<char*>(MapShared(report.sharedBytes));
+    if (block == nullptr) {
+        std::cerr << "Cannot map " << report.sharedBytes << " bytes of shared campaign state" << std::endl;
+        munmap(scenarioView, report.scenarioBytes);
+        return false;
+    }
+    SharedCampaign& shared = *new (block) SharedCampaign();
+    WorkerSlot* slots = reinterpret_cast<WorkerSlot*>(block + slotsOffset);
+    int32_t* batchOwners = reinterpret_cast<int32_t*>(block + ownersOffset); // Read only once the owner is gone
+    std::fill(batchOwners, batchOwners + batchCount, -1);
+    std::atomic<uint8_t>* outcomes = reinterpret_cast<std::atomic<uint8_t>*>(block + outcomesOffset);
+    for (long run = 0; run < maxRuns; run++) new (&outcomes[run]) std::atomic<uint8_t>(0);
+    for (int i = 0; i < workerCount; i++) {
+        WorkerSlot& slot = *new (&slots[i]) WorkerSlot();
+        SetHistogramRanges(slot.statistics.local, nominal);
+        slot.statistics.published = slot.statistics.local;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // Unflushed output would be written again by every child
+    std::cout.flush();
+    std::fflush(nullptr);
+    std::vector<pid_t> children(static_cast<size_t>(workerCount), -1);
+    report.workers.resize(static_cast<size_t>(workerCount));
+    int alive = 0;
+    for (int i = 0; i < workerCount; i++) {
+        pid_t pid = fork();
+        if (pid == 0) WorkerProcess(sharedScenario, options, shared, slots[i], i, batchOwners, outcomes);
+        if (pid < 0) {
+            std::cerr << "Cannot fork worker " << i + 1 << ", going on with " << alive << std::endl;
+            report.workers[i].lost = true;
+            continue;
+        }
+        children[i] = pid;
+        alive++;
+    }
+
+    // Fold finished runs in order, as RunCampaign does. A lost worker's batch
+    // is flown here; with no worker left the parent flies the gaps itself.
+    CampaignStatistics recovered;
+    SetHistogramRanges(recovered, nominal);
+    auto flyHere = [&](long run) {
+        RunOutcome outcome = FlyCampaignRun(sharedScenario, static_cast<uint32_t>(run), options.timeStep, options.duration);
+        recovered.add(outcome);
+        report.recoveredRuns++;
+        uint8_t unfinished = 0;
+        outcomes[run].compare_exchange_strong(unfinished, RunFlagsOf(outcome), std::memory_order_acq_rel);
+    };
+    // A lost worker's statistics count if it died between publishes; then only
+    // the batch still marked is missing. Dying within a publish tears them, so
+    // every batch it claimed is flown again instead.
+    std::vector<bool> torn(static_cast<size_t>(workerCount), false);
+    auto recoverWorker = [&](int worker) {
+        WorkerSlot& slot = slots[worker];
+        report.workers[worker].lost = true;
+        if (slot.statistics.sequence.load(std::memory_order_acquire) & 1) {
+            torn[worker] = true;
+            for (size_t batch = 0; batch < batchCount; batch++) {
+                if (batchOwners[batch] != worker) continue;
+                long last = std::min(static_cast<long>(batch + 1) * PROCESS_BATCH, maxRuns);
+                for (long run = static_cast<long>(batch) * PROCESS_BATCH; run < last; run++) flyHere(run);
+            }
+            return;
+        }
+        long last = slot.batchLast.load(std::memory_order_acquire);
+        for (long run = slot.batchFirst.load(std::memory_order_relaxed); run < last; run++) flyHere(run);
+    };
+    auto lastProgress = start;
+    CampaignStatistics scratch;
+    while (result.runs < maxRuns && !result.stoppedEarly) {
+        if (options.cancel != nullptr && options.cancel->load(std::memory_order_relaxed)) {
+            result.cancelled = true;
+            break;
+        }
+        for (int i = 0; i < workerCount; i++) {
+            int status = 0;
+            if (children[i] <= 0 || waitpid(children[i], &status, WNOHANG) != children[i]) continue;
+            children[i] = -1;
+            alive--;
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+            recoverWorker(i);
+        }
+        uint8_t flags;
+        while (result.runs < maxRuns) {
+            flags = outcomes[result.runs].load(std::memory_order_acquire);
+            if (flags == 0 && alive == 0) {
+                flyHere(result.runs);
+                flags = outcomes[result.runs].load(std::memory_order_acquire);
+            }
+            if (flags == 0) break;
+            if (CountRun(result, flags, options, z)) {
+                result.stoppedEarly = true;
+                break;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (options.progress != nullptr && now - lastProgress >= std::chrono::seconds(1) && result.runs > 0) {
+            result.probability = double(result.successes) / result.runs;
+            result.statistics = recovered;
+            for (int i = 0; i < workerCount; i++) MergePublished(slots[i].statistics, result.statistics, scratch);
+            options.progress(result, options.progressContext);
+            lastProgress = now;
+        }
+        if (result.runs < maxRuns && !result.stoppedEarly) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ReadProcessMemory(report.parent);
+    shared.stop.store(true, std::memory_order_relaxed);
+    for (int i = 0; i < workerCount; i++) {
+        int status = 0;
+        if (children[i] <= 0) continue;
+        if (waitpid(children[i], &status, 0) == children[i] && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            recoverWorker(i);
+        }
+    }
+
+    // Everyone is done: merge the statistics each worker last published. A
+    // worker publishes after every batch, so a lost one's finished batches
+    // are in, and its unfinished one was flown into recovered; a torn one
+    // was flown into recovered whole.
+    result.statistics = recovered;
+    result.simulated = report.recoveredRuns;
+    for (int i = 0; i < workerCount; i++) {
+        WorkerSlot& slot = slots[i];
+        if (!torn[i]) result.statistics.merge(slot.statistics.published);
+        result.simulated += slot.flown.load(std::memory_order_relaxed);
+        report.workers[i].flown = slot.flown.load(std::memory_order_relaxed);
+        if (slot.measured.load(std::memory_order_acquire)) report.workers[i].memory = slot.memory;
+    }
+    result.probability = result.runs > 0 ? double(result.successes) / result.runs : 0.0;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    munmap(block, report.sharedBytes);
+    munmap(scenarioView, report.scenarioBytes);
+    return true;
+}
+#endif
+
+static void PrintProgress(const CampaignResult& sofar, void*) {
+    std::cout << "  " << sofar.runs << " runs, success " << sofar.probability
+        << " [" << sofar.low << ", " << sofar.high << "]";
+    if (sofar.statistics.apogee.digest.weight > 0.0) { // Empty, and its median NaN, until a worker publishes
+        std::cout << ", median apogee " << sofar.statistics.apogee.digest.quantile(0.5) << " m";
+    }
+    std::cout << std::endl;
+}
+
+static void PrintMemoryRow(const std::string& name, long runs, const ProcessMemory& memory) {
+    std::cout << std::setw(12) << std::left << name << std::right << std::setw(10) << runs
+        << std::setw(10) << memory.rssKb << std::setw(10) << memory.pssKb << std::setw(10) << memory.privateKb << std::endl;
+}
+
+int RunProcessCampaignMode(const CampaignOptions& options) {
+    if (options.maxRuns <= 0 || options.minRuns < 0 || !(options.confidence > 0.0 && options.confidence < 1.0)
+        || !(options.halfWidth >= 0.0) || !(options.duration > 0.0f) || !(options.timeStep > 0.0f)) {
+        std::cerr << "Campaign needs runs, a confidence in (0, 1), a half-width, a duration and a timestep" << std::endl;
+        return -1;
+    }
+    const Scenario& scenario = ActiveScenario();
+    std::cout << "Campaign on worker processes: " << scenario.name << ", up to " << options.maxRuns << " runs";
+    if (options.halfWidth > 0.0) std::cout << ", stopping at +/-" << options.halfWidth;
+    std::cout << " (" << options.confidence * 100.0 << "% interval)" << std::endl;
+
+    CampaignOptions reporting = options;
+    reporting.progress = PrintProgress;
+    CampaignResult result;
+    ProcessCampaignReport report;
+    if (!RunProcessCampaign(scenario, reporting, result, report)) return -1;
+    PrintCampaignResult(result);
+
+    std::cout << "Memory (kB):" << std::endl;
+    std::cout << std::setw(12) << std::left << "process" << std::right << std::setw(10) << "runs"
+        << std::setw(10) << "RSS" << std::setw(10) << "PSS" << std::setw(10) << "private" << std::endl;
+    long totalPss = report.parent.pssKb, workerPrivate = 0, measured = 0;
+    PrintMemoryRow("parent", report.recoveredRuns, report.parent);
+    for (size_t i = 0; i < report.workers.size(); i++) {
+        const WorkerProcessReport& worker = report.workers[i];
+        PrintMemoryRow("worker " + std::to_string(i + 1) + (worker.lost ? "*" : ""), worker.flown, worker.memory);
+        totalPss += worker.memory.pssKb;
+        workerPrivate += worker.memory.privateKb;
+        if (worker.memory.rssKb > 0) measured++;
+    }
+    std::cout << "Total PSS " << totalPss << " kB; each worker adds " << (measured > 0 ? workerPrivate / measured : 0)
+        << " kB private on average" << std::endl;
+    std::cout << "Scenario: one read-only copy of " << report.scenarioBytes << " bytes shared by all; "
+        << report.sharedBytes << " bytes of shared campaign state" << std::endl;
+    if (report.recoveredRuns > 0) {
+        std::cout << report.recoveredRuns << " runs of lost workers (*) flown again by the parent" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef PROCESS_CAMPAIGN_H
+#define PROCESS_CAMPAIGN_H
+
+#include "Campaign.h"
+#include <cstddef>
+#include <vector>
+
+// A campaign on forked worker processes instead of threads. The scenario is
+// loaded once, copied into a shared read-only mapping and the workers are
+// forked after it, so every worker reads the same physical pages: nothing is
+// loaded, parsed or copied per worker, and a worker that wrote to it by
+// mistake would fault instead of quietly taking a private copy. The outcome
+// table and each worker's statistics live in a shared writable mapping and
+// are folded in run order exactly as RunCampaign does, so the estimate is the
+// same as on threads.
+//
+// A worker that dies has its unfinished batch flown by the parent. POSIX
+// only: there is no fork on Windows, where --campaign threads share the
+// scenario anyway.
+
+// Memory of one process, from /proc/self/smaps_rollup
+struct ProcessMemory {
+    long rssKb = 0;             // Resident, shared pages counted in full
+    long pssKb = 0;             // Resident, shared pages split between their sharers; sums to the true total
+    long privateKb = 0;         // Only this process's pages: what one more worker costs
+};
+
+struct WorkerProcessReport {
+    long flown = 0;             // Runs this worker simulated
+    bool lost = false;          // Died before the end; its batch was flown again
+    ProcessMemory memory;       // Measured as it finished, zero if it never did
+};
+
+struct ProcessCampaignReport {
+    std::vector<WorkerProcessReport> workers;
+    ProcessMemory parent;       // Measured when the fold ends, the workers still alive
+    size_t scenarioBytes = 0;   // The one shared read-only copy
+    size_t sharedBytes = 0;     // Outcome table and statistics slots
+    long recoveredRuns = 0;     // Flown by the parent for lost workers
+};
+
+// False if the process can measure nothing about itself
+bool ReadProcessMemory(ProcessMemory& memory);
+
+// Runs the campaign on options.workers forked processes (0 = one per core).
+// Fork from a single-threaded process. False, with the reason on std::cerr,
+// if the shared mappings cannot be made or on Windows.
+bool RunProcessCampaign(const Scenario& scenario, const CampaignOptions& options,
+    CampaignResult& result, ProcessCampaignReport& report);
+
+// Runs one on the active scenario and prints it like --campaign, followed by
+// the memory of every process
+int RunProcessCampaignMode(const CampaignOptions& options);
+
+#endif
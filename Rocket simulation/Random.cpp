@@ -0,0 +1,87 @@
+#include "Random.h"
+#include <cmath>
+#include <cstring>
+
+const float TWO_PI_F = 6.28318530717958647692f;
+
+// Box-Muller's log, sin and cos in straight-line float code (the fdlibm/Cephes
+// kernels, within an ulp or two) instead of libm calls, which most compilers
+// will not vectorize. This also keeps the normals the same on every platform.
+
+// ln(x) for a normal float x > 0
+static inline float LogPositive(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    // x = 2^k * m with m in [sqrt(1/2), sqrt(2))
+    bits += 0x3F800000u - 0x3F3504F3u;
+    float k = static_cast<float>(static_cast<int32_t>(bits >> 23) - 0x7F);
+    bits = (bits & 0x007FFFFFu) + 0x3F3504F3u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+
+    float f = m - 1.0f;
+    float s = f / (2.0f + f);
+    float z = s * s;
+    float w = z * z;
+    float r = z * (0.66666662693f + w * 0.28498786688f) + w * (0.40000972152f + w * 0.24279078841f);
+    float halfSquare = 0.5f * f * f;
+    return s * (halfSquare + r) + k * 9.0580006145e-06f - halfSquare + f + k * 6.9313812256e-01f;
+}
+
+// sin and cos of 2 pi u for u in [0, 1]: the nearest quarter turn is taken
+// out exactly and the rest, within pi / 4, goes through the polynomials
+static inline void SinCosTurn(float u, float& sine, float& cosine) {
+    int quadrant = static_cast<int>(4.0f * u + 0.5f);
+    float x = TWO_PI_F * (u - 0.25f * static_cast<float>(quadrant));
+    float z = x * x;
+    float s = x + x * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+    float c = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+    int turn = quadrant & 3;
+    float swappedSine = (turn & 1) ? c : s;
+    float swappedCosine = (turn & 1) ? s : c;
+    sine = (turn & 2) ? -swappedSine : swappedSine;
+    cosine = ((turn + 1) & 2) ? -swappedCosine : swappedCosine;
+}
+
+void PhiloxUniforms(uint64_t seed, uint32_t channel, uint64_t counter,
+    size_t count, const uint32_t* streams, float* out) {
+    const uint32_t key0 = uint32_t(seed);
+    const uint32_t key1 = uint32_t(seed >> 32);
+    float* __restrict u0 = out;
+    float* __restrict u1 = out + count;
+    float* __restrict u2 = out + 2 * count;
+    float* __restrict u3 = out + 3 * count;
+
+    // Integer rounds lane by lane, then the top 24 bits plus half a step, so
+    // no uniform is exactly 0 or 1
+    for (size_t i = 0; i < count; i++) {
+        uint32_t block[4] = { streams[i], channel, uint32_t(counter), uint32_t(counter >> 32) };
+        Philox4x32(block, key0, key1);
+        u0[i] = (float(block[0] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+        u1[i] = (float(block[1] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+        u2[i] = (float(block[2] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+        u3[i] = (float(block[3] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+    }
+}
+
+void PhiloxNormals(uint64_t seed, uint32_t channel, uint64_t counter,
+    size_t count, const uint32_t* streams, float* out) {
+    PhiloxUniforms(seed, channel, counter, count, streams, out);
+    float* __restrict u0 = out;
+    float* __restrict u1 = out + count;
+    float* __restrict u2 = out + 2 * count;
+    float* __restrict u3 = out + 3 * count;
+
+    // Box-Muller, two normals from each pair of uniforms
+    for (size_t i = 0; i < count; i++) {
+        float radius01 = std::sqrt(-2.0f * LogPositive(u0[i]));
+        float radius23 = std::sqrt(-2.0f * LogPositive(u2[i]));
+        float sine01, cosine01, sine23, cosine23;
+        SinCosTurn(u1[i], sine01, cosine01);
+        SinCosTurn(u3[i], sine23, cosine23);
+        u0[i] = radius01 * cosine01;
+        u1[i] = radius01 * sine01;
+        u2[i] = radius23 * cosine23;
+        u3[i] = radius23 * sine23;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Counter-based random numbers: Philox4x32-10 (Salmon et al., "Parallel
+// random numbers: as easy as 1, 2, 3", SC11). A draw is a pure function of
+// (seed, stream, channel, counter), so there is no generator state to share
+// or lock: each vehicle is a stream, each noise source a channel, and the
+// counter says which sample it is. Reruns and any thread split give the same
+// numbers.
+
+// Ten rounds over one 128-bit counter block, in place
+inline void Philox4x32(uint32_t counter[4], uint32_t key0, uint32_t key1) {
+    for (int round = 0; round < 10; round++) {
+        uint64_t product0 = uint64_t(0xD2511F53u) * counter[0];
+        uint64_t product1 = uint64_t(0xCD9E8D57u) * counter[2];
+        uint32_t next0 = uint32_t(product1 >> 32) ^ counter[1] ^ key0;
+        uint32_t next2 = uint32_t(product0 >> 32) ^ counter[3] ^ key1;
+        counter[0] = next0;
+        counter[1] = uint32_t(product1);
+        counter[2] = next2;
+        counter[3] = uint32_t(product0);
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+}
+
+// Four uniforms in (0, 1) for each of count streams, from block (channel,
+// counter) of every stream; out is laid out as for PhiloxNormals
+void PhiloxUniforms(uint64_t seed, uint32_t channel, uint64_t counter,
+    size_t count, const uint32_t* streams, float* out);
+
+// Four standard normals for each of count streams, from block (channel,
+// counter) of every stream. out is four arrays of count, one per normal,
+// so a batch of vehicles fills whole vectors at a time.
+void PhiloxNormals(uint64_t seed, uint32_t channel, uint64_t counter,
+    size_t count, const uint32_t* streams, float* out);
+
+#endif
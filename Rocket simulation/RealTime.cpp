@@ -0,0 +1,185 @@
+#include "RealTime.h"
+#include "AllocationTracker.h"
+#include "Flight.h"
+#include "Topology.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#endif
+
+const int LATENCY_BUCKETS = 24; // log2 microseconds, last bucket open-ended
+
+// Absolute deadlines on the monotonic clock. Windows has no clock_nanosleep;
+// sleep_until there is only as fine as the system timer period.
+#ifdef _WIN32
+static uint64_t MonotonicNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void SleepUntilNs(uint64_t deadline) {
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadline)));
+}
+
+static bool EnableRealTimeScheduling(int) {
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+}
+#else
+static uint64_t MonotonicNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+static void SleepUntilNs(uint64_t deadline) {
+    timespec until;
+    until.tv_sec = static_cast<time_t>(deadline / 1000000000ull);
+    until.tv_nsec = static_cast<long>(deadline % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR) {}
+}
+
+// Locks current and future pages first so a page fault cannot stall a step
+static bool EnableRealTimeScheduling(int priority) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::cerr << "mlockall failed: " << std::strerror(errno) << std::endl;
+    }
+    sched_param param;
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+#endif
+
+namespace {
+
+struct LatencyHistogram {
+    uint64_t buckets[LATENCY_BUCKETS] = {};
+
+    void record(uint64_t ns) {
+        uint64_t us = ns / 1000;
+        int bucket = 0;
+        while (us != 0 && bucket < LATENCY_BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        buckets[bucket]++;
+    }
+
+    void print(const char* title) const {
+        std::cout << title << " histogram (us):" << std::endl;
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            if (buckets[i] == 0) continue;
+            uint64_t low = i == 0 ? 0 : 1ull << (i - 1);
+            std::cout << "  [" << std::setw(7) << low << ", ";
+            if (i == LATENCY_BUCKETS - 1) std::cout << std::setw(7) << "inf";
+            else std::cout << std::setw(7) << (1ull << i);
+            std::cout << ")  " << buckets[i] << std::endl;
+        }
+    }
+};
+
+// Sorts in place; only called after the loop
+void PrintPercentiles(const char* title, std::vector<uint32_t>& samples) {
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double fraction) { return samples[static_cast<size_t>(fraction * (samples.size() - 1))] / 1000.0; };
+    std::cout << title << ": p50 " << at(0.5) << " us, p99 " << at(0.99) << " us, p99.9 " << at(0.999)
+        << " us, max " << samples.back() / 1000.0 << " us" << std::endl;
+}
+
+}
+
+int RunRealTime(const RealTimeOptions& options) {
+    if (!(options.duration > options.warmup) || !(options.rate > 0.0f) || options.warmup < 0.0f) {
+        std::cerr << "Real-time run needs a positive rate and a duration longer than the warm-up" << std::endl;
+        return -1;
+    }
+
+    bool pinned = options.cpu >= 0 && PinThreadToCpu(options.cpu);
+    if (options.cpu >= 0 && !pinned) {
+        std::cerr << "Could not pin to CPU " << options.cpu << ", running floating" << std::endl;
+    }
+    bool fifo = options.fifo && EnableRealTimeScheduling(options.priority);
+    if (options.fifo && !fifo) {
+        std::cerr << "Real-time scheduling refused (needs CAP_SYS_NICE), running at normal priority" << std::endl;
+    }
+
+    const float timeStep = 1.0f / options.rate;
+    const uint64_t period = static_cast<uint64_t>(1.0e9 / options.rate);
+    const long steps = static_cast<long>(options.duration * options.rate);
+    const long warmupSteps = static_cast<long>(options.warmup * options.rate);
+
+    // Everything the loop touches is sized up front
+    std::vector<uint32_t> wakeLatency(steps - warmupSteps);
+    std::vector<uint32_t> stepTime(steps - warmupSteps);
+    LatencyHistogram wakeHistogram, stepHistogram;
+    long misses = 0;
+    uint64_t allocationsAtWarmup = 0;
+
+    FlightState flight;
+    LaunchFlight(flight, 0.0f);
+
+    // Deadlines stay on the k * period grid: a late step is counted as a miss
+    // and the following steps run back to back until the loop is on time again
+    const uint64_t origin = MonotonicNs() + period;
+    uint64_t deadline = origin;
+    for (long step = 0; step < steps; step++) {
+        if (step == warmupSteps) allocationsAtWarmup = AllocationTracker::count();
+        SleepUntilNs(deadline);
+        uint64_t woke = MonotonicNs();
+
+        UpdateFlight(flight, (step + 1) * timeStep, timeStep);
+        uint64_t done = MonotonicNs();
+
+        if (step >= warmupSteps) {
+            uint64_t lateness = woke > deadline ? woke - deadline : 0;
+            size_t index = static_cast<size_t>(step - warmupSteps);
+            wakeLatency[index] = static_cast<uint32_t>(std::min<uint64_t>(lateness, UINT32_MAX));
+            stepTime[index] = static_cast<uint32_t>(std::min<uint64_t>(done - woke, UINT32_MAX));
+            wakeHistogram.record(lateness);
+            stepHistogram.record(done - woke);
+            if (done > deadline + period) misses++; // Ran into the next step's slot
+        }
+        deadline += period;
+    }
+    uint64_t stepAllocations = AllocationTracker::count() - allocationsAtWarmup;
+
+    long measured = steps - warmupSteps;
+    std::cout << "Real-time run: " << measured << " steps at " << options.rate << " Hz after "
+        << warmupSteps << " warm-up steps" << std::endl;
+    std::cout << "Scheduling: " << (fifo ? "real-time priority" : "normal priority") << ", "
+        << (pinned ? "pinned to CPU " + std::to_string(options.cpu) : std::string("floating")) << std::endl;
+    std::cout << "Altitude: " << flight.rocket.position.y << " m, fuel " << flight.fuelLevel << " %" << std::endl;
+    std::cout << "Deadline misses: " << misses << " (" << 100.0 * misses / measured << " %)" << std::endl;
+    PrintPercentiles("Wake-up latency", wakeLatency);
+    PrintPercentiles("Step time", stepTime);
+    wakeHistogram.print("Wake-up latency");
+    stepHistogram.print("Step time");
+
+    if (!AllocationTracker::enabled()) {
+        std::cout << "Step allocations: not tracked in this build (ROCKET_TRACK_ALLOCATIONS=0)" << std::endl;
+        return 0;
+    }
+    std::cout << "Step allocations after warm-up: " << stepAllocations << std::endl;
+    if (stepAllocations != 0) {
+        std::cerr << "UpdateFlight allocated during the real-time loop; it does not qualify" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef REAL_TIME_H
+#define REAL_TIME_H
+
+// Hardware-in-the-loop style stepping: the physics runs at a fixed rate
+// against absolute deadlines on the monotonic clock, optionally pinned to one
+// core under SCHED_FIFO, and every wake-up is checked against its deadline.
+// The run also counts heap allocations made by the steps themselves, which
+// must be zero after warm-up for the step to qualify for real-time use.
+
+struct RealTimeOptions {
+    float duration = 30.0f;     // Seconds of wall-clock time, warm-up included
+    float rate = 1000.0f;       // Steps per second
+    float warmup = 0.5f;        // Seconds excluded from the statistics
+    int cpu = -1;               // Core to pin the physics thread to, -1 to leave it floating
+    bool fifo = false;          // SCHED_FIFO and locked memory; needs CAP_SYS_NICE on Linux
+    int priority = 80;          // SCHED_FIFO priority
+};
+
+// Runs the loop and prints deadline misses, jitter and step-time histograms.
+// Returns -1 when a step allocated after warm-up, so scripts can gate on it.
+int RunRealTime(const RealTimeOptions& options);
+
+#endif
@@ -0,0 +1,265 @@
+#include "ResultCache.h"
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+const uint64_t INITIAL_CAPACITY = 1024;
+
+static size_t CacheFileSize(uint64_t capacity) {
+    return sizeof(ResultCacheHeader) + static_cast<size_t>(capacity) * sizeof(ResultCacheEntry);
+}
+
+// Bytes in the file, -1 if there is none
+static long long FileLength(const char* path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<long long>(file.tellg()) : -1;
+}
+
+#ifdef _WIN32
+// Maps size bytes of the file read-write; create makes a new, zeroed file
+static void* MapFile(const char* path, size_t size, bool create) {
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    ULARGE_INTEGER bytes;
+    bytes.QuadPart = size;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, bytes.HighPart, bytes.LowPart, nullptr); // Extends a new file
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(mapping); // The view keeps the mapping alive
+    return view;
+}
+
+static void UnmapFile(void* view, size_t) {
+    UnmapViewOfFile(view);
+}
+
+static bool ReplaceFileWith(const char* from, const char* to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+static intptr_t LockCache(const std::string& lockPath, const std::string& cachePath) {
+    HANDLE file = CreateFileA(lockPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    OVERLAPPED overlapped = {};
+    if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped)) {
+        std::cerr << "Result cache " << cachePath << " is open in another process, waiting for it" << std::endl;
+        if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped)) {
+            CloseHandle(file);
+            return -1;
+        }
+    }
+    return reinterpret_cast<intptr_t>(file);
+}
+
+static void UnlockCache(intptr_t handle) {
+    CloseHandle(reinterpret_cast<HANDLE>(handle)); // Releases the lock
+}
+#else
+static void* MapFile(const char* path, size_t size, bool create) {
+    int fd = ::open(path, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (create && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file open
+    return view == MAP_FAILED ? nullptr : view;
+}
+
+static void UnmapFile(void* view, size_t size) {
+    munmap(view, size); // Dirty pages reach the file through the page cache
+}
+
+static bool ReplaceFileWith(const char* from, const char* to) {
+    return std::rename(from, to) == 0;
+}
+
+// The kernel drops the flock when the process exits, so a crashed sweep
+// leaves nothing to clean up
+static intptr_t LockCache(const std::string& lockPath, const std::string& cachePath) {
+    int fd = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        if (errno != EWOULDBLOCK) {
+            ::close(fd);
+            return -1;
+        }
+        std::cerr << "Result cache " << cachePath << " is open in another process, waiting for it" << std::endl;
+        while (flock(fd, LOCK_EX) != 0) {
+            if (errno != EINTR) {
+                ::close(fd);
+                return -1;
+            }
+        }
+    }
+    return fd;
+}
+
+static void UnlockCache(intptr_t handle) {
+    ::close(static_cast<int>(handle)); // Releases the lock
+}
+#endif
+
+// The slot holding key, or the empty one where it belongs. Linear probing;
+// the table never fills past 3/4, so an empty slot always ends the search.
+static ResultCacheEntry& Slot(ResultCacheEntry* entries, uint64_t capacity, const CacheKey& key) {
+    uint64_t mask = capacity - 1;
+    for (uint64_t i = key.hash & mask;; i = (i + 1) & mask) {
+        ResultCacheEntry& entry = entries[i];
+        if (!entry.occupied || (entry.key.hash == key.hash && entry.key.check == key.check)) return entry;
+    }
+}
+
+ResultCache::~ResultCache() {
+    close();
+}
+
+// The lock is on a file of its own, since grow() renames a new table over
+// the cache; it stays on disk, as removing it would race with a waiter
+bool ResultCache::open(const char* cachePath) {
+    close();
+    path = cachePath;
+    lockHandle = LockCache(path + ".lock", path);
+    if (lockHandle == -1) {
+        std::cerr << "Cannot lock result cache " << cachePath << std::endl;
+        return false;
+    }
+    if (!map()) {
+        UnlockCache(lockHandle);
+        lockHandle = -1;
+        return false;
+    }
+    return true;
+}
+
+void ResultCache::close() {
+    unmap();
+    if (lockHandle != -1) UnlockCache(lockHandle);
+    lockHandle = -1;
+}
+
+// Maps path, which this process holds the lock for
+bool ResultCache::map() {
+    const char* cachePath = path.c_str();
+    long long length = FileLength(cachePath);
+    if (length < 0) {
+        size_t size = CacheFileSize(INITIAL_CAPACITY);
+        void* view = MapFile(cachePath, size, true);
+        if (view == nullptr) {
+            std::cerr << "Cannot create result cache " << cachePath << std::endl;
+            return false;
+        }
+        header = static_cast<ResultCacheHeader*>(view);
+        header->entrySize = sizeof(ResultCacheEntry);
+        header->version = RESULT_CACHE_VERSION;
+        header->capacity = INITIAL_CAPACITY;
+        header->count = 0;
+        header->magic = RESULT_CACHE_MAGIC;
+        entries = reinterpret_cast<ResultCacheEntry*>(header + 1);
+        mappedSize = size;
+        return true;
+    }
+
+    if (length < static_cast<long long>(sizeof(ResultCacheHeader))) {
+        std::cerr << cachePath << ": not a result cache" << std::endl;
+        return false;
+    }
+    void* view = MapFile(cachePath, static_cast<size_t>(length), false);
+    if (view == nullptr) {
+        std::cerr << "Cannot map result cache " << cachePath << std::endl;
+        return false;
+    }
+    const ResultCacheHeader* found = static_cast<const ResultCacheHeader*>(view);
+    uint64_t capacity = found->capacity;
+    if (found->magic != RESULT_CACHE_MAGIC || found->version != RESULT_CACHE_VERSION
+        || found->entrySize != sizeof(ResultCacheEntry) || capacity == 0 || (capacity & (capacity - 1)) != 0
+        || CacheFileSize(capacity) != static_cast<size_t>(length) || found->count * 4 > capacity * 3) {
+        std::cerr << cachePath << ": written by an incompatible build or corrupted, delete it" << std::endl;
+        UnmapFile(view, static_cast<size_t>(length));
+        return false;
+    }
+    header = static_cast<ResultCacheHeader*>(view);
+    entries = reinterpret_cast<ResultCacheEntry*>(header + 1);
+    mappedSize = static_cast<size_t>(length);
+    return true;
+}
+
+void ResultCache::unmap() {
+    if (header != nullptr) UnmapFile(header, mappedSize);
+    header = nullptr;
+    entries = nullptr;
+    mappedSize = 0;
+}
+
+bool ResultCache::find(const CacheKey& key, CachedRun& out) const {
+    if (header == nullptr) return false;
+    const ResultCacheEntry& entry = Slot(entries, header->capacity, key);
+    if (!entry.occupied) return false;
+    out = entry.run;
+    return true;
+}
+
+bool ResultCache::insert(const CacheKey& key, const CachedRun& run) {
+    if (header == nullptr) return false;
+    if ((header->count + 1) * 4 > header->capacity * 3 && !grow()) return false;
+    ResultCacheEntry& entry = Slot(entries, header->capacity, key);
+    entry.run = run;
+    if (!entry.occupied) {
+        entry.key = key;
+        entry.occupied = 1;
+        header->count++;
+    }
+    return true;
+}
+
+// Rehashes into a table twice the size in a new file, then swaps it in, so
+// an interrupted grow leaves the old cache whole
+bool ResultCache::grow() {
+    uint64_t capacity = header->capacity * 2;
+    size_t size = CacheFileSize(capacity);
+    std::string grownPath = path + ".grow";
+    void* view = MapFile(grownPath.c_str(), size, true);
+    if (view == nullptr) {
+        std::cerr << "Cannot grow result cache " << path << std::endl;
+        return false;
+    }
+    ResultCacheHeader* grown = static_cast<ResultCacheHeader*>(view);
+    *grown = *header;
+    grown->capacity = capacity;
+    ResultCacheEntry* grownEntries = reinterpret_cast<ResultCacheEntry*>(grown + 1);
+    for (uint64_t i = 0; i < header->capacity; i++) {
+        if (entries[i].occupied) Slot(grownEntries, capacity, entries[i].key) = entries[i];
+    }
+    UnmapFile(view, size);
+
+    unmap(); // Still locked: nobody else opens it in between
+    bool replaced = ReplaceFileWith(grownPath.c_str(), path.c_str());
+    if (!replaced) std::cerr << "Cannot replace result cache " << path << std::endl;
+    return map() && replaced;
+}
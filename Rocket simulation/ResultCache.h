@@ -0,0 +1,87 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "Campaign.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk store of finished runs, addressed by a hash of everything that
+// decides them. The file is one open-addressing hash table mapped into
+// memory: a lookup is a few probes in the page cache, no reads or parsing,
+// and a new entry is a store into the mapping. One process has a cache open
+// at a time: open() holds an exclusive lock on "<path>.lock" until close(),
+// and waits while another process holds it.
+
+const uint32_t RESULT_CACHE_MAGIC = 0x4352534B; // "KSRC"
+const uint32_t RESULT_CACHE_VERSION = 1;
+
+// Two independent 64-bit hashes of the key material; both must match
+struct CacheKey {
+    uint64_t hash;
+    uint64_t check;
+};
+
+// FNV-1a, 64-bit; pass the previous result to hash several pieces as one
+const uint64_t FNV64_OFFSET = 14695981039346656037ull;
+
+inline uint64_t Fnv1a64(const void* data, size_t size, uint64_t hash = FNV64_OFFSET) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// What a cached run did and what it cost to find out
+struct CachedRun {
+    RunOutcome outcome;
+    float seconds;              // Simulation time the run took, saved on every hit
+};
+
+struct ResultCacheEntry {
+    CacheKey key;
+    uint32_t occupied;          // 0 in an empty slot
+    CachedRun run;
+};
+
+struct ResultCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entrySize;         // sizeof(ResultCacheEntry), catches layout changes
+    uint32_t reserved;
+    uint64_t capacity;          // Slots, a power of two
+    uint64_t count;             // Occupied slots
+};
+
+class ResultCache {
+public:
+    ~ResultCache();
+
+    // Locks and maps the file, creating an empty cache if there is none.
+    // False, with the reason on std::cerr, if it cannot or the file is not a
+    // cache of this build.
+    bool open(const char* path);
+    void close();               // Flushes the mapping to the file and unlocks it
+    bool isOpen() const { return header != nullptr; }
+
+    bool find(const CacheKey& key, CachedRun& out) const;
+
+    // Adds or replaces; doubles the table into a new file past 3/4 full
+    bool insert(const CacheKey& key, const CachedRun& run);
+
+    uint64_t size() const { return header != nullptr ? header->count : 0; }
+
+private:
+    bool map();
+    void unmap();
+    bool grow();
+
+    std::string path;
+    intptr_t lockHandle = -1;   // fd or HANDLE of the lock file while open
+    ResultCacheHeader* header = nullptr;
+    ResultCacheEntry* entries = nullptr;
+    size_t mappedSize = 0;
+};
+
+#endif
@@ -14,10 +14,32 @@ public:
     // Thrust levels for 5 engines
     std::array<float, 5> engineThrust; // Use std::array for thrust values
 
+    // Attitude: tilt of the body axis from vertical toward +x (pitch) and +z (yaw)
+    float pitch, yaw;                  // rad
+    float pitchRate, yawRate;          // rad/s
+
+    // Engine deflection per engine, rad; positive turns the vehicle toward positive pitch/yaw
+    std::array<float, 5> gimbalPitch;
+    std::array<float, 5> gimbalYaw;
+
+    // Geometry, set from the scenario at launch
+    float gimbalArm;                   // m, centre of mass to gimbal pivots
+    float engineSpacing;               // m, centre line to engines 1-4
+    float gyrationRadius;              // m
+    float misalignmentPitch, misalignmentYaw; // rad, added to every engine's gimbal
+
+    // Faults, nominal unless a campaign injects them: thrust delivered over
+    // commanded per engine (0 once failed), fuel burned per thrust over
+    // nominal, and gimbals frozen where they were
+    std::array<float, 5> thrustFactor;
+    float fuelFactor;
+    std::array<bool, 5> gimbalStuck;
+
     // Constructor
     Rocket();
 
-    // Apply thrust to the rocket, accepting std::array<float, 5>
+    // Apply thrust to the rocket, accepting std::array<float, 5>. Gimbal
+    // deflection and uneven thrust turn the vehicle; the thrust acts along its axis.
     void applyThrust(const std::array<float, 5>& thrustValues, float deltaTime);
 
     // Update the rocket's physics (called every frame)
@@ -0,0 +1,109 @@
+#ifndef ROCKET_DYNAMICS_H
+#define ROCKET_DYNAMICS_H
+
+#include <cmath>
+
+// Rocket's equations of motion, templated on the scalar type. Rocket runs
+// them in float; the sensitivity analysis runs them on dual numbers for
+// exact derivatives of the very step the simulation takes. Body is Rocket
+// or RocketBody<T>: anything with Rocket's member names whose vectors and
+// per-engine arrays index with [].
+
+// Where each engine sits, in units of engineSpacing: the centre engine, then
+// +x, +z, -x, -z
+const float ENGINE_X[5] = { 0.0f, 1.0f, 0.0f, -1.0f, 0.0f };
+const float ENGINE_Z[5] = { 0.0f, 0.0f, 1.0f, 0.0f, -1.0f };
+
+// Fraction of the step the fuel lasts, 1 while it lasts the whole step
+template <typename T>
+T CutoffFraction(const T& fuel, const T& burn) {
+    if (burn > fuel && burn > T(0.0f)) return fuel / burn;
+    return T(1.0f);
+}
+
+// Fuel Rocket's own tank loses to totalThrust over deltaTime
+template <typename T, typename Body>
+T TankBurn(const Body& body, T totalThrust, T deltaTime) {
+    return totalThrust * T(0.1f) * body.fuelFactor * deltaTime;
+}
+
+// Rocket::applyThrust with fuel in the tank: engine thrust, the turn from
+// gimbals and uneven thrust, the push along the body axis and the fuel it
+// burns. Returns true when the tank ran dry. Rocket thrusts for the whole
+// step that empties the tank; cutoffWithinStep stops the engines when the
+// fuel runs out, so what the flight reaches moves smoothly with its inputs
+// instead of a whole step at a time.
+template <typename T, typename Body, typename Levels>
+bool ApplyThrustStep(Body& body, const Levels& thrustValues, T deltaTime, bool cutoffWithinStep = false) {
+    using std::cos;
+    using std::sin;
+    // Calculate total thrust from all engines, and the angular acceleration
+    // from each one's lever: its gimbal below the centre of mass, its
+    // offset from the centre line
+    T totalThrust = T(0.0f);
+    T pitchAcceleration = T(0.0f), yawAcceleration = T(0.0f);
+    for (int i = 0; i < 5; i++) {
+        body.engineThrust[i] = thrustValues[i] * body.thrustFactor[i];
+        totalThrust += body.engineThrust[i];
+        T deflectionPitch = body.gimbalPitch[i] + body.misalignmentPitch;
+        T deflectionYaw = body.gimbalYaw[i] + body.misalignmentYaw;
+        pitchAcceleration += body.engineThrust[i] * (body.gimbalArm * sin(deflectionPitch) - body.engineSpacing * ENGINE_X[i] * cos(deflectionPitch));
+        yawAcceleration += body.engineThrust[i] * (body.gimbalArm * sin(deflectionYaw) - body.engineSpacing * ENGINE_Z[i] * cos(deflectionYaw));
+    }
+    T burn = TankBurn(body, totalThrust, deltaTime);
+    T thrustTime = cutoffWithinStep ? deltaTime * CutoffFraction(body.fuel, burn) : deltaTime;
+
+    T inertia = body.gyrationRadius * body.gyrationRadius;
+    body.pitchRate += pitchAcceleration / inertia * thrustTime;
+    body.yawRate += yawAcceleration / inertia * thrustTime;
+    body.pitch += body.pitchRate * deltaTime;
+    body.yaw += body.yawRate * deltaTime;
+
+    // Apply the total thrust along the body axis; upright that is +y alone
+    T axis[3] = { sin(body.pitch) * cos(body.yaw), cos(body.pitch) * cos(body.yaw), sin(body.yaw) };
+    T deltaV = totalThrust * thrustTime;
+    for (int i = 0; i < 3; i++) body.velocity[i] += axis[i] * deltaV;
+
+    // Decrease fuel based on total thrust
+    body.fuel -= burn;
+    if (body.fuel < T(0.0f)) {
+        body.fuel = T(0.0f);  // Ensure fuel doesn't drop below 0
+        return true;
+    }
+    return false;
+}
+
+// Rocket::update: gravity, then position from the new velocity. Returns
+// true when the ground held the vehicle up.
+template <typename T, typename Body>
+bool IntegrateStep(Body& body, T deltaTime) {
+    // Apply gravity to the rocket's velocity
+    body.velocity[1] += body.gravity * deltaTime;
+
+    // Update the rocket's position based on its velocity
+    for (int i = 0; i < 3; i++) body.position[i] += body.velocity[i] * deltaTime;
+
+    // Prevent the rocket from falling below the ground (y = 0)
+    if (body.position[1] < T(0.0f)) {
+        body.position[1] = T(0.0f);
+        body.velocity[1] = T(0.0f);
+        return true;
+    }
+    return false;
+}
+
+// Rocket's state and parameters in any scalar type, for the templated steps
+template <typename T>
+struct RocketBody {
+    T position[3], velocity[3];
+    T fuel, gravity;
+    T engineThrust[5];
+    T pitch, yaw, pitchRate, yawRate;
+    T gimbalPitch[5], gimbalYaw[5];
+    T gimbalArm, engineSpacing, gyrationRadius;
+    T misalignmentPitch, misalignmentYaw;
+    T thrustFactor[5];
+    T fuelFactor;
+};
+
+#endif
@@ -3,50 +3,338 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <iostream>
-#include <string>
 #include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
 #include "Rocket.h"
+#include "AllocationTracker.h"
+#include "Campaign.h"
+#include "CommandServer.h"
+#include "Flight.h"
+#include "Headless.h"
+#include "Instrumentation.h"
+#include "Memory.h"
+#include "Offscreen.h"
+#include "SharedState.h"
+#include "TelemetryServer.h"
+#include "Telemetry.h"
+#include "Viewport.h"
 
 const GLint WIDTH = 1280, HEIGHT = 720;
 
-float fuelLevel = 100.0f;  // Full fuel (100%)
-float altitude = 0.0f;     // Starting altitude
-float speed = 0.0f;        // Rocket speed (m/s)
-float acceleration = 0.0f; // Rocket acceleration (m/s^2)
-float currentMass = 500.0f; // Initial mass of the rocket (kg)
-const float DRY_MASS = 100.0f; // Mass of the rocket when empty (no fuel)
-const float MAX_ALTITUDE = 10000.0f; // Maximum altitude for simulation
-const float MAX_ACCELERATION = 20.0f; // Maximum acceleration value for display
-std::array<float, 5> thrustLevels = { 100.0f, 100.0f, 100.0f, 100.0f, 100.0f }; // Initial thrust for 5 engines
-
-bool isLiftoffInitiated = false;
-bool isLiftoffComplete = false;
-float liftoffStartTime = 0.0f;
-float pitch = 65.42f;
-float yaw = -120.0f;
+// Idle consoles sleep in glfwWaitEventsTimeout and only redraw on input, on a
+// flight state change, or once per IDLE_REFRESH_INTERVAL for the clocks.
+const double IDLE_REFRESH_INTERVAL = 1.0;
+const int MAX_SUBSTEPS = 1000; // Per frame when a remote timestep is set
+const int REDRAW_FRAMES_AFTER_INPUT = 3; // ImGui needs a few frames to settle hover/click state
+int pendingRedrawFrames = REDRAW_FRAMES_AFTER_INPUT;
+
+FlightState flight;
+RocketViewport animationView;
+TelemetryServer telemetryServer; // Off until enabled in the telemetry panel
+BackgroundCampaign backgroundCampaign; // Started from the campaign panel
+CampaignResult campaignView;    // Last report, copied in once per frame
+std::vector<VehicleInstance> campaignFleet; // Where the traced campaign runs burnt out
+bool campaignFleetShown = true; // Nothing to show before the first campaign
+FrameAllocationCheck frameAllocations; // Panels that start something restart its warm-up
+
+// Dashboard labels are formatted into fixed buffers and only rebuilt when the
+// value they show changes, so drawing a steady frame never touches the heap.
+struct EngineLabels {
+    char engine[20] = "";       // "Engine #" and any int
+    char throttle[32] = "";
+    int throttlePercent = -1;
+};
+std::array<EngineLabels, 5> engineLabels;
+
+const char* EngineLabel(int engine) {
+    EngineLabels& labels = engineLabels[engine];
+    if (labels.engine[0] == '\0') {
+        std::snprintf(labels.engine, sizeof(labels.engine), "Engine #%d", engine + 1);
+    }
+    return labels.engine;
+}
+
+const char* ThrottleLabel(int engine, float thrustLevel) {
+    EngineLabels& labels = engineLabels[engine];
+    int percent = static_cast<int>(thrustLevel);
+    if (percent != labels.throttlePercent) {
+        labels.throttlePercent = percent;
+        std::snprintf(labels.throttle, sizeof(labels.throttle), "Throttle: %d%%", percent);
+    }
+    return labels.throttle;
+}
+
 float roll = 0.0f;
 
-float gimbalPitch = -0.004f;
-float gimbalYaw = 0.0f;
-float gimbalAbsolute = 0.004f;
+const float RADIANS_TO_DEGREES = 57.29577951308232f;
+
+// Per-frame UI scratch, rewound at the top of every frame
+Arena frameArena;
+
+// Recent telemetry for the altitude plot. The pool holds exactly one history's
+// worth of records, so a long flight recycles them instead of reaching malloc.
+const int TELEMETRY_HISTORY = 512;
+ObjectPool<TelemetryRecord> telemetryPool(TELEMETRY_HISTORY);
+std::array<TelemetryRecord*, TELEMETRY_HISTORY> telemetryHistory = {};
+int telemetryHead = 0;  // Slot the next record goes into
+int telemetryCount = 0;
+
+// Last few flight events, newest last
+struct EventLogEntry {
+    float time;
+    FlightEventType type;
+};
+std::array<EventLogEntry, 8> eventLog;
+int eventLogCount = 0;
+
+void ClearTelemetry() {
+    for (TelemetryRecord*& record : telemetryHistory) {
+        telemetryPool.destroy(record);
+        record = nullptr;
+    }
+    telemetryHead = 0;
+    telemetryCount = 0;
+    eventLogCount = 0;
+    animationView.clearTrail();
+}
+
+void RecordTelemetry(float currentTime) {
+    LogFlightEvents(flight);
+    if (telemetryServer.isRunning()) {
+        TelemetryRecord record;
+        FillTelemetryRecord(record, flight, currentTime);
+        telemetryServer.submit(record); // Every step, countdown included; drops rather than waits
+    }
+
+    for (const FlightEvent* event = flight.events; event != nullptr; event = event->next) {
+        if (eventLogCount == static_cast<int>(eventLog.size())) {
+            for (size_t i = 1; i < eventLog.size(); i++) eventLog[i - 1] = eventLog[i];
+            eventLogCount--;
+        }
+        eventLog[eventLogCount++] = { event->time, event->type };
+    }
+
+    if (flight.isLiftoffComplete) {
+        animationView.addTrailPoint(flight.rocket.position); // Keeps coasting after burnout
+    }
+    if (!flight.isLiftoffComplete || (flight.fuelLevel <= 0.0f && !IsFlightCoasting(flight))) {
+        return;
+    }
+
+    TelemetryRecord*& slot = telemetryHistory[telemetryHead];
+    telemetryPool.destroy(slot); // Oldest record once the history is full
+    slot = telemetryPool.create();
+    FillTelemetryRecord(*slot, flight, currentTime);
+    telemetryHead = (telemetryHead + 1) % TELEMETRY_HISTORY;
+    if (telemetryCount < TELEMETRY_HISTORY) telemetryCount++;
+}
+
+void RenderTelemetryPanel() {
+    ImGui::Text("Telemetry");
+    ImGui::Separator();
 
-Rocket rocket;
+    // Oldest to newest, gathered into frame scratch for the plot
+    float* altitudes = frameArena.allocateArray<float>(TELEMETRY_HISTORY);
+    int first = (telemetryHead - telemetryCount + TELEMETRY_HISTORY) % TELEMETRY_HISTORY;
+    for (int i = 0; i < telemetryCount; i++) {
+        altitudes[i] = telemetryHistory[(first + i) % TELEMETRY_HISTORY]->position.y;
+    }
+    ImGui::PlotLines("Altitude (m)", altitudes, telemetryCount, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
 
+    for (int i = 0; i < eventLogCount; i++) {
+        ImGui::Text("T+%.2f s  %s", eventLog[i].time, FlightEventName(eventLog[i].type));
+    }
+
+    ImGui::Text("ImGui heap: %.1f KB live / %.1f KB reserved",
+        ImGuiHeap::liveBytes() / 1024.0f, ImGuiHeap::capacity() / 1024.0f);
+    ImGui::Text("Frame arena: %.1f KB / %.1f KB",
+        frameArena.bytesUsed() / 1024.0f, frameArena.capacity() / 1024.0f);
+    ImGui::Text("Telemetry pool: %d records / %.1f KB",
+        static_cast<int>(telemetryPool.liveObjects()), telemetryPool.capacity() / 1024.0f);
+
+    bool streaming = telemetryServer.isRunning();
+    if (ImGui::Checkbox("Stream telemetry on 127.0.0.1", &streaming)) {
+        if (streaming) telemetryServer.start();
+        else telemetryServer.stop();
+        frameAllocations.restartWarmup(); // Start makes the thread and the ring on this thread
+    }
+    if (telemetryServer.isRunning()) {
+        TelemetryServerStats stats = telemetryServer.stats();
+        ImGui::Text("Port %u: %u clients, %llu frames sent, %llu coalesced, %llu records dropped",
+            static_cast<unsigned>(TELEMETRY_DEFAULT_PORT), stats.clients,
+            static_cast<unsigned long long>(stats.framesSent), static_cast<unsigned long long>(stats.framesCoalesced),
+            static_cast<unsigned long long>(stats.dropped));
+    }
+}
 
-// Progress state variables
-enum ProgressState { LOAD_FUEL, COUNTDOWN, START_ENGINES, LIFTOFF };
-ProgressState currentProgress = LOAD_FUEL;
+// Hot-path counters from Instrumentation.h, aggregated across threads on demand
+void RenderInstrumentationPanel() {
+    ImGui::Text("Instrumentation");
+    ImGui::Separator();
+    if (!Instrumentation::enabled()) {
+        ImGui::Text("Disabled in this build (ROCKET_INSTRUMENTATION=0)");
+        return;
+    }
+
+    Instrumentation::Snapshot stats = Instrumentation::snapshot();
+    for (int i = 0; i < Instrumentation::COUNTER_COUNT; i++) {
+        ImGui::Text("%s: %llu", Instrumentation::counterName(static_cast<Instrumentation::Counter>(i)),
+            static_cast<unsigned long long>(stats.counters[i]));
+    }
+
+    for (int h = 0; h < Instrumentation::HISTOGRAM_COUNT; h++) {
+        float buckets[Instrumentation::HISTOGRAM_BUCKETS];
+        for (int b = 0; b < Instrumentation::HISTOGRAM_BUCKETS; b++) {
+            buckets[b] = static_cast<float>(stats.histograms[h][b]);
+        }
+        ImGui::PlotHistogram(Instrumentation::histogramName(static_cast<Instrumentation::Histogram>(h)),
+            buckets, Instrumentation::HISTOGRAM_BUCKETS, 0, "log2 buckets", 0.0f, FLT_MAX, ImVec2(0, 80));
+    }
+
+    // Which upload path the OpenGL backend took for the last frame
+    ImGui_ImplOpenGL3_RenderStats render = ImGui_ImplOpenGL3_GetRenderStats();
+    ImGui::Text("Render buffers: %s", render.PersistentBuffers ? "persistent ring" : "glBufferData");
+    ImGui::Text("Uploaded: %.1f KB in %d calls, %d fence waits",
+        render.UploadBytes / 1024.0f, render.UploadCalls, render.FenceWaits);
+
+    if (ImGui::Button("Reset Counters")) {
+        Instrumentation::reset();
+    }
+}
+
+void RenderDistribution(const char* name, const char* unit, const Distribution& distribution) {
+    const RunningMoments& moments = distribution.moments;
+    const TDigest& digest = distribution.digest;
+    const LinearHistogram& histogram = distribution.histogram;
+    if (digest.weight == 0.0) {
+        ImGui::Text("%s: no runs simulated yet", name); // The quantiles would be NaN
+        return;
+    }
+    ImGui::Text("%s: mean %.2f %s, sd %.2f", name, moments.mean, unit, moments.deviation());
+    ImGui::Text("  min %.2f  p5 %.2f  p50 %.2f  p95 %.2f  max %.2f", moments.minimum,
+        digest.quantile(0.05), digest.quantile(0.5), digest.quantile(0.95), moments.maximum);
+
+    float bins[HISTOGRAM_BINS];
+    for (int i = 0; i < HISTOGRAM_BINS; i++) bins[i] = static_cast<float>(histogram.bins[i]);
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "%.0f-%.0f, %ld below, %ld above", histogram.low, histogram.high,
+        histogram.below, histogram.above);
+    ImGui::PushID(name);
+    ImGui::PlotHistogram("", bins, HISTOGRAM_BINS, 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 60));
+    ImGui::PopID();
+}
+
+// The traced campaign runs in the 3D view: every path as a trajectory and a
+// vehicle where it burnt out, green if the run succeeded and red if not
+void ShowCampaignFleet(const CampaignTraces& traces) {
+    campaignFleet.clear();
+    animationView.clearFleet();
+    for (size_t run = 0; run < traces.counts.size(); run++) {
+        int count = traces.counts[run];
+        if (count == 0) continue;
+        const glm::vec3* path = &traces.points[traces.firsts[run]];
+        animationView.addTrajectory(path, count);
+        bool success = (traces.flags[run] & RUN_SUCCESS) != 0;
+        campaignFleet.push_back({ path[count - 1], 0.5f, success ? IM_COL32(80, 220, 100, 255) : IM_COL32(235, 70, 60, 255) });
+    }
+    animationView.setFleet(campaignFleet.data(), static_cast<int>(campaignFleet.size()));
+    frameAllocations.restartWarmup();
+}
+
+// Monte Carlo campaign on the loaded scenario, run in the background; the
+// distributions fill in while it runs and
+// the first runs' paths go to the 3D view once it is done
+void RenderCampaignPanel() {
+    ImGui::Text("Reliability Campaign");
+    ImGui::Separator();
+
+    bool running = backgroundCampaign.isRunning();
+    if (ImGui::Button(running ? "Stop Campaign" : "Run Campaign")) {
+        if (running) {
+            backgroundCampaign.stop();
+        }
+        else {
+            CampaignOptions options;
+            options.halfWidth = 0.005;
+            backgroundCampaign.start(*flight.scenario, options);
+            frameAllocations.restartWarmup(); // The thread, its statistics and the result buffers are made here
+            animationView.clearFleet();
+            campaignFleetShown = false;
+        }
+    }
+    if (!campaignFleetShown) {
+        if (const CampaignTraces* traces = backgroundCampaign.traces()) {
+            ShowCampaignFleet(*traces);
+            campaignFleetShown = true;
+        }
+    }
+    if (!backgroundCampaign.latest(campaignView)) {
+        if (running) ImGui::Text("Running...");
+        return;
+    }
+
+    ImGui::Text("%ld runs%s: success %.4f [%.4f, %.4f]", campaignView.runs,
+        running ? "" : (campaignView.cancelled ? ", cancelled" : (campaignView.stoppedEarly ? ", stopped early" : ", done")),
+        campaignView.probability, campaignView.low, campaignView.high);
+    ImGui::Text("Engine out: %ld runs, %ld failed  Gimbal stuck: %ld runs, %ld failed",
+        campaignView.engineOutRuns, campaignView.engineOutFailures,
+        campaignView.gimbalStuckRuns, campaignView.gimbalStuckFailures);
+    RenderDistribution("Apogee", "m", campaignView.statistics.apogee);
+    RenderDistribution("Burnout", "s", campaignView.statistics.burnoutTime);
+    RenderDistribution("Max accel.", "m/s^2", campaignView.statistics.maxAcceleration);
+}
 
 void RenderAdditionalWindow() {
     ImGui::SetNextWindowPos(ImVec2(2000, 0), ImGuiCond_Once);  // Set the position to the right of the control panel
     ImGui::SetNextWindowSize(ImVec2(660, 718), ImGuiCond_Once); // Set the default size of the new window
     ImGui::Begin("Rocket Simulation");  // Create a new ImGui window named "Additional Panel"
 
-    
+    RenderTelemetryPanel();
+    ImGui::Spacing();
+    RenderInstrumentationPanel();
+    ImGui::Spacing();
+    RenderCampaignPanel();
 
     ImGui::End();
 }
 
+// 3D view of the vehicle and its trail: drag to orbit, mouse wheel to zoom
+void RenderAnimationWindow() {
+    ImGui::SetNextWindowPos(ImVec2(820, 380), ImGuiCond_Once);
+    ImGui::SetNextWindowSize(ImVec2(450, 330), ImGuiCond_Once);
+    if (ImGui::Begin("Rocket Animation Window", nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse)) {
+        if (!animationView.isAvailable()) {
+            ImGui::Text("3D view needs OpenGL 3.3");
+        }
+        else {
+            ImVec2 size = ImGui::GetContentRegionAvail();
+            size.y -= ImGui::GetTextLineHeightWithSpacing();
+            if (size.x >= 1.0f && size.y >= 1.0f) {
+                animationView.setVehicle(flight.rocket.position);
+                animationView.render(static_cast<int>(size.x), static_cast<int>(size.y));
+
+                // An invisible button takes the drag, so it orbits instead of moving the window
+                ImVec2 origin = ImGui::GetCursorScreenPos();
+                ImGui::InvisibleButton("##view", size);
+                ImGui::GetWindowDrawList()->AddImage(animationView.texture(), origin,
+                    ImVec2(origin.x + size.x, origin.y + size.y), ImVec2(0, 1), ImVec2(1, 0)); // GL textures are bottom-up
+                ImGuiIO& io = ImGui::GetIO();
+                if (ImGui::IsItemActive()) {
+                    animationView.orbit(-io.MouseDelta.x * 0.3f, io.MouseDelta.y * 0.3f);
+                }
+                if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f) {
+                    animationView.zoom(io.MouseWheel);
+                }
+            }
+            ImGui::Text("Trail: %d points  Fleet: %d  Draw calls: %d", animationView.trailPoints(),
+                animationView.fleetVehicles(), animationView.lastDrawCalls());
+        }
+    }
+    ImGui::End();
+}
+
 // Function to draw vertical bar
 void DrawVerticalBar(float level, ImVec2 pos, ImVec2 size, ImU32 color) {
     ImDrawList* drawList = ImGui::GetWindowDrawList();
@@ -80,15 +368,15 @@ void RenderFlightProgressPanel() {
     ImGui::Text("Flight Progress");
 
     // Display flight data with different colors
-    DisplayFlightDataWithColor("Acceleration:", acceleration, "m/s^2", IM_COL32(255, 215, 0, 255));  // Yellow for Acceleration
-    DisplayFlightDataWithColor("Speed:", speed, "m/s", IM_COL32(255, 69, 0, 255));  // Red for Speed
-    DisplayFlightDataWithColor("Altitude:", altitude / 1000.0f, "km", IM_COL32(50, 205, 50, 255));  // Green for Altitude
+    DisplayFlightDataWithColor("Acceleration:", flight.acceleration, "m/s^2", IM_COL32(255, 215, 0, 255));  // Yellow for Acceleration
+    DisplayFlightDataWithColor("Speed:", flight.speed, "m/s", IM_COL32(255, 69, 0, 255));  // Red for Speed
+    DisplayFlightDataWithColor("Altitude:", flight.altitude / 1000.0f, "km", IM_COL32(50, 205, 50, 255));  // Green for Altitude
     ImGui::Separator();
 
     // Additional Data
     ImGui::Text("Downrange: 0.0 km");
-    ImGui::Text("Traveled Distance: %.3f km", altitude / 1000.0f);
-    ImGui::Text("Mach: %.3f", speed / 343.0f);
+    ImGui::Text("Traveled Distance: %.3f km", flight.altitude / 1000.0f);
+    ImGui::Text("Mach: %.3f", flight.speed / 343.0f);
     ImGui::Text("Angular Accel.: 0.0 mrad/s^2");
 
     ImGui::EndChild();
@@ -97,14 +385,15 @@ void RenderFlightProgressPanel() {
 void RenderStructuralDataPanel() {
     ImGui::BeginChild("StructuralPanel", ImVec2(0, 250), true, ImGuiWindowFlags_NoDecoration);
     ImGui::Text("Structural Data");
+    ImGui::Text("Scenario: %s", flight.scenario->name);
 
-    float propellantMass = currentMass - DRY_MASS; // Calculate propellant mass
-    float totalMass = currentMass;                 // Total mass (dry mass + propellant mass)
+    float propellantMass = flight.currentMass - flight.scenario->dryMass; // Calculate propellant mass
+    float totalMass = flight.currentMass;                 // Total mass (dry mass + propellant mass)
     float centerGravity = 33.92f;                  // Mock value for Center of Gravity
     float momentInertia = 57648833.0f;             // Mock value for Moment of Inertia
 
     // Render structural data similar to the image you shared
-    ImGui::Text("Total Mass (WOP): %.2f kg", DRY_MASS);
+    ImGui::Text("Total Mass (WOP): %.2f kg", flight.scenario->dryMass);
     ImGui::Text("Propellant Mass: %.2f kg", propellantMass);
     ImGui::Text("Total Mass: %.2f kg", totalMass);
     ImGui::Text("Center of Gravity: %.2f m", centerGravity);
@@ -124,13 +413,13 @@ void RenderSpatialPositioningPanel(const Rocket& rocket) {
 
     ImGui::Separator();
     ImGui::Text("Attitude:");
-    ImGui::Text("  Pitch = %.2f ", pitch);
+    ImGui::Text("  Pitch = %.2f ", rocket.pitch * RADIANS_TO_DEGREES);
     ImGui::SameLine(150);
-    ImGui::Text("Planned: %.2f ", pitch);  // Mock Planned Value
+    ImGui::Text("Planned: %.2f ", 0.0f);  // The controller holds the vehicle upright
 
-    ImGui::Text("  Yaw = %.2f ", yaw);
+    ImGui::Text("  Yaw = %.2f ", rocket.yaw * RADIANS_TO_DEGREES);
     ImGui::SameLine(150);
-    ImGui::Text("Planned: %.2f ", yaw);  // Mock Planned Value
+    ImGui::Text("Planned: %.2f ", 0.0f);
 
     ImGui::Text("  Roll = %.2f ", roll);
     ImGui::SameLine(150);
@@ -138,15 +427,171 @@ void RenderSpatialPositioningPanel(const Rocket& rocket) {
 
     ImGui::Separator();
     ImGui::Text("Vector thrust (Gimbal):");
+    float gimbalPitch = rocket.gimbalPitch[0] * RADIANS_TO_DEGREES; // Every engine takes the same command
+    float gimbalYaw = rocket.gimbalYaw[0] * RADIANS_TO_DEGREES;
     ImGui::Text("  Pitch = %.3f ", gimbalPitch);
     ImGui::Text("  Yaw = %.3f ", gimbalYaw);
-    ImGui::Text("  Absolute = %.3f ", gimbalAbsolute);
+    ImGui::Text("  Absolute = %.3f ", std::sqrt(gimbalPitch * gimbalPitch + gimbalYaw * gimbalYaw));
+
+    ImGui::EndChild();
+}
+
+
+// Installed before the ImGui backend, which chains to them, so any input or
+// window event schedules a few redraws.
+void RequestRedraw() {
+    pendingRedrawFrames = REDRAW_FRAMES_AFTER_INPUT;
+}
+
+void InstallRedrawCallbacks(GLFWwindow* window) {
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { RequestRedraw(); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { RequestRedraw(); });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { RequestRedraw(); });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { RequestRedraw(); });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { RequestRedraw(); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow*, int) { RequestRedraw(); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow*, int) { RequestRedraw(); });
+    glfwSetWindowSizeCallback(window, [](GLFWwindow*, int, int) { RequestRedraw(); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { RequestRedraw(); });
+}
+
+// The whole console for one frame, between ImGui::NewFrame() and ImGui::Render().
+// Shared by the window and the offscreen renderer.
+void RenderDashboard(float currentTime) {
+    frameArena.reset();
+
+    // Main UI Window
+    ImGui::Begin("Rocket Simulation Control Panel", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+    ImGui::SetWindowSize(ImVec2(1280, 720));
+    ImGui::SetWindowPos(ImVec2(0, 0));
+
+    // Launch and Abort Buttons
+    ImGui::SetCursorPos(ImVec2(10, 20));
+    if (ImGui::Button("Launch", ImVec2(100, 40))) {
+        if (!flight.isLiftoffInitiated) {
+            ClearTelemetry();
+        }
+        LaunchFlight(flight, currentTime);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Abort", ImVec2(100, 40))) {
+        AbortFlight(flight);
+    }
+
+    ImGui::Columns(4, "columns", false);
+
+    // Combined Child Window for Engines and Fuel Tanks
+    ImGui::BeginChild("EngineSection", ImVec2(0, 500), false, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground);
+    ImGui::Text("Engine Status and Fuel Tanks");
+    for (int i = 0; i < 5; i++) {
+        ImGui::TextUnformatted(EngineLabel(i));
+        ImGui::ProgressBar(flight.thrustLevels[i] / 100.0f, ImVec2(0.0f, 0.0f), ThrottleLabel(i, flight.thrustLevels[i]));
+        ImGui::Separator();
+    }
+
+    ImVec2 barSize = ImVec2(30, 150);
+    ImGui::Text("Fuel Tanks:");
+    ImGui::SetCursorPos(ImVec2(30, 300));
+    DrawVerticalBar(flight.fuelLevel, ImGui::GetCursorScreenPos(), barSize, IM_COL32(0, 255, 0, 255));
+    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
+    ImGui::Text("LOX");
+
+    ImGui::SetCursorPos(ImVec2(100, 300));
+    DrawVerticalBar(flight.fuelLevel, ImGui::GetCursorScreenPos(), barSize, IM_COL32(0, 255, 0, 255));
+    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
+    ImGui::Text("RP-1");
+
+    ImGui::SetCursorPos(ImVec2(170, 300));
+    DrawVerticalBar((flight.altitude / flight.scenario->rampAltitude) * 100.0f, ImGui::GetCursorScreenPos(), barSize, IM_COL32(255, 165, 0, 255));
+    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
+    ImGui::Text("Altitude");
+
+    ImGui::SetCursorPos(ImVec2(240, 300));
+    DrawVerticalBar((flight.acceleration / flight.scenario->maxAcceleration) * 100.0f, ImGui::GetCursorScreenPos(), barSize, IM_COL32(255, 69, 0, 255));
+    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
+    ImGui::Text("Acceleration");
+
+    ImGui::EndChild();
+
+    ImGui::NextColumn();
+
+    // Flight Data and Status
+    ImGui::BeginChild("FlightData", ImVec2(0, 500), true, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground);
+    ImGui::Text("Flight Data");
+    ImGui::Text("Flight Time: %.2f seconds", currentTime);
+    ImGui::Text("Speed: %.2f m/s", flight.speed);
+    ImGui::Text("Altitude: %.2f m", flight.altitude);
+    ImGui::Text("Acceleration: %.2f m/s^2", flight.acceleration);
+
+    const std::array<float, 5>& thrustLevels = flight.thrustLevels;
+    float totalThrust = thrustLevels[0] + thrustLevels[1] + thrustLevels[2] + thrustLevels[3] + thrustLevels[4];
+    ImGui::Text("Total Thrust Level: %.1f%%", totalThrust);
+
+    if (flight.isLiftoffInitiated && !flight.isLiftoffComplete) {
+        ImGui::Text("Liftoff in %.1f seconds...", flight.scenario->countdown - (currentTime - flight.liftoffStartTime));
+    }
+    else if (flight.isLiftoffComplete) {
+        ImGui::Text("Liftoff!");
+    }
+
+    ImGui::EndChild();
+
+    ImGui::NextColumn();
+
+    // New Flight Progress Panel
+    RenderFlightProgressPanel();
+
+    ImGui::SetCursorPosY(215); // Set only the Y position
+    RenderStructuralDataPanel();
+
+   
+    
+    RenderSpatialPositioningPanel(flight.rocket);
+    ImGui::NextColumn();
+    
+    
+
+    // Progress Panel
+    ImGui::BeginChild("ProgressPanel", ImVec2(0, 500), true, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground);
+    ImGui::Text("Progress");
+
+    // Dynamically highlight based on the state
+    ImGui::PushStyleColor(ImGuiCol_Button, flight.currentProgress >= LOAD_FUEL ? IM_COL32(100, 255, 100, 255) : IM_COL32(255, 100, 100, 255));
+    ImGui::Button("Load Fuel", ImVec2(-1, 0));
+    ImGui::PopStyleColor();
+
+    ImGui::PushStyleColor(ImGuiCol_Button, flight.currentProgress >= COUNTDOWN ? IM_COL32(100, 255, 100, 255) : IM_COL32(255, 100, 100, 255));
+    ImGui::Button("Countdown", ImVec2(-1, 0));
+    ImGui::PopStyleColor();
+
+    ImGui::PushStyleColor(ImGuiCol_Button, flight.currentProgress >= START_ENGINES ? IM_COL32(100, 255, 100, 255) : IM_COL32(255, 100, 100, 255));
+    ImGui::Button("Start Engines", ImVec2(-1, 0));
+    ImGui::PopStyleColor();
+
+    ImGui::PushStyleColor(ImGuiCol_Button, flight.currentProgress >= LIFTOFF ? IM_COL32(30, 144, 255, 255) : IM_COL32(255, 100, 100, 255));  // Blue for Liftoff
+    ImGui::Button("Liftoff", ImVec2(-1, 0));
+    ImGui::PopStyleColor();
 
     ImGui::EndChild();
+
+    ImGui::Columns(1);
+
+    ImGui::End();  // End the main window
+
+    RenderAdditionalWindow();
+    RenderAnimationWindow();
 }
 
+int main(int argc, char** argv) {
+    int exitCode = 0;
+    DashboardHooks dashboard;
+    dashboard.flight = &flight;
+    dashboard.afterStep = RecordTelemetry;
+    dashboard.buildFrame = RenderDashboard;
+    if (RunCommandLineMode(argc, argv, exitCode, dashboard)) {
+        return exitCode;
+    }
 
-int main() {
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
@@ -161,214 +606,113 @@ int main() {
     glfwMakeContextCurrent(window);
 
     IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(ImGuiHeap::allocate, ImGuiHeap::free);
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     ImGui::StyleColorsDark();
+    InstallRedrawCallbacks(window);
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 130");
+    ImGui_ImplOpenGL3_SetPersistentBuffers(true); // Falls back to glBufferData without GL 4.4 / ARB_buffer_storage
+    animationView.init();
+    SharedStatePublisher statePublisher;
+    statePublisher.open();
+    CommandServer commandServer;
+    SimulationControl control;
+    commandServer.setWakeCallback(glfwPostEmptyEvent);
+    commandServer.start();
 
     float previousTime = glfwGetTime();
+    int lastDisplayW = 0, lastDisplayH = 0;
+    double lastRedrawTime = 0.0;
+    ProgressState progressBefore = flight.currentProgress;
+    bool initiatedBefore = flight.isLiftoffInitiated;
 
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        // A background campaign publishes live estimates, keep drawing them at full rate;
+        // the pending frames also show its final result once it stops
+        if (backgroundCampaign.isRunning()) {
+            RequestRedraw();
+        }
+        // Full rate during flight, otherwise sleep until input or the next clock refresh
+        if (IsFlightActive(flight) || pendingRedrawFrames > 0) {
+            glfwPollEvents();
+        }
+        else {
+            double untilRefresh = IDLE_REFRESH_INTERVAL - (glfwGetTime() - lastRedrawTime);
+            glfwWaitEventsTimeout(untilRefresh > 0.0 ? untilRefresh : 0.0);
+        }
 
         // Calculate deltaTime for smooth physics updates
         float currentTime = glfwGetTime();
         float deltaTime = currentTime - previousTime;
         previousTime = currentTime;
 
-        // Liftoff countdown logic
-        if (isLiftoffInitiated && !isLiftoffComplete) {
-            currentProgress = COUNTDOWN;
-            if (currentTime - liftoffStartTime >= 10.0f) {
-                isLiftoffComplete = true;
-                currentProgress = LIFTOFF;
-                std::cout << "Liftoff complete!" << std::endl;
-            }
+        if (commandServer.apply(flight, currentTime, control) > 0) {
+            RequestRedraw();
         }
-
-        // Apply thrust if liftoff is complete and fuel is available
-        if (isLiftoffComplete && fuelLevel > 0.0f) {
-            rocket.applyThrust(thrustLevels, deltaTime); // Apply thrust to all engines
-            rocket.update(deltaTime);
-            currentProgress = START_ENGINES;
-
-            // Update fuel level based on thrust and decrease mass accordingly
-            float totalThrust = thrustLevels[0] + thrustLevels[1] + thrustLevels[2] + thrustLevels[3] + thrustLevels[4];
-            float fuelConsumption = totalThrust * 0.05f * deltaTime;
-            fuelLevel -= fuelConsumption;
-            if (fuelLevel < 0.0f) fuelLevel = 0.0f;
-
-            // Update the mass of the rocket as fuel burns
-            currentMass = DRY_MASS + (fuelLevel / 100.0f) * (500.0f - DRY_MASS); // Dry mass + remaining fuel mass
-
-            // Calculate acceleration based on thrust and current mass
-            acceleration = totalThrust / currentMass;
-
-            // Clamp acceleration to maximum value for visual representation
-            if (acceleration > MAX_ACCELERATION) acceleration = MAX_ACCELERATION;
-
-            // Update altitude and speed
-            altitude = rocket.position.y;
-            speed = rocket.velocity.y;
-
-            // Ensure the altitude bar fills up to the maximum defined value
-            if (altitude > MAX_ALTITUDE) altitude = MAX_ALTITUDE;
-
-            // Dynamically adjust thrust levels based on altitude
-            for (int i = 0; i < thrustLevels.size(); i++) {
-                thrustLevels[i] = 80.0f + 20.0f * (rocket.position.y / MAX_ALTITUDE);
-            }
+        if (control.quitRequested) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
         }
 
-        // Start a new ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        // Main UI Window
-        ImGui::Begin("Rocket Simulation Control Panel", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
-        ImGui::SetWindowSize(ImVec2(1280, 720));
-        ImGui::SetWindowPos(ImVec2(0, 0));
-
-        // Launch and Abort Buttons
-        ImGui::SetCursorPos(ImVec2(10, 20));
-        if (ImGui::Button("Launch", ImVec2(100, 40))) {
-            if (!isLiftoffInitiated) {
-                isLiftoffInitiated = true;
-                isLiftoffComplete = false;
-                liftoffStartTime = currentTime;
-                rocket = Rocket(); // Reset rocket state
-                fuelLevel = 100.0f; // Reset fuel level
-                currentMass = 500.0f; // Reset mass
-                altitude = 0.0f; // Reset altitude
-                speed = 0.0f; // Reset speed
-                currentProgress = LOAD_FUEL;
-                std::cout << "Liftoff initiated, countdown started!" << std::endl;
-            }
+        // A remote timestep caps the physics step: the frame is split into equal substeps
+        int substeps = 1;
+        if (control.timeStep > 0.0f) {
+            substeps = static_cast<int>(std::ceil(deltaTime / control.timeStep));
+            substeps = substeps < 1 ? 1 : (substeps > MAX_SUBSTEPS ? MAX_SUBSTEPS : substeps);
         }
-        ImGui::SameLine();
-        if (ImGui::Button("Abort", ImVec2(100, 40))) {
-            isLiftoffInitiated = false;
-            fuelLevel = 0.0f;
-            currentProgress = LOAD_FUEL;
+        for (int i = 1; i <= substeps; i++) {
+            float stepTime = currentTime - deltaTime + deltaTime * i / substeps;
+            UpdateFlight(flight, stepTime, deltaTime / substeps);
+            statePublisher.publish(flight, stepTime);
+            RecordTelemetry(stepTime);
         }
 
-        ImGui::Columns(4, "columns", false);
-
-        // Combined Child Window for Engines and Fuel Tanks
-        ImGui::BeginChild("EngineSection", ImVec2(0, 500), false, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground);
-        ImGui::Text("Engine Status and Fuel Tanks");
-        for (int i = 0; i < 5; i++) {
-            std::string engineLabel = "Engine #" + std::to_string(i + 1);
-            std::string thrustLabel = "Throttle: " + std::to_string(static_cast<int>(thrustLevels[i])) + "%";
-            ImGui::Text("%s", engineLabel.c_str());
-            ImGui::ProgressBar(thrustLevels[i] / 100.0f, ImVec2(0.0f, 0.0f), thrustLabel.c_str());
-            ImGui::Separator();
+        bool stateChanged = flight.currentProgress != progressBefore || flight.isLiftoffInitiated != initiatedBefore;
+        if (!IsFlightActive(flight) && !stateChanged && pendingRedrawFrames == 0
+            && currentTime - lastRedrawTime < IDLE_REFRESH_INTERVAL) {
+            continue; // Nothing moved and nobody touched the console
         }
+        if (pendingRedrawFrames > 0) pendingRedrawFrames--;
+        lastRedrawTime = currentTime;
 
-        ImVec2 barSize = ImVec2(30, 150);
-        ImGui::Text("Fuel Tanks:");
-        ImGui::SetCursorPos(ImVec2(30, 300));
-        DrawVerticalBar(fuelLevel, ImGui::GetCursorScreenPos(), barSize, IM_COL32(0, 255, 0, 255));
-        ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
-        ImGui::Text("LOX");
-
-        ImGui::SetCursorPos(ImVec2(100, 300));
-        DrawVerticalBar(fuelLevel, ImGui::GetCursorScreenPos(), barSize, IM_COL32(0, 255, 0, 255));
-        ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
-        ImGui::Text("RP-1");
-
-        ImGui::SetCursorPos(ImVec2(170, 300));
-        DrawVerticalBar((altitude / MAX_ALTITUDE) * 100.0f, ImGui::GetCursorScreenPos(), barSize, IM_COL32(255, 165, 0, 255));
-        ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
-        ImGui::Text("Altitude");
-
-        ImGui::SetCursorPos(ImVec2(240, 300));
-        DrawVerticalBar((acceleration / MAX_ACCELERATION) * 100.0f, ImGui::GetCursorScreenPos(), barSize, IM_COL32(255, 69, 0, 255));
-        ImGui::SetCursorPosY(ImGui::GetCursorPosY() + barSize.y + 5);
-        ImGui::Text("Acceleration");
-
-        ImGui::EndChild();
-
-        ImGui::NextColumn();
-
-        // Flight Data and Status
-        ImGui::BeginChild("FlightData", ImVec2(0, 500), true, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground);
-        ImGui::Text("Flight Data");
-        ImGui::Text("Flight Time: %.2f seconds", currentTime);
-        ImGui::Text("Speed: %.2f m/s", speed);
-        ImGui::Text("Altitude: %.2f m", altitude);
-        ImGui::Text("Acceleration: %.2f m/s^2", acceleration);
-
-        float totalThrust = thrustLevels[0] + thrustLevels[1] + thrustLevels[2] + thrustLevels[3] + thrustLevels[4];
-        ImGui::Text("Total Thrust Level: %.1f%%", totalThrust);
-
-        if (isLiftoffInitiated && !isLiftoffComplete) {
-            ImGui::Text("Liftoff in %.1f seconds...", 10.0f - (currentTime - liftoffStartTime));
-        }
-        else if (isLiftoffComplete) {
-            ImGui::Text("Liftoff!");
-        }
-
-        ImGui::EndChild();
-
-        ImGui::NextColumn();
-
-        // New Flight Progress Panel
-        RenderFlightProgressPanel();
-
-        ImGui::SetCursorPosY(215); // Set only the Y position
-        RenderStructuralDataPanel();
-
-       
-        
-        RenderSpatialPositioningPanel(rocket);
-        ImGui::NextColumn();
-        
-        
-
-        // Progress Panel
-        ImGui::BeginChild("ProgressPanel", ImVec2(0, 500), true, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground);
-        ImGui::Text("Progress");
-
-        // Dynamically highlight based on the state
-        ImGui::PushStyleColor(ImGuiCol_Button, currentProgress >= LOAD_FUEL ? IM_COL32(100, 255, 100, 255) : IM_COL32(255, 100, 100, 255));
-        ImGui::Button("Load Fuel", ImVec2(-1, 0));
-        ImGui::PopStyleColor();
-
-        ImGui::PushStyleColor(ImGuiCol_Button, currentProgress >= COUNTDOWN ? IM_COL32(100, 255, 100, 255) : IM_COL32(255, 100, 100, 255));
-        ImGui::Button("Countdown", ImVec2(-1, 0));
-        ImGui::PopStyleColor();
+        frameAllocations.beginFrame();
 
-        ImGui::PushStyleColor(ImGuiCol_Button, currentProgress >= START_ENGINES ? IM_COL32(100, 255, 100, 255) : IM_COL32(255, 100, 100, 255));
-        ImGui::Button("Start Engines", ImVec2(-1, 0));
-        ImGui::PopStyleColor();
-
-        ImGui::PushStyleColor(ImGuiCol_Button, currentProgress >= LIFTOFF ? IM_COL32(30, 144, 255, 255) : IM_COL32(255, 100, 100, 255));  // Blue for Liftoff
-        ImGui::Button("Liftoff", ImVec2(-1, 0));
-        ImGui::PopStyleColor();
-
-        ImGui::EndChild();
-
-        ImGui::Columns(1);
-
-        ImGui::End();  // End the main window
+        // Start a new ImGui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
 
-        RenderAdditionalWindow();
+        RenderDashboard(currentTime);
 
         // Render the UI
         ImGui::Render();
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
+        // Layout changes from this frame's simulation step or from its buttons
+        if (display_w != lastDisplayW || display_h != lastDisplayH || stateChanged
+            || flight.currentProgress != progressBefore || flight.isLiftoffInitiated != initiatedBefore) {
+            frameAllocations.restartWarmup(); // Layout changed, ImGui may grow its buffers once more
+            lastDisplayW = display_w;
+            lastDisplayH = display_h;
+        }
         glViewport(0, 0, display_w, display_h);
         glClearColor(0.45f, 0.55f, 0.60f, 1.00f);
         glClear(GL_COLOR_BUFFER_BIT);
+        double renderStart = glfwGetTime();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        ROCKET_RECORD(RENDER_TIME_US, (glfwGetTime() - renderStart) * 1.0e6);
 
         glfwSwapBuffers(window);
+        frameAllocations.endFrame();
+        progressBefore = flight.currentProgress;
+        initiatedBefore = flight.isLiftoffInitiated;
     }
 
+    commandServer.stop();
+    telemetryServer.stop();
+    backgroundCampaign.stop();
+    animationView.shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -1,44 +1,52 @@
 #include "Rocket.h"
+#include "Instrumentation.h"
+#include "RocketDynamics.h"
+#include <cmath>
+
+// A step is only integrated for a positive, finite deltaTime; anything else
+// (a stalled clock, a NaN from upstream) is rejected and counted.
+static bool isValidStep(float deltaTime) {
+    return deltaTime > 0.0f && std::isfinite(deltaTime);
+}
 
 Rocket::Rocket()
     :position(0.0f, 0.0f, 0.0f),  // Start at origin (x=0, y=0, z=0)
     velocity(0.0f, 0.0f, 0.0f),  // No initial movement
     fuel(100.0f),                // Start with full fuel
     gravity(-9.81f),             // Gravity pulling downward along y-axis
-    engineThrust{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f } // Initialize engine thrusts to 0
+    engineThrust{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }, // Initialize engine thrusts to 0
+    pitch(0.0f), yaw(0.0f),      // Standing upright
+    pitchRate(0.0f), yawRate(0.0f),
+    gimbalPitch{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+    gimbalYaw{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+    gimbalArm(5.0f), engineSpacing(1.5f), gyrationRadius(3.0f),
+    misalignmentPitch(0.0f), misalignmentYaw(0.0f),
+    thrustFactor{ 1.0f, 1.0f, 1.0f, 1.0f, 1.0f }, fuelFactor(1.0f),
+    gimbalStuck{ false, false, false, false, false }
 {}
 
-// Use const std::array<float, 5>& for the thrustValues parameter
 void Rocket::applyThrust(const std::array<float, 5>& thrustValues, float deltaTime) {
+    if (!isValidStep(deltaTime)) {
+        ROCKET_COUNT(INTEGRATOR_REJECTIONS);
+        return;
+    }
     if (fuel > 0.0f) {
-        // Calculate total thrust from all engines
-        float totalThrust = 0.0f;
-        for (int i = 0; i < 5; i++) {
-            engineThrust[i] = thrustValues[i];
-            totalThrust += engineThrust[i];
-        }
-
-        // Apply the total thrust to increase the rocket's upward velocity (along y-axis)
-        velocity.y += totalThrust * deltaTime;
-
-        // Decrease fuel based on total thrust
-        fuel -= totalThrust * 0.1f * deltaTime;
-        if (fuel < 0.0f) {
-            fuel = 0.0f;  // Ensure fuel doesn't drop below 0
+        ROCKET_COUNT(THRUST_APPLICATIONS);
+        if (ApplyThrustStep(*this, thrustValues, deltaTime)) {
+            ROCKET_COUNT(FUEL_CLAMPS);
         }
     }
 }
 
 void Rocket::update(float deltaTime) {
-    // Apply gravity to the rocket's velocity
-    velocity.y += gravity * deltaTime;
-
-    // Update the rocket's position based on its velocity
-    position += velocity * deltaTime;
+    if (!isValidStep(deltaTime)) {
+        ROCKET_COUNT(INTEGRATOR_REJECTIONS);
+        return;
+    }
+    ROCKET_COUNT(PHYSICS_STEPS);
+    ROCKET_RECORD(STEP_DELTA_TIME_US, deltaTime * 1.0e6);
 
-    // Prevent the rocket from falling below the ground (y = 0)
-    if (position.y < 0) {
-        position.y = 0;
-        velocity.y = 0;
+    if (IntegrateStep(*this, deltaTime)) {
+        ROCKET_COUNT(GROUND_CLAMPS);
     }
 }
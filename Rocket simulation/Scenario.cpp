@@ -0,0 +1,441 @@
+#include "Scenario.h"
+#include "Gravity.h"
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Constant-initialized, so flights built during static initialization see it
+constexpr Scenario DEFAULT_SCENARIO = {
+    "Default",
+    100.0f, 500.0f, 0.05f, { 100.0f, 100.0f, 100.0f, 100.0f, 100.0f },
+    -9.81f, GRAVITY_FLAT, 28.5729f, -80.6490f, // Flat; the site is used by the round-Earth models
+    10.0f, 80.0f, 20.0f, 10000.0f,
+    20.0f,
+    5.0f, 1.5f, 3.0f, 5.0f, { 0.0f, 0.0f },
+    50.0f, { 100.0f, 50.0f, 14.0f }, { 0.5f, 2.0f }, 0.0f, // Attitude loop near 10 rad/s, throttle loop off
+    { { 100.0f, 0.05f, 0.02f }, { 100.0f, 0.05f, 0.01f }, { 100.0f, 0.01f, 0.005f },
+      { 10.0f, 2.5f, 1.0f }, { 10.0f, 0.1f, 0.02f }, { 20.0f, 0.5f, 2.0f } }, 1u,
+    0.05f, 0.02f, { 0.0f, 2.0f }, 0.02f, 0.01f,
+    3000.0f, 10.0f
+};
+
+static Scenario activeScenario = DEFAULT_SCENARIO;
+
+const Scenario& DefaultScenario() {
+    return DEFAULT_SCENARIO;
+}
+
+const Scenario& ActiveScenario() {
+    return activeScenario;
+}
+
+void SetActiveScenario(const Scenario& scenario) {
+    activeScenario = scenario;
+}
+
+static uint32_t Fnv1a(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+namespace {
+
+// Just enough JSON for scenario files: objects, arrays, numbers, strings and
+// literals. Every scalar is reported with its path, e.g. "engines[2].initial_thrust",
+// and its line. Duplicate keys and numbers that are not finite are errors.
+class JsonReader {
+public:
+    struct Field {
+        std::string path;
+        int line;       // Where the value starts
+        bool isString;
+        double number;
+        std::string text;
+    };
+
+    JsonReader(const char* begin, const char* end) : cursor(begin), end(end) {}
+
+    bool read(std::vector<Field>& fields) {
+        skipSpace();
+        if (!value("", fields)) return false;
+        skipSpace();
+        return cursor == end || fail("trailing characters");
+    }
+
+    const std::string& error() const { return message; }
+    int line() const { return lineNumber; }
+
+private:
+    bool fail(const char* what) {
+        if (message.empty()) message = what;
+        return false;
+    }
+
+    void skipSpace() {
+        while (cursor != end && std::isspace(static_cast<unsigned char>(*cursor))) {
+            if (*cursor == '\n') lineNumber++;
+            cursor++;
+        }
+    }
+
+    bool consume(char expected) {
+        skipSpace();
+        if (cursor == end || *cursor != expected) return false;
+        cursor++;
+        return true;
+    }
+
+    bool string(std::string& out) {
+        if (!consume('"')) return fail("expected a string");
+        out.clear();
+        while (cursor != end && *cursor != '"') {
+            char c = *cursor++;
+            if (c == '\\') {
+                if (cursor == end) break;
+                c = *cursor++;
+                if (c == 'n') c = '\n';
+                else if (c == 't') c = '\t';
+                else if (c != '"' && c != '\\' && c != '/') return fail("unsupported escape");
+            }
+            out += c;
+        }
+        if (cursor == end) return fail("unterminated string");
+        cursor++;
+        return true;
+    }
+
+    bool value(const std::string& path, std::vector<Field>& fields) {
+        skipSpace();
+        if (cursor == end) return fail("unexpected end of file");
+
+        if (*cursor == '{') {
+            cursor++;
+            if (consume('}')) return true;
+            std::vector<std::string> keys;
+            do {
+                std::string key;
+                if (!string(key)) return false;
+                for (const std::string& seen : keys) {
+                    if (seen == key) return fail("duplicate key");
+                }
+                keys.push_back(key);
+                if (!consume(':')) return fail("expected ':'");
+                if (!value(path.empty() ? key : path + "." + key, fields)) return false;
+            } while (consume(','));
+            return consume('}') || fail("expected ',' or '}'");
+        }
+        if (*cursor == '[') {
+            cursor++;
+            if (consume(']')) return true;
+            int index = 0;
+            do {
+                if (!value(path + "[" + std::to_string(index++) + "]", fields)) return false;
+            } while (consume(','));
+            return consume(']') || fail("expected ',' or ']'");
+        }
+
+        Field field;
+        field.path = path;
+        field.line = lineNumber;
+        field.number = 0.0;
+        if (*cursor == '"') {
+            field.isString = true;
+            if (!string(field.text)) return false;
+        }
+        else {
+            const char* start = cursor;
+            while (cursor != end && (std::isalnum(static_cast<unsigned char>(*cursor)) || std::strchr("+-.", *cursor))) cursor++;
+            std::string token(start, cursor);
+            char* parsed = nullptr;
+            field.isString = false;
+            field.number = std::strtod(token.c_str(), &parsed);
+            if (token.empty() || *parsed != '\0') return fail("expected a value");
+            if (!std::isfinite(field.number)) return fail("numbers must be finite"); // strtod takes nan and inf
+        }
+        fields.push_back(field);
+        return true;
+    }
+
+    const char* cursor;
+    const char* end;
+    int lineNumber = 1;
+    std::string message;
+};
+
+struct ScenarioKey {
+    const char* path;
+    size_t offset;  // float member of Scenario
+};
+
+#define SCENARIO_KEY(path, member) { path, offsetof(Scenario, member) }
+const ScenarioKey SCENARIO_KEYS[] = {
+    SCENARIO_KEY("vehicle.dry_mass", dryMass),
+    SCENARIO_KEY("vehicle.wet_mass", wetMass),
+    SCENARIO_KEY("vehicle.fuel_per_thrust", fuelPerThrust),
+    SCENARIO_KEY("engines[0].initial_thrust", initialThrust[0]),
+    SCENARIO_KEY("engines[1].initial_thrust", initialThrust[1]),
+    SCENARIO_KEY("engines[2].initial_thrust", initialThrust[2]),
+    SCENARIO_KEY("engines[3].initial_thrust", initialThrust[3]),
+    SCENARIO_KEY("engines[4].initial_thrust", initialThrust[4]),
+    SCENARIO_KEY("environment.gravity", gravity),
+    SCENARIO_KEY("environment.latitude", launchLatitude),
+    SCENARIO_KEY("environment.longitude", launchLongitude),
+    SCENARIO_KEY("sequence.countdown", countdown),
+    SCENARIO_KEY("sequence.thrust_ramp.base", rampBase),
+    SCENARIO_KEY("sequence.thrust_ramp.gain", rampGain),
+    SCENARIO_KEY("sequence.thrust_ramp.altitude", rampAltitude),
+    SCENARIO_KEY("display.max_acceleration", maxAcceleration),
+    SCENARIO_KEY("vehicle.gimbal_arm", gimbalArm),
+    SCENARIO_KEY("vehicle.engine_spacing", engineSpacing),
+    SCENARIO_KEY("vehicle.gyration_radius", gyrationRadius),
+    SCENARIO_KEY("vehicle.gimbal_limit", gimbalLimit),
+    SCENARIO_KEY("vehicle.misalignment.pitch", misalignment[0]),
+    SCENARIO_KEY("vehicle.misalignment.yaw", misalignment[1]),
+    SCENARIO_KEY("control.rate", controlRate),
+    SCENARIO_KEY("control.attitude.kp", attitudeGains[0]),
+    SCENARIO_KEY("control.attitude.ki", attitudeGains[1]),
+    SCENARIO_KEY("control.attitude.kd", attitudeGains[2]),
+    SCENARIO_KEY("control.throttle.kp", throttleGains[0]),
+    SCENARIO_KEY("control.throttle.ki", throttleGains[1]),
+    SCENARIO_KEY("control.throttle.target_acceleration", targetAcceleration),
+    SCENARIO_KEY("sensors.attitude.rate", sensors[0].rate),
+    SCENARIO_KEY("sensors.attitude.noise", sensors[0].noise),
+    SCENARIO_KEY("sensors.attitude.bias", sensors[0].bias),
+    SCENARIO_KEY("sensors.gyro.rate", sensors[1].rate),
+    SCENARIO_KEY("sensors.gyro.noise", sensors[1].noise),
+    SCENARIO_KEY("sensors.gyro.bias", sensors[1].bias),
+    SCENARIO_KEY("sensors.accelerometer.rate", sensors[2].rate),
+    SCENARIO_KEY("sensors.accelerometer.noise", sensors[2].noise),
+    SCENARIO_KEY("sensors.accelerometer.bias", sensors[2].bias),
+    SCENARIO_KEY("sensors.gps_position.rate", sensors[3].rate),
+    SCENARIO_KEY("sensors.gps_position.noise", sensors[3].noise),
+    SCENARIO_KEY("sensors.gps_position.bias", sensors[3].bias),
+    SCENARIO_KEY("sensors.gps_velocity.rate", sensors[4].rate),
+    SCENARIO_KEY("sensors.gps_velocity.noise", sensors[4].noise),
+    SCENARIO_KEY("sensors.gps_velocity.bias", sensors[4].bias),
+    SCENARIO_KEY("sensors.altimeter.rate", sensors[5].rate),
+    SCENARIO_KEY("sensors.altimeter.noise", sensors[5].noise),
+    SCENARIO_KEY("sensors.altimeter.bias", sensors[5].bias),
+    SCENARIO_KEY("faults.engine_out_probability", engineOutProbability),
+    SCENARIO_KEY("faults.gimbal_stuck_probability", gimbalStuckProbability),
+    SCENARIO_KEY("faults.window.start", faultWindow[0]),
+    SCENARIO_KEY("faults.window.end", faultWindow[1]),
+    SCENARIO_KEY("faults.thrust_dispersion", thrustDispersion),
+    SCENARIO_KEY("faults.isp_dispersion", ispDispersion),
+    SCENARIO_KEY("success.altitude", successAltitude),
+    SCENARIO_KEY("success.max_tilt", successTilt),
+};
+#undef SCENARIO_KEY
+
+}
+
+bool SetScenarioValue(Scenario& scenario, const char* key, float value) {
+    for (const ScenarioKey& candidate : SCENARIO_KEYS) {
+        if (std::strcmp(key, candidate.path) == 0) {
+            std::memcpy(reinterpret_cast<char*>(&scenario) + candidate.offset, &value, sizeof(value));
+            return true;
+        }
+    }
+    return false;
+}
+
+// JSON key of a float member, nullptr for the rest
+static const char* KeyOf(const Scenario& scenario, const float* member) {
+    size_t offset = static_cast<size_t>(reinterpret_cast<const char*>(member) - reinterpret_cast<const char*>(&scenario));
+    for (const ScenarioKey& candidate : SCENARIO_KEYS) {
+        if (candidate.offset == offset) return candidate.path;
+    }
+    return nullptr;
+}
+
+#define REJECT(member, problem) do { if (key != nullptr) *key = KeyOf(scenario, &scenario.member); return problem; } while (0)
+const char* ValidateScenario(const Scenario& scenario, const char** key) {
+    if (key != nullptr) *key = nullptr;
+    for (const ScenarioKey& candidate : SCENARIO_KEYS) {
+        float value;
+        std::memcpy(&value, reinterpret_cast<const char*>(&scenario) + candidate.offset, sizeof(value));
+        if (!std::isfinite(value)) {
+            if (key != nullptr) *key = candidate.path;
+            return "numbers must be finite and within float range";
+        }
+    }
+
+    if (!(scenario.dryMass > 0.0f)) REJECT(dryMass, "vehicle.dry_mass must be positive");
+    if (!(scenario.wetMass >= scenario.dryMass)) REJECT(wetMass, "vehicle.wet_mass must be at least the dry mass");
+    if (!(scenario.fuelPerThrust >= 0.0f)) REJECT(fuelPerThrust, "vehicle.fuel_per_thrust must not be negative");
+    for (int i = 0; i < SCENARIO_ENGINES; i++) {
+        if (!(scenario.initialThrust[i] >= 0.0f && scenario.initialThrust[i] <= 100.0f)) REJECT(initialThrust[i], "initial_thrust must be 0-100");
+    }
+    if (!(scenario.gravity < 0.0f)) REJECT(gravity, "environment.gravity must be negative, pointing down");
+    if (scenario.gravityModel < GRAVITY_FLAT || scenario.gravityModel > GRAVITY_J2) {
+        if (key != nullptr) *key = "environment.gravity_model";
+        return "unknown gravity model";
+    }
+    if (!(scenario.launchLatitude >= -90.0f && scenario.launchLatitude <= 90.0f)) REJECT(launchLatitude, "environment.latitude must be -90 to 90");
+    if (!(scenario.launchLongitude >= -180.0f && scenario.launchLongitude <= 180.0f)) REJECT(launchLongitude, "environment.longitude must be -180 to 180");
+    if (!(scenario.countdown >= 0.0f)) REJECT(countdown, "sequence.countdown must not be negative");
+    if (!(scenario.rampBase >= 0.0f && scenario.rampBase <= 100.0f)) REJECT(rampBase, "sequence.thrust_ramp.base must be 0-100");
+    float rampTop = scenario.rampBase + scenario.rampGain;
+    if (!(rampTop >= 0.0f && rampTop <= 100.0f)) REJECT(rampGain, "sequence.thrust_ramp base plus gain must be 0-100");
+    if (!(scenario.rampAltitude > 0.0f)) REJECT(rampAltitude, "sequence.thrust_ramp.altitude must be positive");
+    if (!(scenario.maxAcceleration > 0.0f)) REJECT(maxAcceleration, "display.max_acceleration must be positive");
+    if (!(scenario.gimbalArm > 0.0f)) REJECT(gimbalArm, "vehicle.gimbal_arm must be positive");
+    if (!(scenario.engineSpacing >= 0.0f)) REJECT(engineSpacing, "vehicle.engine_spacing must not be negative");
+    if (!(scenario.gyrationRadius > 0.0f)) REJECT(gyrationRadius, "vehicle.gyration_radius must be positive");
+    if (!(scenario.gimbalLimit >= 0.0f && scenario.gimbalLimit <= 30.0f)) REJECT(gimbalLimit, "vehicle.gimbal_limit must be 0-30");
+    for (int i = 0; i < 2; i++) {
+        if (!(std::abs(scenario.misalignment[i]) <= 10.0f)) REJECT(misalignment[i], "vehicle.misalignment must be within 10 degrees");
+    }
+    if (!(scenario.controlRate >= 0.0f && scenario.controlRate <= 10000.0f)) REJECT(controlRate, "control.rate must be 0-10000");
+    for (int i = 0; i < 3; i++) {
+        if (!(scenario.attitudeGains[i] >= 0.0f)) REJECT(attitudeGains[i], "control.attitude gains must not be negative");
+    }
+    for (int i = 0; i < 2; i++) {
+        if (!(scenario.throttleGains[i] >= 0.0f)) REJECT(throttleGains[i], "control.throttle gains must not be negative");
+    }
+    if (!(scenario.targetAcceleration >= 0.0f && scenario.targetAcceleration <= scenario.maxAcceleration)) REJECT(targetAcceleration, "control.throttle.target_acceleration must be 0 to display.max_acceleration");
+    for (int i = 0; i < SCENARIO_SENSORS; i++) {
+        const SensorNoise& sensor = scenario.sensors[i];
+        if (!(sensor.rate >= 0.0f && sensor.rate <= 10000.0f)) REJECT(sensors[i].rate, "sensors rate must be 0-10000");
+        if (!(sensor.noise >= 0.0f)) REJECT(sensors[i].noise, "sensors noise must not be negative");
+        if (!(sensor.bias >= 0.0f)) REJECT(sensors[i].bias, "sensors bias must not be negative");
+    }
+    if (!(scenario.engineOutProbability >= 0.0f && scenario.engineOutProbability <= 1.0f)) REJECT(engineOutProbability, "faults.engine_out_probability must be 0-1");
+    if (!(scenario.gimbalStuckProbability >= 0.0f && scenario.gimbalStuckProbability <= 1.0f)) REJECT(gimbalStuckProbability, "faults.gimbal_stuck_probability must be 0-1");
+    if (!(scenario.faultWindow[0] >= 0.0f)) REJECT(faultWindow[0], "faults.window must start at or after liftoff");
+    if (!(scenario.faultWindow[1] >= scenario.faultWindow[0])) REJECT(faultWindow[1], "faults.window must not end before it starts");
+    if (!(scenario.thrustDispersion >= 0.0f && scenario.thrustDispersion <= 0.5f)) REJECT(thrustDispersion, "faults.thrust_dispersion must be 0-0.5");
+    if (!(scenario.ispDispersion >= 0.0f && scenario.ispDispersion <= 0.5f)) REJECT(ispDispersion, "faults.isp_dispersion must be 0-0.5");
+    if (!(scenario.successAltitude >= 0.0f)) REJECT(successAltitude, "success.altitude must not be negative");
+    if (!(scenario.successTilt >= 0.0f && scenario.successTilt <= 180.0f)) REJECT(successTilt, "success.max_tilt must be 0-180");
+    return nullptr;
+}
+#undef REJECT
+
+static bool ParseScenarioJson(const char* path, const std::string& text, Scenario& scenario) {
+    std::vector<JsonReader::Field> fields;
+    JsonReader reader(text.data(), text.data() + text.size());
+    if (!reader.read(fields)) {
+        std::cerr << path << ":" << reader.line() << ": " << reader.error() << std::endl;
+        return false;
+    }
+
+    Scenario parsed = DefaultScenario();
+    for (const JsonReader::Field& field : fields) {
+        if (field.path == "name" && field.isString) {
+            std::memset(parsed.name, 0, sizeof(parsed.name));
+            std::strncpy(parsed.name, field.text.c_str(), sizeof(parsed.name) - 1);
+            continue;
+        }
+        if (field.path == "environment.gravity_model" && field.isString) {
+            const char* const models[] = { "flat", "inverse_square", "j2" };
+            parsed.gravityModel = -1;
+            for (int i = 0; i < 3; i++) {
+                if (field.text == models[i]) parsed.gravityModel = i;
+            }
+            if (parsed.gravityModel < 0) {
+                std::cerr << path << ":" << field.line << ": gravity_model must be flat, inverse_square or j2" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        if (field.path == "sensors.seed" && !field.isString) {
+            if (!(field.number >= 0.0 && field.number <= 4294967295.0 && field.number == std::floor(field.number))) {
+                std::cerr << path << ":" << field.line << ": sensors.seed must be a whole number 0-4294967295" << std::endl;
+                return false;
+            }
+            parsed.sensorSeed = static_cast<uint32_t>(field.number);
+            continue;
+        }
+        const ScenarioKey* key = nullptr;
+        for (const ScenarioKey& candidate : SCENARIO_KEYS) {
+            if (field.path == candidate.path) key = &candidate;
+        }
+        if (key == nullptr || field.isString) {
+            std::cerr << path << ":" << field.line << ": unknown or mistyped key " << field.path << std::endl;
+            return false;
+        }
+        float number = static_cast<float>(field.number);
+        std::memcpy(reinterpret_cast<char*>(&parsed) + key->offset, &number, sizeof(number));
+    }
+
+    // Point at the offending field, or at the file if it kept its default
+    const char* key = nullptr;
+    if (const char* problem = ValidateScenario(parsed, &key)) {
+        std::cerr << path << ":";
+        for (const JsonReader::Field& field : fields) {
+            if (key != nullptr && field.path == key) std::cerr << field.line << ":";
+        }
+        std::cerr << " " << problem;
+        if (key != nullptr && std::strstr(problem, key) == nullptr) std::cerr << " (" << key << ")";
+        std::cerr << std::endl;
+        return false;
+    }
+    scenario = parsed;
+    return true;
+}
+
+bool LoadScenario(const char* path, Scenario& scenario) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open scenario " << path << std::endl;
+        return false;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    uint32_t magic = 0;
+    if (contents.size() >= sizeof(magic)) std::memcpy(&magic, contents.data(), sizeof(magic));
+    if (magic != SCENARIO_BINARY_MAGIC) {
+        return ParseScenarioJson(path, contents, scenario);
+    }
+
+    ScenarioFileHeader header;
+    if (contents.size() != sizeof(header) + sizeof(Scenario)) {
+        std::cerr << path << ": truncated compiled scenario" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+    Scenario loaded;
+    std::memcpy(&loaded, contents.data() + sizeof(header), sizeof(loaded));
+    if (header.version != SCENARIO_BINARY_VERSION || header.size != sizeof(Scenario)
+        || header.checksum != Fnv1a(&loaded, sizeof(loaded))) {
+        std::cerr << path << ": compiled by an incompatible build or corrupted, recompile it" << std::endl;
+        return false;
+    }
+    loaded.name[sizeof(loaded.name) - 1] = '\0';
+    if (const char* problem = ValidateScenario(loaded)) {
+        std::cerr << path << ": " << problem << std::endl; // Compiled from a file an older build accepted
+        return false;
+    }
+    scenario = loaded;
+    return true;
+}
+
+bool SaveScenarioBinary(const char* path, const Scenario& scenario) {
+    ScenarioFileHeader header;
+    header.magic = SCENARIO_BINARY_MAGIC;
+    header.version = SCENARIO_BINARY_VERSION;
+    header.size = sizeof(Scenario);
+    header.checksum = Fnv1a(&scenario, sizeof(scenario));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&scenario), sizeof(scenario));
+    if (!file) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
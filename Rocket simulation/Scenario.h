@@ -0,0 +1,109 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <cstdint>
+
+const int SCENARIO_ENGINES = 5; // Matches FlightState::thrustLevels
+const int SCENARIO_SENSORS = 6; // Matches SensorChannel
+
+// One sensor's error model, in the measured quantity's scenario units
+struct SensorNoise {
+    float rate;                 // Hz; 0 reads the true state every step
+    float noise;                // 1-sigma white noise per sample
+    float bias;                 // 1-sigma constant bias, drawn once per vehicle
+};
+
+// One vehicle, its environment and its launch sequence. Read once at startup
+// and never changed afterwards: plain data in one small aligned block, so a
+// campaign shares a single copy across every run and thread.
+struct alignas(64) Scenario {
+    char name[32];
+
+    // Vehicle
+    float dryMass;              // kg, empty tanks
+    float wetMass;              // kg, full tanks
+    float fuelPerThrust;        // Fuel % burned per second per % of summed engine thrust
+    float initialThrust[SCENARIO_ENGINES]; // % at launch
+
+    // Environment
+    float gravity;              // m/s^2 along y, negative is down; flat model only
+    int32_t gravityModel;       // GravityModel
+    float launchLatitude;       // Geodetic degrees, round-Earth models
+    float launchLongitude;      // Degrees east
+
+    // Launch sequence
+    float countdown;            // s between Launch and liftoff
+    float rampBase;             // Thrust % at ground level
+    float rampGain;             // % added by rampAltitude
+    float rampAltitude;         // m, also the altitude bar's full scale
+
+    // Display
+    float maxAcceleration;      // m/s^2, acceleration bar full scale
+
+    // Engine geometry; engine 0 sits on the centre line, 1-4 around it
+    float gimbalArm;            // m from the centre of mass down to the gimbal pivots
+    float engineSpacing;        // m from the centre line out to engines 1-4
+    float gyrationRadius;       // m; pitch and yaw inertia are mass times its square
+    float gimbalLimit;          // Degrees each way
+    float misalignment[2];      // Degrees of fixed thrust misalignment, pitch and yaw
+
+    // Flight control
+    float controlRate;          // Hz; 0 leaves the gimbals centred
+    float attitudeGains[3];     // Kp (1/s^2), Ki (1/s^3), Kd (1/s)
+    float throttleGains[2];     // Kp, Ki (1/s)
+    float targetAcceleration;   // Held by the throttle loop; 0 keeps the thrust ramp
+
+    // Sensors flight control reads, in SensorChannel order: attitude (deg),
+    // gyro (deg/s), accelerometer (dashboard units), GPS position (m), GPS
+    // velocity (m/s), altimeter (m)
+    SensorNoise sensors[SCENARIO_SENSORS];
+    uint32_t sensorSeed;        // Same seed, same noise; in campaigns also the same faults
+
+    // Fault injection, drawn per run by reliability campaigns (Faults.h)
+    float engineOutProbability; // Chance a run loses one engine
+    float gimbalStuckProbability; // Chance one engine's gimbal freezes where it is
+    float faultWindow[2];       // s after liftoff within which those strike, uniformly
+    float thrustDispersion;     // 1-sigma fraction of each engine's thrust
+    float ispDispersion;        // 1-sigma fraction of specific impulse, whole vehicle
+
+    // What a campaign run must achieve to count as a success
+    float successAltitude;      // m at burnout
+    float successTilt;          // Degrees from vertical, at most, through the burn
+};
+
+// Compiled scenario files start with this header; the Scenario follows as-is
+// and loads with one read and a checksum, no parsing.
+const uint32_t SCENARIO_BINARY_MAGIC = 0x4E43534B; // "KSCN"
+const uint32_t SCENARIO_BINARY_VERSION = 5;
+
+struct ScenarioFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;      // sizeof(Scenario), catches layout changes
+    uint32_t checksum;  // FNV-1a of the Scenario bytes
+};
+
+// The built-in vehicle, the values the simulation always had
+const Scenario& DefaultScenario();
+
+// Scenario new flights start from. Set once at startup, before any flight.
+const Scenario& ActiveScenario();
+void SetActiveScenario(const Scenario& scenario);
+
+// Reads a JSON scenario or its compiled form, told apart by the magic. Keys
+// missing from JSON keep their DefaultScenario() value; unknown or duplicate
+// keys and implausible values are errors, reported on std::cerr as file:line.
+bool LoadScenario(const char* path, Scenario& scenario);
+
+// Writes the compiled form
+bool SaveScenarioBinary(const char* path, const Scenario& scenario);
+
+// Sets the number at a JSON key such as "sequence.thrust_ramp.base". False
+// for keys that are not plain numbers.
+bool SetScenarioValue(Scenario& scenario, const char* key, float value);
+
+// What makes the scenario implausible, or nullptr if nothing does. key, if
+// given, receives the JSON key of the field at fault.
+const char* ValidateScenario(const Scenario& scenario, const char** key = nullptr);
+
+#endif
@@ -0,0 +1,292 @@
+#include "Sensitivity.h"
+#include "Control.h"
+#include "Dual.h"
+#include "Flight.h"
+#include "RocketDynamics.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+typedef Dual<double, SENSITIVITY_PARAMETERS> Sensitive;
+
+const float DEGREES_TO_RADIANS = 0.017453292519943295f;
+const int TUNING_ITERATIONS = 20;
+const double TUNING_TOLERANCE = 0.01;   // m of apogee
+const float FINE_STEP_DIVISOR = 100.0f;
+const double CHECK_RELATIVE_STEP = 1.0e-3;
+
+namespace {
+
+template <typename T>
+struct Outcome {
+    bool cutoff;
+    T apogee, cutoffTime, fuelAtCutoff;
+};
+
+// UpdateFlight's powered phase from liftoff, on the true state: the same
+// Rocket step, controller tick, propellant, mass and ramp formulas. It stops
+// when Rocket's tank runs dry (or the flight's, should that come first),
+// partway through the step.
+template <typename T>
+Outcome<T> FlyPowered(const Scenario& scenario, const T (&parameter)[SENSITIVITY_PARAMETERS], float timeStep, float duration) {
+    const T& rampBase = parameter[SENSITIVITY_RAMP_BASE];
+    const T& rampGain = parameter[SENSITIVITY_RAMP_GAIN];
+    const T& rampAltitude = parameter[SENSITIVITY_RAMP_ALTITUDE];
+    const T& dryMass = parameter[SENSITIVITY_DRY_MASS];
+    const T& wetMass = parameter[SENSITIVITY_WET_MASS];
+    const T& fuelPerThrust = parameter[SENSITIVITY_FUEL_PER_THRUST];
+
+    // On the pad, as StartCountdown leaves Rocket
+    RocketBody<T> body;
+    for (int i = 0; i < 3; i++) body.position[i] = body.velocity[i] = T(0.0f);
+    body.fuel = T(100.0f);
+    body.gravity = T(scenario.gravity);
+    body.pitch = body.yaw = body.pitchRate = body.yawRate = T(0.0f);
+    for (int i = 0; i < 5; i++) {
+        body.engineThrust[i] = body.gimbalPitch[i] = body.gimbalYaw[i] = T(0.0f);
+        body.thrustFactor[i] = T(1.0f);
+    }
+    body.gimbalArm = T(scenario.gimbalArm);
+    body.engineSpacing = T(scenario.engineSpacing);
+    body.gyrationRadius = T(scenario.gyrationRadius);
+    body.misalignmentPitch = T(scenario.misalignment[0] * DEGREES_TO_RADIANS);
+    body.misalignmentYaw = T(scenario.misalignment[1] * DEGREES_TO_RADIANS);
+    body.fuelFactor = T(1.0f);
+
+    T levels[SCENARIO_ENGINES];
+    for (int i = 0; i < SCENARIO_ENGINES; i++) levels[i] = T(scenario.initialThrust[i]);
+    T fuelLevel = T(100.0f), mass = wetMass, acceleration = T(0.0f);
+    T pitchIntegral = T(0.0f), yawIntegral = T(0.0f), throttleIntegral = T(0.0f);
+    T gimbalPitch = T(0.0f), gimbalYaw = T(0.0f), throttle = T(0.0f);
+    float clock = 0.0f;
+    const ControlGains gains = ControlGainsFromScenario(scenario);
+    const bool throttleLoop = scenario.controlRate > 0.0f && scenario.targetAcceleration > 0.0f;
+    const T dt = T(timeStep);
+
+    Outcome<T> outcome = { false, T(0.0f), T(0.0f), T(0.0f) };
+    long steps = static_cast<long>(duration / timeStep);
+    for (long step = 0; step < steps; step++) {
+        if (scenario.controlRate > 0.0f) {
+            float period = 1.0f / scenario.controlRate;
+            clock += timeStep;
+            if (clock >= period) {
+                float elapsed = std::floor(clock / period) * period;
+                clock -= elapsed;
+                T thrustAcceleration = T(0.0f);
+                for (const T& level : levels) thrustAcceleration += level;
+                TickControllers(gains, T(elapsed), 1, &body.pitch, &body.yaw, &body.pitchRate, &body.yawRate,
+                    &thrustAcceleration, &acceleration, &mass, &pitchIntegral, &yawIntegral, &throttleIntegral,
+                    &gimbalPitch, &gimbalYaw, &throttle);
+                for (int i = 0; i < 5; i++) {
+                    body.gimbalPitch[i] = gimbalPitch;
+                    body.gimbalYaw[i] = gimbalYaw;
+                }
+                if (throttleLoop) {
+                    for (T& level : levels) level = throttle;
+                }
+            }
+        }
+
+        // Rocket's step; the one that empties its tank is where the engines stop
+        T fuelBefore = body.fuel;
+        T thrustFraction = T(1.0f);
+        bool dry = false;
+        if (body.fuel > T(0.0f)) {
+            dry = ApplyThrustStep(body, levels, dt, true);
+            if (dry) {
+                T delivered = T(0.0f);
+                for (const T& thrust : body.engineThrust) delivered += thrust;
+                thrustFraction = CutoffFraction(fuelBefore, TankBurn(body, delivered, dt));
+            }
+        }
+        IntegrateStep(body, dt);
+
+        T totalThrust = levels[0] * body.thrustFactor[0] + levels[1] * body.thrustFactor[1] + levels[2] * body.thrustFactor[2]
+            + levels[3] * body.thrustFactor[3] + levels[4] * body.thrustFactor[4];
+        T burned = PropellantBurned(totalThrust, fuelPerThrust, body.fuelFactor, dt);
+        T endOfStep = T(static_cast<float>(step + 1) * timeStep);
+        if (dry) {
+            outcome.cutoff = true;
+            outcome.cutoffTime = endOfStep - dt + dt * thrustFraction;
+            outcome.fuelAtCutoff = fuelLevel - burned * thrustFraction;
+            break;
+        }
+        fuelLevel -= burned;
+        if (fuelLevel <= T(0.0f)) {
+            outcome.cutoff = true;
+            outcome.cutoffTime = endOfStep;
+            fuelLevel = T(0.0f);
+            break;
+        }
+        mass = VehicleMass(dryMass, wetMass, fuelLevel);
+        acceleration = totalThrust / mass; // What the accelerometer reads, not clamped like the dashboard's
+        if (!throttleLoop) {
+            for (T& level : levels) level = RampThrustLevel(rampBase, rampGain, body.position[1], rampAltitude);
+        }
+    }
+    outcome.apogee = FlatCoastApogee(body.position[1], body.velocity[1], body.gravity);
+    return outcome;
+}
+
+Outcome<double> FlyWith(const Scenario& scenario, const double (&parameter)[SENSITIVITY_PARAMETERS], float timeStep, float duration) {
+    return FlyPowered(scenario, parameter, timeStep, duration);
+}
+
+void ScenarioParameters(const Scenario& scenario, double (&parameter)[SENSITIVITY_PARAMETERS]) {
+    for (int i = 0; i < SENSITIVITY_PARAMETERS; i++) {
+        parameter[i] = scenario.*SensitivityParameterField(static_cast<SensitivityParameter>(i));
+    }
+}
+
+// ns per call, repeated for about a second
+template <typename Function>
+double TimeCalls(Function function) {
+    long calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    do {
+        function();
+        calls++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < 1.0);
+    return seconds * 1.0e9 / calls;
+}
+
+}
+
+const char* SensitivityParameterName(SensitivityParameter parameter) {
+    switch (parameter) {
+    case SENSITIVITY_RAMP_BASE: return "Ramp base (%)";
+    case SENSITIVITY_RAMP_GAIN: return "Ramp gain (%)";
+    case SENSITIVITY_RAMP_ALTITUDE: return "Ramp altitude (m)";
+    case SENSITIVITY_DRY_MASS: return "Dry mass (kg)";
+    case SENSITIVITY_WET_MASS: return "Wet mass (kg)";
+    case SENSITIVITY_FUEL_PER_THRUST: return "Fuel per thrust";
+    default: return "Unknown";
+    }
+}
+
+float Scenario::* SensitivityParameterField(SensitivityParameter parameter) {
+    switch (parameter) {
+    case SENSITIVITY_RAMP_BASE: return &Scenario::rampBase;
+    case SENSITIVITY_RAMP_GAIN: return &Scenario::rampGain;
+    case SENSITIVITY_RAMP_ALTITUDE: return &Scenario::rampAltitude;
+    case SENSITIVITY_DRY_MASS: return &Scenario::dryMass;
+    case SENSITIVITY_WET_MASS: return &Scenario::wetMass;
+    default: return &Scenario::fuelPerThrust;
+    }
+}
+
+Sensitivities ComputeSensitivities(const Scenario& scenario, float timeStep, float duration) {
+    double values[SENSITIVITY_PARAMETERS];
+    ScenarioParameters(scenario, values);
+    Sensitive parameter[SENSITIVITY_PARAMETERS];
+    for (int i = 0; i < SENSITIVITY_PARAMETERS; i++) parameter[i] = Sensitive::input(values[i], i);
+
+    Outcome<Sensitive> outcome = FlyPowered(scenario, parameter, timeStep, duration);
+    Sensitivities result;
+    result.cutoff = outcome.cutoff;
+    result.apogee = outcome.apogee.value;
+    result.cutoffTime = outcome.cutoffTime.value;
+    result.fuelAtCutoff = outcome.fuelAtCutoff.value;
+    for (int i = 0; i < SENSITIVITY_PARAMETERS; i++) {
+        result.apogeeBy[i] = outcome.apogee.d[i];
+        result.cutoffTimeBy[i] = outcome.cutoffTime.d[i];
+        result.fuelAtCutoffBy[i] = outcome.fuelAtCutoff.d[i];
+    }
+    return result;
+}
+
+Sensitivities DifferenceSensitivities(const Scenario& scenario, float timeStep, float duration, double relativeStep) {
+    double parameter[SENSITIVITY_PARAMETERS];
+    ScenarioParameters(scenario, parameter);
+    Outcome<double> centre = FlyWith(scenario, parameter, timeStep, duration);
+    Sensitivities result;
+    result.cutoff = centre.cutoff;
+    result.apogee = centre.apogee;
+    result.cutoffTime = centre.cutoffTime;
+    result.fuelAtCutoff = centre.fuelAtCutoff;
+    for (int i = 0; i < SENSITIVITY_PARAMETERS; i++) {
+        double value = parameter[i];
+        double step = relativeStep * (value != 0.0 ? std::fabs(value) : 1.0);
+        parameter[i] = value + step;
+        Outcome<double> up = FlyWith(scenario, parameter, timeStep, duration);
+        parameter[i] = value - step;
+        Outcome<double> down = FlyWith(scenario, parameter, timeStep, duration);
+        parameter[i] = value;
+        result.apogeeBy[i] = (up.apogee - down.apogee) / (2.0 * step);
+        result.cutoffTimeBy[i] = (up.cutoffTime - down.cutoffTime) / (2.0 * step);
+        result.fuelAtCutoffBy[i] = (up.fuelAtCutoff - down.fuelAtCutoff) / (2.0 * step);
+    }
+    return result;
+}
+
+bool TuneRampForApogee(Scenario& scenario, double targetApogee, float timeStep, float duration, int& iterations) {
+    for (iterations = 1; iterations <= TUNING_ITERATIONS; iterations++) {
+        Sensitivities flight = ComputeSensitivities(scenario, timeStep, duration);
+        double miss = flight.apogee - targetApogee;
+        if (std::fabs(miss) <= TUNING_TOLERANCE) return true;
+        double slope = flight.apogeeBy[SENSITIVITY_RAMP_BASE];
+        if (!(slope != 0.0) || !std::isfinite(slope)) return false;
+        scenario.rampBase = static_cast<float>(scenario.rampBase - miss / slope);
+    }
+    return false;
+}
+
+int RunSensitivityMode(float timeStep, float targetApogee) {
+    const float duration = 600.0f;
+    if (!(timeStep > 0.0f)) {
+        std::cerr << "Sensitivity analysis needs a positive timestep" << std::endl;
+        return -1;
+    }
+    const Scenario& scenario = ActiveScenario();
+    if (scenario.gravityModel != GRAVITY_FLAT) {
+        std::cerr << "Sensitivity analysis flies the flat gravity model only; " << scenario.name
+            << " uses a round-Earth one" << std::endl;
+        return -1;
+    }
+    Sensitivities dual = ComputeSensitivities(scenario, timeStep, duration);
+    if (!dual.cutoff) {
+        std::cerr << "The engines did not stop within " << duration << " s" << std::endl;
+        return -1;
+    }
+    // Differences check the dual numbers at the same step; a finer step shows
+    // how far the derivatives of this step are from the flight's own
+    Sensitivities difference = DifferenceSensitivities(scenario, timeStep, duration, CHECK_RELATIVE_STEP);
+    float fineStep = timeStep / FINE_STEP_DIVISOR;
+    Sensitivities fine = ComputeSensitivities(scenario, fineStep, duration);
+
+    std::cout << "Sensitivities: " << scenario.name << ", timestep " << timeStep << " s, noise-free flight" << std::endl;
+    std::cout << "Apogee " << dual.apogee << " m, engines stop at T+" << dual.cutoffTime << " s with "
+        << dual.fuelAtCutoff << "% propellant left" << std::endl;
+    std::cout << std::setw(20) << std::left << "d/d" << std::right << std::setw(12) << "value" << std::setw(14) << "apogee"
+        << std::setw(14) << "cut-off" << std::setw(14) << "fuel" << std::setw(16) << "apogee, diff." << std::setw(16)
+        << "apogee, fine" << std::endl;
+    for (int i = 0; i < SENSITIVITY_PARAMETERS; i++) {
+        SensitivityParameter parameter = static_cast<SensitivityParameter>(i);
+        std::cout << std::setw(20) << std::left << SensitivityParameterName(parameter) << std::right
+            << std::setw(12) << scenario.*SensitivityParameterField(parameter)
+            << std::setw(14) << dual.apogeeBy[i] << std::setw(14) << dual.cutoffTimeBy[i]
+            << std::setw(14) << dual.fuelAtCutoffBy[i] << std::setw(16) << difference.apogeeBy[i]
+            << std::setw(16) << fine.apogeeBy[i] << std::endl;
+    }
+    std::cout << "Differences move each parameter by " << 100.0 * CHECK_RELATIVE_STEP << "%; fine timestep " << fineStep
+        << " s" << std::endl;
+
+    double dualTime = TimeCalls([&] { ComputeSensitivities(scenario, timeStep, duration); });
+    double differenceTime = TimeCalls([&] { DifferenceSensitivities(scenario, timeStep, duration, CHECK_RELATIVE_STEP); });
+    std::cout << "One dual pass: " << dualTime / 1000.0 << " us; central differences (" << 2 * SENSITIVITY_PARAMETERS + 1
+        << " passes): " << differenceTime / 1000.0 << " us" << std::endl;
+
+    if (targetApogee > 0.0f) {
+        Scenario tuned = scenario;
+        int iterations = 0;
+        bool converged = TuneRampForApogee(tuned, targetApogee, timeStep, duration, iterations);
+        Sensitivities result = ComputeSensitivities(tuned, timeStep, duration);
+        std::cout << "Ramp base for " << targetApogee << " m: " << tuned.rampBase << "% (apogee " << result.apogee << " m, "
+            << iterations << " passes" << (converged ? ")" : ", did not converge)") << std::endl;
+        if (!converged) return -1;
+    }
+    return 0;
+}
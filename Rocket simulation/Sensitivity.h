@@ -0,0 +1,55 @@
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+
+#include "Scenario.h"
+
+// Derivatives of what a flight achieves with respect to scenario
+// parameters, from one pass of the flight on dual numbers (Dual.h) through
+// the templated Rocket step, controllers and thrust ramp. The flight is the
+// noise-free one: the controllers and the ramp see the true state, and
+// there are no faults. It runs until the engines stop, on the flat gravity
+// model whatever the scenario's: only Rocket's flat step is templated.
+
+enum SensitivityParameter {
+    SENSITIVITY_RAMP_BASE,          // sequence.thrust_ramp.base
+    SENSITIVITY_RAMP_GAIN,          // sequence.thrust_ramp.gain
+    SENSITIVITY_RAMP_ALTITUDE,      // sequence.thrust_ramp.altitude
+    SENSITIVITY_DRY_MASS,           // vehicle.dry_mass
+    SENSITIVITY_WET_MASS,           // vehicle.wet_mass
+    SENSITIVITY_FUEL_PER_THRUST,    // vehicle.fuel_per_thrust
+    SENSITIVITY_PARAMETERS
+};
+
+const char* SensitivityParameterName(SensitivityParameter parameter);
+
+// The scenario field each parameter is
+float Scenario::* SensitivityParameterField(SensitivityParameter parameter);
+
+// Outcomes of the flight and their partial derivatives by parameter
+struct Sensitivities {
+    bool cutoff = false;        // The engines stopped within the duration
+    double apogee = 0.0;        // m, coasting on from cut-off
+    double cutoffTime = 0.0;    // s after liftoff
+    double fuelAtCutoff = 0.0;  // % of the propellant load still on board
+    double apogeeBy[SENSITIVITY_PARAMETERS] = {};
+    double cutoffTimeBy[SENSITIVITY_PARAMETERS] = {};
+    double fuelAtCutoffBy[SENSITIVITY_PARAMETERS] = {};
+};
+
+// One pass on dual numbers: every outcome and all its derivatives
+Sensitivities ComputeSensitivities(const Scenario& scenario, float timeStep, float duration);
+
+// Central differences, two passes in double per parameter, each parameter
+// moved by relativeStep of its value. For checking the dual numbers.
+Sensitivities DifferenceSensitivities(const Scenario& scenario, float timeStep, float duration, double relativeStep);
+
+// Newton's method on the thrust ramp's base level until the flight reaches
+// targetApogee, one dual pass per iteration. Returns false if it does not
+// converge; scenario then holds the last iterate.
+bool TuneRampForApogee(Scenario& scenario, double targetApogee, float timeStep, float duration, int& iterations);
+
+// Prints the derivatives, checks them against central differences and times
+// both; with a target apogee also tunes the ramp for it
+int RunSensitivityMode(float timeStep, float targetApogee);
+
+#endif
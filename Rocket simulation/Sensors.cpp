@@ -0,0 +1,178 @@
+#include "Sensors.h"
+#include "Random.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+const float DEGREES_TO_RADIANS = 0.017453292519943295f;
+const uint32_t SENSOR_BIAS_CHANNEL = 0x100; // Plus the sensor's channel; drawn at counter 0
+
+namespace {
+
+// Where a sensor's values sit in SensorValues and how its scenario units convert
+struct SensorLayout {
+    const char* name;
+    size_t first;
+    size_t axes;
+    float scale;
+};
+
+#define SENSOR_LAYOUT(name, member, scale) \
+    { name, offsetof(SensorValues, member) / sizeof(float), sizeof(SensorValues::member) / sizeof(float), scale }
+const SensorLayout SENSOR_LAYOUTS[SENSOR_COUNT] = {
+    SENSOR_LAYOUT("Attitude", attitude, DEGREES_TO_RADIANS),
+    SENSOR_LAYOUT("Gyro", rate, DEGREES_TO_RADIANS),
+    SENSOR_LAYOUT("Accelerometer", acceleration, 1.0f),
+    SENSOR_LAYOUT("GPS position", position, 1.0f),
+    SENSOR_LAYOUT("GPS velocity", velocity, 1.0f),
+    SENSOR_LAYOUT("Altimeter", altitude, 1.0f),
+};
+#undef SENSOR_LAYOUT
+
+}
+
+const char* SensorName(SensorChannel channel) {
+    return channel >= 0 && channel < SENSOR_COUNT ? SENSOR_LAYOUTS[channel].name : "?";
+}
+
+float SensorVariance(const Scenario& scenario, SensorChannel channel) {
+    const SensorNoise& model = scenario.sensors[channel];
+    float scale = SENSOR_LAYOUTS[channel].scale;
+    return (model.noise * model.noise + model.bias * model.bias) * scale * scale;
+}
+
+void MeasureSensor(const Scenario& scenario, SensorChannel channel, uint32_t sample, size_t count,
+    const uint32_t* vehicles, const float* truth, float* reading, float* scratch) {
+    const SensorLayout& layout = SENSOR_LAYOUTS[channel];
+    const SensorNoise& model = scenario.sensors[channel];
+    const float biasScale = model.bias * layout.scale;
+    const float noiseScale = model.noise * layout.scale;
+
+    // The bias is drawn again rather than stored: one more block per sample
+    // buys state that is just the clocks and counters
+    float* bias = scratch;
+    float* white = scratch + 4 * count;
+    PhiloxNormals(scenario.sensorSeed, SENSOR_BIAS_CHANNEL + channel, 0, count, vehicles, bias);
+    PhiloxNormals(scenario.sensorSeed, channel, sample, count, vehicles, white);
+
+    for (size_t axis = 0; axis < layout.axes; axis++) {
+        const float* in = truth + (layout.first + axis) * count;
+        float* out = reading + (layout.first + axis) * count;
+        const float* axisBias = bias + axis * count;
+        const float* axisWhite = white + axis * count;
+        for (size_t i = 0; i < count; i++) {
+            out[i] = in[i] + biasScale * axisBias[i] + noiseScale * axisWhite[i];
+        }
+    }
+}
+
+bool AdvanceSensorClock(float& clock, uint32_t samples, float rate, float deltaTime) {
+    float period = 1.0f / rate;
+    clock += deltaTime;
+    if (samples > 0 && clock < period) return false;
+    clock = samples > 0 ? std::fmod(clock - period, period) : 0.0f;
+    return true;
+}
+
+void UpdateSensors(SensorState& sensors, const Scenario& scenario, uint32_t vehicle,
+    const SensorValues& truth, float deltaTime) {
+    const float* truthValues = reinterpret_cast<const float*>(&truth);
+    float* readingValues = reinterpret_cast<float*>(&sensors.reading);
+    sensors.fresh = 0;
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        const SensorLayout& layout = SENSOR_LAYOUTS[i];
+        const SensorNoise& model = scenario.sensors[i];
+        if (!(model.rate > 0.0f)) {
+            for (size_t axis = 0; axis < layout.axes; axis++) {
+                readingValues[layout.first + axis] = truthValues[layout.first + axis];
+            }
+            sensors.fresh |= 1u << i;
+            continue;
+        }
+
+        if (!AdvanceSensorClock(sensors.clock[i], sensors.samples[i], model.rate, deltaTime)) continue;
+        float scratch[8];
+        MeasureSensor(scenario, static_cast<SensorChannel>(i), sensors.samples[i]++, 1, &vehicle,
+            truthValues, readingValues, scratch);
+        sensors.fresh |= 1u << i;
+    }
+}
+
+SensorBank::SensorBank(size_t count, uint32_t firstVehicle)
+    : vehicles(count), truth(SENSOR_VALUES * count), reading(SENSOR_VALUES * count), scratch(8 * count) {
+    for (size_t i = 0; i < count; i++) vehicles[i] = firstVehicle + static_cast<uint32_t>(i);
+}
+
+void SensorBank::sample(const Scenario& scenario, SensorChannel channel, uint32_t sample) {
+    MeasureSensor(scenario, channel, sample, size(), vehicles.data(), truth.data(), reading.data(), scratch.data());
+}
+
+int RunSensorBenchmark(int vehicles, int samples) {
+    if (vehicles <= 0 || samples <= 0) {
+        std::cerr << "Sensor benchmark needs vehicles and samples" << std::endl;
+        return -1;
+    }
+    const Scenario& scenario = DefaultScenario();
+
+    SensorBank bank(static_cast<size_t>(vehicles));
+    for (size_t value = 0; value < SENSOR_VALUES; value++) {
+        float* truth = bank.truthOf(value);
+        for (size_t i = 0; i < bank.size(); i++) truth[i] = 100.0f * std::sin(2.399963f * i + value);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int sample = 0; sample < samples; sample++) {
+        for (int channel = 0; channel < SENSOR_COUNT; channel++) {
+            bank.sample(scenario, static_cast<SensorChannel>(channel), static_cast<uint32_t>(sample));
+        }
+    }
+    double batched = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // The same samples one vehicle at a time, the way FlightState takes them
+    std::vector<SensorValues> truths(bank.size()), readings(bank.size());
+    for (size_t i = 0; i < bank.size(); i++) {
+        float* values = reinterpret_cast<float*>(&truths[i]);
+        for (size_t value = 0; value < SENSOR_VALUES; value++) values[value] = bank.truthOf(value)[i];
+    }
+    float scratch[8];
+    start = std::chrono::steady_clock::now();
+    for (int sample = 0; sample < samples; sample++) {
+        for (size_t i = 0; i < bank.size(); i++) {
+            for (int channel = 0; channel < SENSOR_COUNT; channel++) {
+                MeasureSensor(scenario, static_cast<SensorChannel>(channel), static_cast<uint32_t>(sample), 1,
+                    &bank.vehicles[i], reinterpret_cast<const float*>(&truths[i]),
+                    reinterpret_cast<float*>(&readings[i]), scratch);
+            }
+        }
+    }
+    double single = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // A vehicle's noise must not depend on the batch it was drawn in
+    size_t mismatches = 0;
+    for (size_t i = 0; i < bank.size(); i++) {
+        const float* values = reinterpret_cast<const float*>(&readings[i]);
+        for (size_t value = 0; value < SENSOR_VALUES; value++) {
+            if (values[value] != bank.readingOf(value)[i]) mismatches++;
+        }
+    }
+
+    // Spread of the altimeter error across vehicles: bias and noise together
+    const size_t altitude = offsetof(SensorValues, altitude) / sizeof(float);
+    double sum = 0.0, squares = 0.0;
+    for (size_t i = 0; i < bank.size(); i++) {
+        double error = bank.readingOf(altitude)[i] - bank.truthOf(altitude)[i];
+        sum += error;
+        squares += error * error;
+    }
+    double mean = sum / bank.size();
+    const SensorNoise& altimeter = scenario.sensors[SENSOR_ALTIMETER];
+
+    double vehicleSamples = double(samples) * vehicles;
+    std::cout << "Sensors: " << vehicles << " vehicles, " << samples << " samples of all " << SENSOR_COUNT << " sensors" << std::endl;
+    std::cout << "Batched: " << batched / vehicleSamples << " ns per vehicle-sample" << std::endl;
+    std::cout << "One at a time: " << single / vehicleSamples << " ns per vehicle-sample" << std::endl;
+    std::cout << "Altimeter error: mean " << mean << " m, sigma " << std::sqrt(squares / bank.size() - mean * mean)
+        << " m (model " << std::sqrt(altimeter.noise * altimeter.noise + altimeter.bias * altimeter.bias) << " m)" << std::endl;
+    std::cout << "Mismatched readings: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : -1;
+}
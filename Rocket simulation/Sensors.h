@@ -0,0 +1,90 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Scenario.h"
+
+// What flight software sees instead of the true state: each sensor samples
+// at its own rate, adds a per-vehicle constant bias and white noise, and
+// holds its reading until the next sample. Noise comes from Random.h keyed
+// by the scenario seed, with the vehicle as the stream and the sample count
+// as the counter, so a vehicle's readings do not depend on how many others
+// run beside it, in what order, or on which thread.
+enum SensorChannel {
+    SENSOR_ATTITUDE,
+    SENSOR_GYRO,
+    SENSOR_ACCELEROMETER,
+    SENSOR_GPS_POSITION,
+    SENSOR_GPS_VELOCITY,
+    SENSOR_ALTIMETER,
+    SENSOR_COUNT
+};
+
+// One value per measured axis, in SensorChannel order, SI angles
+struct SensorValues {
+    float attitude[2];      // rad, pitch and yaw
+    float rate[2];          // rad/s, pitch and yaw
+    float acceleration[1];  // Dashboard units, thrust over mass
+    float position[3];      // m, Rocket frame
+    float velocity[3];      // m/s
+    float altitude[1];      // m
+};
+
+const size_t SENSOR_VALUES = sizeof(SensorValues) / sizeof(float);
+
+const char* SensorName(SensorChannel channel);
+
+// Variance of one axis of a reading's error, noise and bias together, in
+// SensorValues units; what a filter should expect from the sensor
+float SensorVariance(const Scenario& scenario, SensorChannel channel);
+
+// Readings of one vehicle and when each sensor last sampled
+struct SensorState {
+    SensorValues reading = {};
+    float clock[SENSOR_COUNT] = {};     // s since the last sample
+    uint32_t samples[SENSOR_COUNT] = {}; // Samples taken; a sensor that has none samples at once
+    uint32_t fresh = 0;                 // Bit per SensorChannel read anew by the last update
+};
+
+// Advances one sensor's clock by deltaTime; true when it samples now
+bool AdvanceSensorClock(float& clock, uint32_t samples, float rate, float deltaTime);
+
+// Samples every sensor whose period has run out and leaves the others
+// holding. A step longer than a period takes one sample, not several.
+void UpdateSensors(SensorState& sensors, const Scenario& scenario, uint32_t vehicle,
+    const SensorValues& truth, float deltaTime);
+
+// One sample of one sensor for count vehicles. truth and reading hold one
+// array of count per value (SensorValues order, so a single vehicle passes
+// its structs as they are); only this sensor's values are touched. scratch
+// holds 8 * count floats.
+void MeasureSensor(const Scenario& scenario, SensorChannel channel, uint32_t sample, size_t count,
+    const uint32_t* vehicles, const float* truth, float* reading, float* scratch);
+
+// Sensors for a batch of vehicles sampled together, e.g. a fleet stepped in
+// lockstep. Sized once; sample() never allocates.
+class SensorBank {
+public:
+    explicit SensorBank(size_t count, uint32_t firstVehicle = 0);
+
+    size_t size() const { return vehicles.size(); }
+
+    // Value v of vehicle i sits at [v * size() + i]
+    float* truthOf(size_t value) { return &truth[value * size()]; }
+    const float* readingOf(size_t value) const { return &reading[value * size()]; }
+
+    std::vector<uint32_t> vehicles;     // Noise stream of each vehicle
+    std::vector<float> truth, reading;
+
+    void sample(const Scenario& scenario, SensorChannel channel, uint32_t sample);
+
+private:
+    std::vector<float> scratch;
+};
+
+// Times SensorBank::sample per vehicle and checks it against one vehicle at a time
+int RunSensorBenchmark(int vehicles, int samples);
+
+#endif
@@ -0,0 +1,196 @@
+#include "SharedState.h"
+#include "Flight.h"
+#include <iostream>
+#include <new>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+std::string sharedStateName = SHARED_STATE_NAME;
+}
+
+const char* SharedStateName() {
+    return sharedStateName.c_str();
+}
+
+void SetSharedStateName(const char* name) {
+    sharedStateName = name;
+}
+
+#ifdef _WIN32
+// Named file mappings live in the session namespace; drop the POSIX slash
+static std::string MappingName(const char* name) {
+    return std::string("Local\\") + (name[0] == '/' ? name + 1 : name);
+}
+
+SharedStateBlock* OpenSharedState(const char* name) {
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, MappingName(name).c_str());
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(SharedStateBlock));
+    CloseHandle(mapping); // The view keeps the mapping alive
+    return static_cast<SharedStateBlock*>(view);
+}
+
+void CloseSharedState(SharedStateBlock* block) {
+    if (block != nullptr) UnmapViewOfFile(block);
+}
+
+// A mapping that already exists has a writer, or readers still holding the
+// last one; either way it is not ours. It goes away with its last handle.
+static SharedStateBlock* ClaimSharedState(const char* name, intptr_t& handle, bool& taken) {
+    taken = false;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(SharedStateBlock),
+        MappingName(name).c_str());
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        taken = true;
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedStateBlock));
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    handle = reinterpret_cast<intptr_t>(mapping);
+    return static_cast<SharedStateBlock*>(view);
+}
+
+static void ReleaseSharedState(const char*, SharedStateBlock* block, intptr_t handle) {
+    UnmapViewOfFile(block);
+    CloseHandle(reinterpret_cast<HANDLE>(handle));
+}
+#else
+SharedStateBlock* OpenSharedState(const char* name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    void* view = mmap(nullptr, sizeof(SharedStateBlock), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the object alive
+    return view == MAP_FAILED ? nullptr : static_cast<SharedStateBlock*>(view);
+}
+
+void CloseSharedState(SharedStateBlock* block) {
+    if (block != nullptr) munmap(block, sizeof(SharedStateBlock));
+}
+
+// The claim is an exclusive flock on the object, held through the open fd
+// for the writer's lifetime. The kernel drops it when the writer exits, so a
+// block left behind by a crash is taken over rather than blocking the name.
+static SharedStateBlock* ClaimSharedState(const char* name, intptr_t& handle, bool& taken) {
+    taken = false;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int fd = shm_open(name, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return nullptr;
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            taken = errno == EWOULDBLOCK;
+            ::close(fd);
+            return nullptr;
+        }
+        struct stat status;
+        if (fstat(fd, &status) == 0 && status.st_nlink == 0) {
+            ::close(fd); // Unlinked by the writer that just left; make a fresh one
+            continue;
+        }
+        void* view = MAP_FAILED;
+        if (ftruncate(fd, sizeof(SharedStateBlock)) == 0) {
+            view = mmap(nullptr, sizeof(SharedStateBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        handle = fd;
+        return static_cast<SharedStateBlock*>(view);
+    }
+    return nullptr;
+}
+
+// Unlinked before the lock goes, so nobody claims a name about to vanish
+static void ReleaseSharedState(const char* name, SharedStateBlock* block, intptr_t handle) {
+    shm_unlink(name);
+    munmap(block, sizeof(SharedStateBlock));
+    ::close(static_cast<int>(handle));
+}
+#endif
+
+SharedStatePublisher::~SharedStatePublisher() {
+    close();
+}
+
+bool SharedStatePublisher::open(const char* blockName) {
+    close();
+    bool taken = false;
+    block = ClaimSharedState(blockName, writerHandle, taken);
+    if (block == nullptr) {
+        if (taken) {
+            std::cerr << "Shared state " << blockName << " is published by another console, not publishing;"
+                " give this one its own with --shm-name" << std::endl;
+        }
+        else {
+            std::cerr << "Shared state " << blockName << " unavailable, not publishing" << std::endl;
+        }
+        return false;
+    }
+    name = blockName;
+    // Fresh or left over from a writer that died: start readers from a clean, even sequence
+    new (&block->sequence) std::atomic<uint32_t>(0);
+    std::memset(&block->sample, 0, sizeof(block->sample));
+    block->size = sizeof(SharedStateBlock);
+    block->version = SHARED_STATE_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    block->magic = SHARED_STATE_MAGIC;
+    step = 0;
+    return true;
+}
+
+void SharedStatePublisher::close() {
+    if (block != nullptr) ReleaseSharedState(name.c_str(), block, writerHandle);
+    block = nullptr;
+    writerHandle = -1;
+}
+
+// A handful of stores between two sequence bumps: well under a microsecond
+void SharedStatePublisher::publish(const FlightState& flight, float time) {
+    if (block == nullptr) return;
+
+    uint32_t sequence = block->sequence.load(std::memory_order_relaxed);
+    block->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SharedStateSample& sample = block->sample;
+    sample.step = ++step;
+    sample.time = time;
+    for (int i = 0; i < 3; i++) {
+        sample.position[i] = flight.rocket.position[i];
+        sample.velocity[i] = flight.rocket.velocity[i];
+    }
+    sample.fuelLevel = flight.fuelLevel;
+    sample.mass = flight.currentMass;
+    sample.acceleration = flight.acceleration;
+    for (int i = 0; i < 5; i++) sample.thrustLevels[i] = flight.thrustLevels[i];
+    sample.progress = flight.currentProgress;
+    sample.flags = (flight.isLiftoffInitiated ? SHARED_LIFTOFF_INITIATED : 0u)
+        | (flight.isLiftoffComplete ? SHARED_LIFTOFF_COMPLETE : 0u);
+
+    block->sequence.store(sequence + 2, std::memory_order_release);
+}
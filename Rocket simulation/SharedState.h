@@ -0,0 +1,98 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+struct FlightState;
+
+// Live flight state for other processes on this machine (trackers, loggers,
+// HIL rigs). The simulation is the only writer of a named shared-memory block
+// guarded by a seqlock: readers copy the sample and retry if the sequence
+// moved, so neither side makes a syscall or takes a lock per step. This
+// header is all a consumer needs besides OpenSharedState().
+//
+// One writer per name: a second console on the same machine does not
+// publish unless it is given a name of its own (--shm-name).
+
+const char* const SHARED_STATE_NAME = "/rocket_simulation_state"; // "Local\rocket_simulation_state" on Windows
+const uint32_t SHARED_STATE_MAGIC = 0x524B5354; // "RKST"
+const uint32_t SHARED_STATE_VERSION = 1;
+
+// SharedStateSample::flags
+const uint32_t SHARED_LIFTOFF_INITIATED = 1u << 0;
+const uint32_t SHARED_LIFTOFF_COMPLETE = 1u << 1;
+
+struct SharedStateSample {
+    uint64_t step;          // Publish count, increases by one per step
+    double time;            // Simulation time (s)
+    float position[3];      // m
+    float velocity[3];      // m/s
+    float fuelLevel;        // %
+    float mass;             // kg
+    float acceleration;     // m/s^2
+    float thrustLevels[5];  // %
+    int32_t progress;       // ProgressState
+    uint32_t flags;         // SHARED_LIFTOFF_* bits
+};
+
+struct SharedStateBlock {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                      // sizeof(SharedStateBlock), catches layout mismatches
+    alignas(64) std::atomic<uint32_t> sequence; // Odd while a write is in progress
+    SharedStateSample sample;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the seqlock must work across processes");
+
+inline bool IsSharedStateValid(const SharedStateBlock& block) {
+    return block.magic == SHARED_STATE_MAGIC && block.version == SHARED_STATE_VERSION
+        && block.size == sizeof(SharedStateBlock);
+}
+
+// Copies the latest consistent sample. Returns false only if the writer kept
+// the block busy for every attempt.
+inline bool ReadSharedState(const SharedStateBlock& block, SharedStateSample& out, int attempts = 1000) {
+    for (int i = 0; i < attempts; i++) {
+        uint32_t before = block.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        std::memcpy(&out, &block.sample, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block.sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+// Maps a published block read-only. Returns nullptr if there is none.
+SharedStateBlock* OpenSharedState(const char* name);
+void CloseSharedState(SharedStateBlock* block);
+
+// Name the publisher and --watch-state use: SHARED_STATE_NAME unless
+// --shm-name set another
+const char* SharedStateName();
+void SetSharedStateName(const char* name);
+
+// Single writer side, owned by the simulation loop. open() claims the name
+// for this process alone and close() removes it; a writer that crashed
+// leaves the claim free for the next one to take over.
+class SharedStatePublisher {
+public:
+    ~SharedStatePublisher();
+
+    bool open(const char* name = SharedStateName());
+    void close();
+    bool isOpen() const { return block != nullptr; }
+
+    void publish(const FlightState& flight, float time);
+
+private:
+    SharedStateBlock* block = nullptr;
+    intptr_t writerHandle = -1; // Holds the claim: a locked fd, or the mapping handle on Windows
+    std::string name;           // Claimed, removed again by close()
+    uint64_t step = 0;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "Sockets.h"
+#include <cstring>
+
+#ifdef _WIN32
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+bool InitSockets() {
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+
+void CloseSocket(SocketHandle socket) {
+    if (socket != INVALID_SOCKET_HANDLE) closesocket(socket);
+}
+
+bool SetNonBlocking(SocketHandle socket) {
+    u_long enabled = 1;
+    return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+}
+
+bool LastErrorWouldBlock() {
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+int PollSockets(pollfd* fds, size_t count, int timeoutMs) {
+    return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+}
+
+long SendBytes(SocketHandle socket, const void* data, size_t size) {
+    return send(socket, static_cast<const char*>(data), static_cast<int>(size), 0);
+}
+
+long ReceiveBytes(SocketHandle socket, void* data, size_t size) {
+    return recv(socket, static_cast<char*>(data), static_cast<int>(size), 0);
+}
+#else
+bool InitSockets() {
+    return true;
+}
+
+void CloseSocket(SocketHandle socket) {
+    if (socket != INVALID_SOCKET_HANDLE) ::close(socket);
+}
+
+bool SetNonBlocking(SocketHandle socket) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool LastErrorWouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+}
+
+int PollSockets(pollfd* fds, size_t count, int timeoutMs) {
+    return poll(fds, static_cast<nfds_t>(count), timeoutMs);
+}
+
+long SendBytes(SocketHandle socket, const void* data, size_t size) {
+    return static_cast<long>(send(socket, data, size, MSG_NOSIGNAL));
+}
+
+long ReceiveBytes(SocketHandle socket, void* data, size_t size) {
+    return static_cast<long>(recv(socket, data, size, 0));
+}
+#endif
+
+static sockaddr_in LoopbackAddress(uint16_t port) {
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+SocketHandle OpenLoopbackServer(SocketKind kind, uint16_t port) {
+    if (!InitSockets()) return INVALID_SOCKET_HANDLE;
+    SocketHandle socket = ::socket(AF_INET, kind == SOCKET_TCP ? SOCK_STREAM : SOCK_DGRAM, 0);
+    if (socket == INVALID_SOCKET_HANDLE) return INVALID_SOCKET_HANDLE;
+
+    int reuse = 1; // Restarting the app must not wait out TIME_WAIT
+    setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    sockaddr_in address = LoopbackAddress(port);
+    if (bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || (kind == SOCKET_TCP && listen(socket, 8) != 0)
+        || !SetNonBlocking(socket)) {
+        CloseSocket(socket);
+        return INVALID_SOCKET_HANDLE;
+    }
+    return socket;
+}
+
+SocketHandle ConnectLoopback(SocketKind kind, uint16_t port) {
+    if (!InitSockets()) return INVALID_SOCKET_HANDLE;
+    SocketHandle socket = ::socket(AF_INET, kind == SOCKET_TCP ? SOCK_STREAM : SOCK_DGRAM, 0);
+    if (socket == INVALID_SOCKET_HANDLE) return INVALID_SOCKET_HANDLE;
+
+    sockaddr_in address = LoopbackAddress(port);
+    if (connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || !SetNonBlocking(socket)) {
+        CloseSocket(socket);
+        return INVALID_SOCKET_HANDLE;
+    }
+    if (kind == SOCKET_TCP) {
+        int noDelay = 1; // Frames are already batched, do not hold them back again
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    }
+    return socket;
+}
@@ -0,0 +1,51 @@
+#ifndef SOCKETS_H
+#define SOCKETS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Thin layer over BSD sockets and Winsock so the servers read the same on
+// both platforms. Everything here is non-blocking and bound to loopback.
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+typedef int SocketLength;
+const SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+#else
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+typedef int SocketHandle;
+typedef socklen_t SocketLength;
+const SocketHandle INVALID_SOCKET_HANDLE = -1;
+#endif
+
+enum SocketKind {
+    SOCKET_TCP,
+    SOCKET_UDP
+};
+
+bool InitSockets(); // WSAStartup on Windows, safe to call repeatedly
+void CloseSocket(SocketHandle socket);
+bool SetNonBlocking(SocketHandle socket);
+bool LastErrorWouldBlock();
+int PollSockets(pollfd* fds, size_t count, int timeoutMs);
+
+// 127.0.0.1:port, listening when TCP. Returns INVALID_SOCKET_HANDLE on failure.
+SocketHandle OpenLoopbackServer(SocketKind kind, uint16_t port);
+// Blocking connect to 127.0.0.1:port, then switched to non-blocking
+SocketHandle ConnectLoopback(SocketKind kind, uint16_t port);
+
+// send()/recv() that never raise SIGPIPE; both return -1 with
+// LastErrorWouldBlock() when the socket is not ready
+long SendBytes(SocketHandle socket, const void* data, size_t size);
+long ReceiveBytes(SocketHandle socket, void* data, size_t size);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded single-producer single-consumer queue of trivially copyable items.
+// Both ends are wait-free: a full queue refuses the push, an empty one the
+// pop, and neither side ever takes a lock or allocates.
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer thread only
+    bool tryPush(const T& item) {
+        uint64_t position = head.load(std::memory_order_relaxed);
+        if (position - tail.load(std::memory_order_acquire) >= CAPACITY) return false;
+        items[position & (CAPACITY - 1)] = item;
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool tryPop(T& item) {
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        if (position == head.load(std::memory_order_acquire)) return false;
+        item = items[position & (CAPACITY - 1)];
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[CAPACITY];
+    alignas(64) std::atomic<uint64_t> head{ 0 };
+    alignas(64) std::atomic<uint64_t> tail{ 0 };
+};
+
+#endif
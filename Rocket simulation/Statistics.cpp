@@ -0,0 +1,156 @@
+#include "Statistics.h"
+#include <algorithm>
+#include <cmath>
+
+const double PI = 3.14159265358979323846;
+
+void RunningMoments::add(double value) {
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    squares += delta * (value - mean);
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+}
+
+void RunningMoments::merge(const RunningMoments& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    double total = double(count) + double(other.count);
+    double delta = other.mean - mean;
+    mean += delta * other.count / total;
+    squares += other.squares + delta * delta * (double(count) * other.count / total);
+    count += other.count;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+double RunningMoments::deviation() const {
+    return std::sqrt(variance());
+}
+
+void LinearHistogram::setRange(double rangeLow, double rangeHigh) {
+    low = rangeLow;
+    high = rangeHigh > rangeLow ? rangeHigh : rangeLow + 1.0;
+    std::fill(bins, bins + HISTOGRAM_BINS, 0L);
+    below = above = 0;
+}
+
+static void AddToHistogram(LinearHistogram& histogram, double value, long count) {
+    if (!(value >= histogram.low)) {
+        histogram.below += count; // NaN too
+        return;
+    }
+    if (value >= histogram.high) {
+        histogram.above += count;
+        return;
+    }
+    int bin = static_cast<int>((value - histogram.low) / (histogram.high - histogram.low) * HISTOGRAM_BINS);
+    histogram.bins[std::min(bin, HISTOGRAM_BINS - 1)] += count;
+}
+
+void LinearHistogram::add(double value) {
+    AddToHistogram(*this, value, 1);
+}
+
+void LinearHistogram::merge(const LinearHistogram& other) {
+    if (other.low == low && other.high == high) {
+        for (int i = 0; i < HISTOGRAM_BINS; i++) bins[i] += other.bins[i];
+        below += other.below;
+        above += other.above;
+        return;
+    }
+    // Another range: rebin by bin centre
+    double width = (other.high - other.low) / HISTOGRAM_BINS;
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        if (other.bins[i] != 0) AddToHistogram(*this, other.low + (i + 0.5) * width, other.bins[i]);
+    }
+    if (other.below != 0) AddToHistogram(*this, other.low - width, other.below);
+    if (other.above != 0) AddToHistogram(*this, other.high + width, other.above);
+}
+
+// Arcsine scale: one unit of k holds few values near q = 0 and q = 1 and
+// many near the median. Returns the q one unit above the given one.
+static double NextQuantileLimit(double q) {
+    double k = DIGEST_COMPRESSION / (2.0 * PI) * std::asin(2.0 * q - 1.0) + 1.0;
+    if (k >= DIGEST_COMPRESSION / 4.0) return 1.0;
+    return 0.5 * (std::sin(k * 2.0 * PI / DIGEST_COMPRESSION) + 1.0);
+}
+
+void TDigest::add(double value, double count) {
+    if (buffered == DIGEST_BUFFER) compress();
+    buffer[buffered++] = { value, count };
+    weight += count;
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+}
+
+void TDigest::merge(const TDigest& other) {
+    for (int i = 0; i < other.centroidCount; i++) add(other.centroids[i].mean, other.centroids[i].weight);
+    for (int i = 0; i < other.buffered; i++) add(other.buffer[i].mean, other.buffer[i].weight);
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+void TDigest::compress() {
+    if (buffered == 0) return;
+    Centroid all[DIGEST_CENTROIDS + DIGEST_BUFFER];
+    int count = buffered;
+    std::copy(buffer, buffer + buffered, all);
+    std::copy(centroids, centroids + centroidCount, all + count);
+    count += centroidCount;
+    std::sort(all, all + count, [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    // Greedy pass: grow each centroid while it spans at most one unit of k.
+    // Two neighbours then always span more than one, which bounds the count.
+    double before = 0.0;
+    double limit = weight * NextQuantileLimit(0.0);
+    Centroid current = all[0];
+    centroidCount = 0;
+    for (int i = 1; i < count; i++) {
+        if (before + current.weight + all[i].weight <= limit) {
+            current.weight += all[i].weight;
+            current.mean += (all[i].mean - current.mean) * all[i].weight / current.weight;
+        }
+        else {
+            before += current.weight;
+            centroids[centroidCount++] = current;
+            limit = weight * NextQuantileLimit(before / weight);
+            current = all[i];
+        }
+    }
+    centroids[centroidCount++] = current;
+    buffered = 0;
+}
+
+double TDigest::quantile(double q) const {
+    if (!(weight > 0.0)) return std::numeric_limits<double>::quiet_NaN();
+    if (buffered > 0) {
+        TDigest compressed = *this;
+        compressed.compress();
+        return compressed.quantile(q);
+    }
+
+    // Each centroid's mean sits at the middle of its weight; interpolate
+    // between middles, and out to the extremes past the first and last
+    double target = std::min(std::max(q, 0.0), 1.0) * weight;
+    const Centroid& first = centroids[0];
+    if (target < 0.5 * first.weight) {
+        return minimum + (first.mean - minimum) * target / (0.5 * first.weight);
+    }
+    double before = 0.0;
+    for (int i = 0; i + 1 < centroidCount; i++) {
+        double middle = before + 0.5 * centroids[i].weight;
+        double nextMiddle = before + centroids[i].weight + 0.5 * centroids[i + 1].weight;
+        if (target < nextMiddle) {
+            return centroids[i].mean + (centroids[i + 1].mean - centroids[i].mean) * (target - middle) / (nextMiddle - middle);
+        }
+        before += centroids[i].weight;
+    }
+    const Centroid& last = centroids[centroidCount - 1];
+    double middle = weight - 0.5 * last.weight;
+    return last.mean + (maximum - last.mean) * std::min(1.0, (target - middle) / (0.5 * last.weight));
+}
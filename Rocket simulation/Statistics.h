@@ -0,0 +1,90 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <limits>
+
+// Streaming statistics: each accumulator takes values one at a time in
+// constant memory and merges with another of its kind, so every worker
+// thread keeps its own and they are combined afterwards. All of them are
+// fixed-size and trivially copyable, so a snapshot is a plain memcpy.
+
+// Welford mean and variance, plus the extremes
+struct RunningMoments {
+    long count = 0;
+    double mean = 0.0;
+    double squares = 0.0;   // Sum of squared deviations from the mean
+    double minimum = std::numeric_limits<double>::infinity();
+    double maximum = -std::numeric_limits<double>::infinity();
+
+    void add(double value);
+    void merge(const RunningMoments& other);  // Chan et al.'s pairwise update
+    double variance() const { return count > 1 ? squares / (count - 1) : 0.0; }
+    double deviation() const;
+};
+
+// Equal-width bins over a fixed range, with counts below and above it.
+// Merging one of another range rebins its counts by bin centre.
+const int HISTOGRAM_BINS = 40;
+
+struct LinearHistogram {
+    double low = 0.0, high = 1.0;
+    long bins[HISTOGRAM_BINS] = {};
+    long below = 0, above = 0;
+
+    void setRange(double rangeLow, double rangeHigh);
+    void add(double value);
+    void merge(const LinearHistogram& other);
+};
+
+// Merging t-digest (Dunning): a sorted set of weighted centroids, kept small
+// by the arcsine scale function so the tails stay sharp and the middle is
+// coarse. Values collect in a buffer and are merged in whenever it fills.
+constexpr double DIGEST_COMPRESSION = 100.0;
+const int DIGEST_CENTROIDS = 128;   // A merge leaves at most compression + 1
+const int DIGEST_BUFFER = 128;
+
+static_assert(DIGEST_CENTROIDS > DIGEST_COMPRESSION + 1, "a compressed digest must fit");
+
+struct Centroid {
+    double mean;
+    double weight;
+};
+
+struct TDigest {
+    Centroid centroids[DIGEST_CENTROIDS];
+    Centroid buffer[DIGEST_BUFFER];
+    int centroidCount = 0;
+    int buffered = 0;
+    double weight = 0.0;    // Centroids and buffer together
+    double minimum = std::numeric_limits<double>::infinity();
+    double maximum = -std::numeric_limits<double>::infinity();
+
+    void add(double value, double count = 1.0);
+    void merge(const TDigest& other);
+    void compress();        // Folds the buffer into the centroids
+
+    // Estimate of the value below which fraction q of the weight lies; NaN
+    // while empty. Compresses a copy when values are still buffered.
+    double quantile(double q) const;
+};
+
+// Everything kept about one output
+struct Distribution {
+    RunningMoments moments;
+    TDigest digest;
+    LinearHistogram histogram;
+
+    void add(double value) {
+        moments.add(value);
+        digest.add(value);
+        histogram.add(value);
+    }
+
+    void merge(const Distribution& other) {
+        moments.merge(other.moments);
+        digest.merge(other.digest);
+        histogram.merge(other.histogram);
+    }
+};
+
+#endif
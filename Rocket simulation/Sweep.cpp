@@ -0,0 +1,175 @@
+#include "Sweep.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+const long SWEEP_BATCH = 4; // Points a worker claims at a time
+const uint64_t SWEEP_CHECK_BASIS = 0x9E3779B97F4A7C15ull; // The check hash's FNV offset basis
+
+static uint64_t HashRunInputs(const Scenario& scenario, float timeStep, float duration, uint64_t hash) {
+    // The numbers run from dryMass to successTilt, all 4 bytes wide with no
+    // padding between; the name and the tail padding are left out
+    const size_t first = offsetof(Scenario, dryMass);
+    const size_t end = offsetof(Scenario, successTilt) + sizeof(scenario.successTilt);
+    hash = Fnv1a64(reinterpret_cast<const char*>(&scenario) + first, end - first, hash);
+    hash = Fnv1a64(&timeStep, sizeof(timeStep), hash);
+    hash = Fnv1a64(&duration, sizeof(duration), hash);
+    hash = Fnv1a64(SWEEP_INTEGRATOR, std::strlen(SWEEP_INTEGRATOR), hash);
+    return Fnv1a64(&SWEEP_CODE_VERSION, sizeof(SWEEP_CODE_VERSION), hash);
+}
+
+CacheKey SweepKey(const Scenario& scenario, float timeStep, float duration) {
+    CacheKey key;
+    key.hash = HashRunInputs(scenario, timeStep, duration, FNV64_OFFSET);
+    key.check = HashRunInputs(scenario, timeStep, duration, SWEEP_CHECK_BASIS);
+    return key;
+}
+
+static float AxisValue(const SweepAxis& axis, int index) {
+    if (axis.count < 2) return axis.first;
+    return axis.first + (axis.last - axis.first) * index / (axis.count - 1);
+}
+
+bool RunSweep(const Scenario& scenario, const SweepAxis* axes, int axisCount, const SweepOptions& options,
+    ResultCache* cache, SweepResult& result) {
+    auto start = std::chrono::steady_clock::now();
+    result = SweepResult();
+    if (axisCount < 1 || axisCount > SWEEP_MAX_AXES) {
+        std::cerr << "A sweep needs 1 to " << SWEEP_MAX_AXES << " axes" << std::endl;
+        return false;
+    }
+    long total = 1;
+    for (int a = 0; a < axisCount; a++) {
+        if (axes[a].count < 1 || axes[a].count > SWEEP_MAX_POINTS / total) { // Dividing: the product overflows 32-bit long
+            std::cerr << "A sweep needs 1 to " << SWEEP_MAX_POINTS << " points" << std::endl;
+            return false;
+        }
+        total *= axes[a].count;
+    }
+
+    // Every point's scenario, all checked before anything flies
+    std::vector<Scenario> scenarios(static_cast<size_t>(total), scenario);
+    result.points.resize(static_cast<size_t>(total));
+    for (long p = 0; p < total; p++) {
+        SweepPoint& point = result.points[p];
+        std::fill(point.values, point.values + SWEEP_MAX_AXES, 0.0f);
+        long rest = p;
+        for (int a = axisCount - 1; a >= 0; a--) {
+            point.values[a] = AxisValue(axes[a], static_cast<int>(rest % axes[a].count));
+            rest /= axes[a].count;
+            if (!SetScenarioValue(scenarios[p], axes[a].key, point.values[a])) {
+                std::cerr << "Unknown scenario key " << axes[a].key << std::endl;
+                return false;
+            }
+        }
+        if (const char* problem = ValidateScenario(scenarios[p])) {
+            std::cerr << "Sweep point " << p << ": " << problem << std::endl;
+            return false;
+        }
+    }
+
+    // Look every point up first; only the misses fly
+    std::vector<CacheKey> keys(static_cast<size_t>(total));
+    std::vector<long> misses;
+    bool caching = cache != nullptr && cache->isOpen();
+    for (long p = 0; p < total; p++) {
+        keys[p] = SweepKey(scenarios[p], options.timeStep, options.duration);
+        CachedRun cached;
+        SweepPoint& point = result.points[p];
+        point.cached = caching && cache->find(keys[p], cached);
+        if (point.cached) {
+            point.outcome = cached.outcome;
+            result.hits++;
+            result.savedSeconds += cached.seconds;
+        }
+        else {
+            misses.push_back(p);
+        }
+    }
+
+    long missCount = static_cast<long>(misses.size());
+    int workerCount = options.workers > 0 ? options.workers : static_cast<int>(std::thread::hardware_concurrency());
+    workerCount = static_cast<int>(std::max(1L, std::min<long>(workerCount, (missCount + SWEEP_BATCH - 1) / SWEEP_BATCH)));
+    std::vector<float> flightSeconds(static_cast<size_t>(total), 0.0f);
+    std::atomic<long> next{ 0 };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workerCount && missCount > 0; i++) {
+        workers.emplace_back([&] {
+            for (;;) {
+                long first = next.fetch_add(SWEEP_BATCH, std::memory_order_relaxed);
+                if (first >= missCount) break;
+                long last = std::min(first + SWEEP_BATCH, missCount);
+                for (long m = first; m < last; m++) {
+                    long p = misses[m];
+                    auto flightStart = std::chrono::steady_clock::now();
+                    result.points[p].outcome = FlyNominalRun(scenarios[p], options.timeStep, options.duration);
+                    flightSeconds[p] = std::chrono::duration<float>(std::chrono::steady_clock::now() - flightStart).count();
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    // One writer: the cache is filled from this thread once the flying is done
+    for (long p : misses) {
+        result.simulatedSeconds += flightSeconds[p];
+        if (caching) cache->insert(keys[p], CachedRun{ result.points[p].outcome, flightSeconds[p] });
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+int RunSweepMode(int argc, char** argv, const char* cachePath) {
+    SweepAxis axes[SWEEP_MAX_AXES];
+    std::string keys[SWEEP_MAX_AXES];
+    int axisCount = 0;
+    for (int i = 0; i < argc; i++) {
+        const char* equals = std::strchr(argv[i], '=');
+        char extra = 0;
+        SweepAxis axis = { nullptr, 0.0f, 0.0f, 0 };
+        if (axisCount == SWEEP_MAX_AXES || equals == nullptr
+            || std::sscanf(equals + 1, "%f:%f:%d%c", &axis.first, &axis.last, &axis.count, &extra) != 3) {
+            std::cerr << "Sweep axes are key=first:last:count, at most " << SWEEP_MAX_AXES << " of them" << std::endl;
+            return -1;
+        }
+        keys[axisCount].assign(argv[i], static_cast<size_t>(equals - argv[i]));
+        axes[axisCount] = axis;
+        axes[axisCount].key = keys[axisCount].c_str();
+        axisCount++;
+    }
+
+    ResultCache cache;
+    if (!cache.open(cachePath)) return -1;
+    const Scenario& scenario = ActiveScenario();
+    SweepOptions options;
+    SweepResult result;
+    if (!RunSweep(scenario, axes, axisCount, options, &cache, result)) return -1;
+
+    std::cout << "Sweep: " << scenario.name << ", " << result.points.size() << " points, timestep "
+        << options.timeStep << " s" << std::endl;
+    for (int a = 0; a < axisCount; a++) std::cout << "Axis " << a + 1 << ": " << axes[a].key << std::endl;
+    for (int a = 0; a < axisCount; a++) std::cout << std::setw(13) << "axis " << a + 1;
+    std::cout << std::setw(9) << "success" << std::setw(12) << "altitude" << std::setw(12) << "apogee"
+        << std::setw(10) << "burnout" << std::setw(10) << "accel." << std::setw(8) << "cached" << std::endl;
+    for (const SweepPoint& point : result.points) {
+        for (int a = 0; a < axisCount; a++) std::cout << std::setw(14) << point.values[a];
+        const RunOutcome& outcome = point.outcome;
+        std::cout << std::setw(9) << (outcome.success ? "yes" : "no") << std::setw(12) << outcome.altitude
+            << std::setw(12) << outcome.apogee << std::setw(10) << outcome.burnoutTime
+            << std::setw(10) << outcome.maxAcceleration << std::setw(8) << (point.cached ? "yes" : "no") << std::endl;
+    }
+
+    long points = static_cast<long>(result.points.size());
+    std::cout << "Cache hits: " << result.hits << " of " << points << " (" << 100.0 * result.hits / points
+        << "%), " << points - result.hits << " flown in " << result.simulatedSeconds << " s" << std::endl;
+    std::cout << "Saved: " << result.savedSeconds << " s of flying; sweep took " << result.seconds << " s" << std::endl;
+    std::cout << "Cache: " << cache.size() << " results in " << cachePath << std::endl;
+    return 0;
+}
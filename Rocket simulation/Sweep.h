@@ -0,0 +1,65 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "Campaign.h"
+#include "ResultCache.h"
+#include "Scenario.h"
+#include <vector>
+
+// Parameter sweep: the nominal flight (FlyNominalRun) at every point of a
+// grid over scenario numbers. Each point's result is cached under a hash of
+// everything that decides it, so a point any earlier sweep flew is looked up
+// instead of flown again.
+
+const int SWEEP_MAX_AXES = 4;
+const long SWEEP_MAX_POINTS = 1000000;
+
+// Bump whenever a change to the flight moves what a run does, so cached
+// results from older builds stop matching
+const uint32_t SWEEP_CODE_VERSION = 1;
+
+// The one integrator there is, named in the key so another would not match
+const char* const SWEEP_INTEGRATOR = "semi-implicit Euler";
+
+// count values evenly spaced from first to last, both included
+struct SweepAxis {
+    const char* key;            // Scenario JSON key, e.g. "sequence.thrust_ramp.base"
+    float first, last;
+    int count;
+};
+
+struct SweepOptions {
+    float timeStep = 0.02f;     // s
+    float duration = 60.0f;     // Simulated s per point at most, from liftoff
+    int workers = 0;            // Threads, 0 = one per core
+};
+
+struct SweepPoint {
+    float values[SWEEP_MAX_AXES]; // Along each axis
+    RunOutcome outcome;
+    bool cached;                // Found in the cache rather than flown
+};
+
+struct SweepResult {
+    std::vector<SweepPoint> points; // First axis slowest
+    long hits = 0;              // Points found in the cache
+    double simulatedSeconds = 0.0; // Spent flying the other points, summed over threads
+    double savedSeconds = 0.0;  // What the hits once took to fly
+    double seconds = 0.0;       // Wall time of the whole sweep
+};
+
+// Everything that decides a run's outcome: the scenario's numbers (not its
+// name), the timestep and duration, the integrator and SWEEP_CODE_VERSION
+CacheKey SweepKey(const Scenario& scenario, float timeStep, float duration);
+
+// Flies the grid around scenario. cache may be null, or not open, to fly
+// every point; newly flown points are added to it. False, with the reason
+// on std::cerr, for an unknown key or a point with an implausible scenario.
+bool RunSweep(const Scenario& scenario, const SweepAxis* axes, int axisCount, const SweepOptions& options,
+    ResultCache* cache, SweepResult& result);
+
+// Parses "key=first:last:count" arguments, sweeps the active scenario with
+// the cache in cachePath and prints the points and the cache's savings
+int RunSweepMode(int argc, char** argv, const char* cachePath);
+
+#endif
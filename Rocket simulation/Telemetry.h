@@ -0,0 +1,30 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <glm.hpp>
+#include <array>
+#include "Flight.h"
+
+// Fixed-size snapshot of one physics step. Records are recycled through an
+// ObjectPool<TelemetryRecord> rather than allocated one by one.
+struct TelemetryRecord {
+    float time;
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float fuelLevel;
+    float mass;
+    float acceleration;
+    std::array<float, 5> thrustLevels;
+};
+
+inline void FillTelemetryRecord(TelemetryRecord& record, const FlightState& flight, float time) {
+    record.time = time;
+    record.position = flight.rocket.position;
+    record.velocity = flight.rocket.velocity;
+    record.fuelLevel = flight.fuelLevel;
+    record.mass = flight.currentMass;
+    record.acceleration = flight.acceleration;
+    record.thrustLevels = flight.thrustLevels;
+}
+
+#endif
@@ -0,0 +1,419 @@
+#include "TelemetryServer.h"
+#include "Telemetry.h"
+#include "Flight.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#endif
+
+const size_t MAX_SUBSCRIBERS = 16;
+const uint64_t SUBSCRIBER_TIMEOUT_NS = 5000000000ull; // UDP subscribers re-register every second
+const uint64_t SUBSCRIBE_INTERVAL_NS = 1000000000ull;
+
+uint64_t TelemetryClockNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static size_t FrameSize(const uint8_t* frame) {
+    const TelemetryFrameHeader* header = reinterpret_cast<const TelemetryFrameHeader*>(frame);
+    return sizeof(TelemetryFrameHeader) + header->count * sizeof(TelemetryWireRecord);
+}
+
+TelemetryServer::~TelemetryServer() {
+    stop();
+}
+
+bool TelemetryServer::start(const TelemetryServerOptions& serverOptions) {
+    stop();
+    options = serverOptions;
+    listener = OpenLoopbackServer(SOCKET_TCP, options.port);
+    datagrams = OpenLoopbackServer(SOCKET_UDP, options.port);
+    if (listener == INVALID_SOCKET_HANDLE || datagrams == INVALID_SOCKET_HANDLE) {
+        std::cerr << "Telemetry server cannot bind 127.0.0.1:" << options.port << std::endl;
+        CloseSocket(listener);
+        CloseSocket(datagrams);
+        listener = datagrams = INVALID_SOCKET_HANDLE;
+        return false;
+    }
+
+    if (!ring) ring.reset(new TelemetryWireRecord[RING_CAPACITY]);
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    submitCount = 0;
+    droppedCount = 0;
+    framesSentCount = 0;
+    framesCoalescedCount = 0;
+    bytesSentCount = 0;
+    frame.reserve(sizeof(TelemetryFrameHeader) + TELEMETRY_MAX_RECORDS_PER_FRAME * sizeof(TelemetryWireRecord));
+
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&TelemetryServer::run, this);
+    return true;
+}
+
+void TelemetryServer::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+    for (Client& client : clients) CloseSocket(client.socket);
+    clients.clear();
+    subscribers.clear();
+    clientCount = 0;
+    CloseSocket(listener);
+    CloseSocket(datagrams);
+    listener = datagrams = INVALID_SOCKET_HANDLE;
+}
+
+bool TelemetryServer::submit(const TelemetryRecord& record) {
+    if (!running.load(std::memory_order_relaxed)) return false;
+
+    uint32_t step = ++submitCount;
+    uint64_t position = head.load(std::memory_order_relaxed);
+    if (position - tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed); // The newest record goes, the stream keeps its order
+        return false;
+    }
+
+    TelemetryWireRecord& wire = ring[position & (RING_CAPACITY - 1)];
+    wire.submitTimeNs = TelemetryClockNs();
+    wire.step = step;
+    wire.time = record.time;
+    for (int i = 0; i < 3; i++) {
+        wire.position[i] = record.position[i];
+        wire.velocity[i] = record.velocity[i];
+    }
+    wire.fuelLevel = record.fuelLevel;
+    wire.mass = record.mass;
+    wire.acceleration = record.acceleration;
+    for (int i = 0; i < 5; i++) wire.thrustLevels[i] = record.thrustLevels[i];
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+TelemetryServerStats TelemetryServer::stats() const {
+    TelemetryServerStats stats;
+    stats.dropped = droppedCount.load(std::memory_order_relaxed);
+    stats.submitted = head.load(std::memory_order_relaxed) + stats.dropped;
+    stats.framesSent = framesSentCount.load(std::memory_order_relaxed);
+    stats.framesCoalesced = framesCoalescedCount.load(std::memory_order_relaxed);
+    stats.bytesSent = bytesSentCount.load(std::memory_order_relaxed);
+    stats.clients = clientCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TelemetryServer::acceptClients() {
+    for (;;) {
+        SocketHandle socket = accept(listener, nullptr, nullptr);
+        if (socket == INVALID_SOCKET_HANDLE) return;
+        if (!SetNonBlocking(socket)) {
+            CloseSocket(socket);
+            continue;
+        }
+        Client client;
+        client.socket = socket;
+        client.pending.reserve(options.clientBufferBytes + frame.capacity());
+        clients.push_back(std::move(client));
+    }
+}
+
+void TelemetryServer::readSubscriptions() {
+    uint64_t now = TelemetryClockNs();
+    for (;;) {
+        char message[64];
+        Subscriber from;
+        from.length = sizeof(from.address);
+        long received = static_cast<long>(recvfrom(datagrams, message, sizeof(message), 0,
+            reinterpret_cast<sockaddr*>(&from.address), &from.length));
+        if (received < 0) {
+            if (LastErrorWouldBlock()) break;
+            continue; // Windows reports an earlier unreachable subscriber here
+        }
+
+        auto known = std::find_if(subscribers.begin(), subscribers.end(), [&](const Subscriber& subscriber) {
+            return subscriber.address.sin_port == from.address.sin_port
+                && subscriber.address.sin_addr.s_addr == from.address.sin_addr.s_addr;
+        });
+        if (known != subscribers.end()) {
+            known->lastSeenNs = now;
+        }
+        else if (subscribers.size() < MAX_SUBSCRIBERS) {
+            from.lastSeenNs = now;
+            subscribers.push_back(from);
+        }
+    }
+}
+
+// Packs up to TELEMETRY_MAX_RECORDS_PER_FRAME records from the ring into frame
+size_t TelemetryServer::buildFrame(uint64_t sequence) {
+    uint64_t first = tail.load(std::memory_order_relaxed);
+    uint64_t available = head.load(std::memory_order_acquire) - first;
+    size_t count = static_cast<size_t>(std::min<uint64_t>(available, TELEMETRY_MAX_RECORDS_PER_FRAME));
+
+    frame.resize(sizeof(TelemetryFrameHeader) + count * sizeof(TelemetryWireRecord));
+    TelemetryFrameHeader header;
+    header.magic = TELEMETRY_FRAME_MAGIC;
+    header.version = TELEMETRY_FRAME_VERSION;
+    header.count = static_cast<uint16_t>(count);
+    header.sequence = sequence;
+    header.sendTimeNs = TelemetryClockNs();
+    std::memcpy(frame.data(), &header, sizeof(header));
+
+    // At most two runs: up to the end of the ring, then from its start
+    uint8_t* out = frame.data() + sizeof(header);
+    size_t index = static_cast<size_t>(first & (RING_CAPACITY - 1));
+    size_t firstRun = std::min(count, RING_CAPACITY - index);
+    std::memcpy(out, &ring[index], firstRun * sizeof(TelemetryWireRecord));
+    std::memcpy(out + firstRun * sizeof(TelemetryWireRecord), &ring[0], (count - firstRun) * sizeof(TelemetryWireRecord));
+
+    tail.store(first + count, std::memory_order_release);
+    return count;
+}
+
+// Appends the current frame. A client that cannot keep up loses the frames it
+// has not started receiving; the frame on the wire is finished so the stream
+// stays parseable, and the newest frame always goes in.
+void TelemetryServer::queueFrame(Client& client) {
+    if (client.pending.size() - client.sent + frame.size() > options.clientBufferBytes) {
+        size_t boundary = 0;
+        while (boundary < client.sent) boundary += FrameSize(client.pending.data() + boundary);
+
+        uint64_t coalesced = 0;
+        for (size_t offset = boundary; offset < client.pending.size(); offset += FrameSize(client.pending.data() + offset)) {
+            coalesced++;
+        }
+        client.pending.resize(boundary);
+        framesCoalescedCount.fetch_add(coalesced, std::memory_order_relaxed);
+        framesSentCount.fetch_sub(coalesced, std::memory_order_relaxed);
+    }
+    client.pending.insert(client.pending.end(), frame.begin(), frame.end());
+    framesSentCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Writes as much as the socket takes. Returns false once the client is gone.
+bool TelemetryServer::flushClient(Client& client) {
+    while (client.sent < client.pending.size()) {
+        long written = SendBytes(client.socket, client.pending.data() + client.sent, client.pending.size() - client.sent);
+        if (written < 0) {
+            return LastErrorWouldBlock();
+        }
+        client.sent += static_cast<size_t>(written);
+        bytesSentCount.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+    }
+    client.pending.clear();
+    client.sent = 0;
+    return true;
+}
+
+void TelemetryServer::run() {
+    std::vector<pollfd> fds;
+    uint64_t sequence = 0;
+    uint64_t batchIntervalNs = static_cast<uint64_t>(std::max(options.batchIntervalMs, 1)) * 1000000ull;
+    uint64_t nextBatchNs = TelemetryClockNs() + batchIntervalNs;
+
+    while (running.load(std::memory_order_acquire)) {
+        uint64_t now = TelemetryClockNs();
+        int timeoutMs = nextBatchNs > now ? static_cast<int>((nextBatchNs - now + 999999) / 1000000) : 0;
+
+        fds.clear();
+        fds.push_back({ listener, POLLIN, 0 });
+        fds.push_back({ datagrams, POLLIN, 0 });
+        for (const Client& client : clients) {
+            short events = POLLIN;
+            if (client.sent < client.pending.size()) events |= POLLOUT;
+            fds.push_back({ client.socket, events, 0 });
+        }
+        if (PollSockets(fds.data(), fds.size(), timeoutMs) < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (fds[0].revents & POLLIN) acceptClients();
+        if (fds[1].revents & POLLIN) readSubscriptions();
+
+        // Clients only listen; anything they send is discarded, a hangup drops them
+        for (size_t i = 2; i < fds.size(); i++) {
+            Client& client = clients[i - 2];
+            if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                client.closed = true;
+                continue;
+            }
+            if (fds[i].revents & POLLIN) {
+                char discard[256];
+                long received = ReceiveBytes(client.socket, discard, sizeof(discard));
+                if (received == 0 || (received < 0 && !LastErrorWouldBlock())) {
+                    client.closed = true;
+                }
+            }
+        }
+
+        now = TelemetryClockNs();
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [&](const Subscriber& subscriber) {
+            return now - subscriber.lastSeenNs > SUBSCRIBER_TIMEOUT_NS;
+        }), subscribers.end());
+
+        // Full frames go out as soon as they fill, the remainder once per interval
+        bool batchDue = now >= nextBatchNs;
+        if (batchDue) nextBatchNs = now + batchIntervalNs;
+        for (;;) {
+            uint64_t available = head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+            if (available == 0 || (!batchDue && available < static_cast<uint64_t>(TELEMETRY_MAX_RECORDS_PER_FRAME))) break;
+            buildFrame(++sequence);
+
+            for (Client& client : clients) {
+                if (!client.closed) queueFrame(client);
+            }
+            for (const Subscriber& subscriber : subscribers) {
+                long written = static_cast<long>(sendto(datagrams, reinterpret_cast<const char*>(frame.data()),
+                    static_cast<int>(frame.size()), 0, reinterpret_cast<const sockaddr*>(&subscriber.address), subscriber.length));
+                if (written < 0) {
+                    framesCoalescedCount.fetch_add(1, std::memory_order_relaxed); // Socket buffer full, UDP just drops
+                    continue;
+                }
+                framesSentCount.fetch_add(1, std::memory_order_relaxed);
+                bytesSentCount.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+            }
+        }
+
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [&](Client& client) {
+            bool gone = client.closed || !flushClient(client);
+            if (gone) CloseSocket(client.socket);
+            return gone;
+        }), clients.end());
+        clientCount.store(static_cast<uint32_t>(clients.size() + subscribers.size()), std::memory_order_relaxed);
+    }
+}
+
+static double Percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int RunTelemetryClient(float duration, uint16_t port, bool udp) {
+    SocketHandle socket = ConnectLoopback(udp ? SOCKET_UDP : SOCKET_TCP, port);
+    if (socket == INVALID_SOCKET_HANDLE) {
+        std::cerr << "No telemetry server on 127.0.0.1:" << port << std::endl;
+        return -1;
+    }
+
+    std::vector<uint8_t> buffer(1 << 20);
+    size_t buffered = 0;
+    std::vector<double> latenciesUs;     // Submit to receive, per record
+    latenciesUs.reserve(1 << 20);
+    uint64_t frames = 0, records = 0, bytes = 0, lostRecords = 0, lostFrames = 0;
+    uint64_t lastSequence = 0;
+    uint32_t lastStep = 0;
+    bool closed = false;
+
+    uint64_t startNs = TelemetryClockNs();
+    uint64_t endNs = startNs + static_cast<uint64_t>(duration * 1e9);
+    uint64_t nextSubscribeNs = startNs;
+    while (!closed && TelemetryClockNs() < endNs) {
+        if (udp && TelemetryClockNs() >= nextSubscribeNs) {
+            SendBytes(socket, "subscribe", 9);
+            nextSubscribeNs += SUBSCRIBE_INTERVAL_NS;
+        }
+
+        pollfd fd = { socket, POLLIN, 0 };
+        if (PollSockets(&fd, 1, 100) <= 0) continue;
+
+        for (;;) {
+            if (buffered == buffer.size()) buffer.resize(buffer.size() * 2);
+            long received = ReceiveBytes(socket, buffer.data() + buffered, buffer.size() - buffered);
+            if (received <= 0) {
+                if (received == 0 || !LastErrorWouldBlock()) closed = !udp; // UDP errors until the server is up
+                break;
+            }
+            uint64_t receivedNs = TelemetryClockNs();
+            bytes += static_cast<uint64_t>(received);
+            buffered += static_cast<size_t>(received);
+
+            // TCP may split frames anywhere; UDP always delivers exactly one
+            size_t offset = 0;
+            while (buffered - offset >= sizeof(TelemetryFrameHeader)) {
+                TelemetryFrameHeader header;
+                std::memcpy(&header, buffer.data() + offset, sizeof(header));
+                if (header.magic != TELEMETRY_FRAME_MAGIC || header.version != TELEMETRY_FRAME_VERSION) {
+                    std::cerr << "Unexpected telemetry frame, closing" << std::endl;
+                    CloseSocket(socket);
+                    return -1;
+                }
+                size_t size = sizeof(header) + header.count * sizeof(TelemetryWireRecord);
+                if (buffered - offset < size) break;
+
+                if (lastSequence != 0 && header.sequence > lastSequence + 1) lostFrames += header.sequence - lastSequence - 1;
+                lastSequence = header.sequence;
+                frames++;
+                for (int i = 0; i < header.count; i++) {
+                    TelemetryWireRecord record;
+                    std::memcpy(&record, buffer.data() + offset + sizeof(header) + i * sizeof(record), sizeof(record));
+                    if (lastStep != 0 && record.step > lastStep + 1) lostRecords += record.step - lastStep - 1;
+                    lastStep = record.step;
+                    latenciesUs.push_back((receivedNs - record.submitTimeNs) / 1000.0);
+                    records++;
+                }
+                offset += size;
+            }
+            std::memmove(buffer.data(), buffer.data() + offset, buffered - offset);
+            buffered -= offset;
+        }
+    }
+    CloseSocket(socket);
+
+    double seconds = (TelemetryClockNs() - startNs) / 1e9;
+    std::cout << "Received " << records << " records in " << frames << " frames over " << (udp ? "UDP" : "TCP")
+        << " in " << seconds << " s" << std::endl;
+    std::cout << "Throughput: " << records / seconds << " records/s, " << bytes / seconds / 1024.0 << " KB/s" << std::endl;
+    std::cout << "Lost: " << lostRecords << " records, " << lostFrames << " frames" << std::endl;
+    if (!latenciesUs.empty()) {
+        double p50 = Percentile(latenciesUs, 0.5);
+        double p99 = Percentile(latenciesUs, 0.99);
+        double worst = *std::max_element(latenciesUs.begin(), latenciesUs.end());
+        std::cout << "Latency: p50 " << p50 << " us, p99 " << p99 << " us, max " << worst << " us" << std::endl;
+    }
+    return records > 0 ? 0 : -1;
+}
+
+int RunTelemetryServer(float duration, uint16_t port, float stepRate) {
+    if (!(duration > 0.0f) || !(stepRate > 0.0f)) {
+        std::cerr << "Telemetry server needs a positive duration and step rate" << std::endl;
+        return -1;
+    }
+
+    TelemetryServerOptions options;
+    options.port = port;
+    TelemetryServer server;
+    if (!server.start(options)) {
+        return -1;
+    }
+
+    FlightState flight;
+    LaunchFlight(flight, 0.0f);
+
+    // Steps are paced against the wall clock so clients see a live rate
+    float timeStep = 1.0f / stepRate;
+    long steps = static_cast<long>(duration * stepRate);
+    auto start = std::chrono::steady_clock::now();
+    TelemetryRecord record;
+    for (long step = 1; step <= steps; step++) {
+        float time = step * timeStep;
+        UpdateFlight(flight, time, timeStep);
+        LogFlightEvents(flight);
+        FillTelemetryRecord(record, flight, time);
+        server.submit(record);
+        std::this_thread::sleep_until(start + std::chrono::duration<double>(static_cast<double>(time)));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(4 * options.batchIntervalMs)); // Last partial frame
+    TelemetryServerStats stats = server.stats();
+    server.stop();
+
+    std::cout << "Served " << stats.submitted << " records at " << stepRate << " Hz, " << stats.dropped << " dropped" << std::endl;
+    std::cout << "Frames: " << stats.framesSent << " sent, " << stats.framesCoalesced << " coalesced, "
+        << stats.bytesSent / 1024.0 << " KB" << std::endl;
+    return 0;
+}
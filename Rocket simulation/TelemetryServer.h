@@ -0,0 +1,133 @@
+#ifndef TELEMETRY_SERVER_H
+#define TELEMETRY_SERVER_H
+
+#include "Sockets.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct TelemetryRecord;
+
+// Streams per-step telemetry to ground-station tools over loopback. The
+// physics thread only writes into a wait-free ring; a dedicated thread
+// batches records into frames and sends them to TCP clients and UDP
+// subscribers with non-blocking sockets. A full ring drops the newest
+// records and a slow client has its unsent frames coalesced into the latest
+// one, so a stalled consumer can never hold up a step.
+//
+// Wire format, host byte order (loopback only): a TelemetryFrameHeader
+// followed by count TelemetryWireRecords. UDP subscribers register by
+// sending any datagram to the server port and get one frame per datagram.
+
+const uint16_t TELEMETRY_DEFAULT_PORT = 47800;
+const uint32_t TELEMETRY_FRAME_MAGIC = 0x524B544D; // "RKTM"
+const uint16_t TELEMETRY_FRAME_VERSION = 1;
+const int TELEMETRY_MAX_RECORDS_PER_FRAME = 64;
+
+struct TelemetryFrameHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;         // Records that follow
+    uint64_t sequence;      // Frame number, gaps mean the frame was coalesced away
+    uint64_t sendTimeNs;    // Steady clock when the frame was built
+};
+
+struct TelemetryWireRecord {
+    uint64_t submitTimeNs;  // Steady clock when the physics thread submitted it
+    uint32_t step;          // Submit count, gaps mean the ring was full
+    float time;
+    float position[3];
+    float velocity[3];
+    float fuelLevel;
+    float mass;
+    float acceleration;
+    float thrustLevels[5];
+};
+
+static_assert(sizeof(TelemetryFrameHeader) == 24, "telemetry frame header layout changed");
+static_assert(sizeof(TelemetryWireRecord) == 72, "telemetry record layout changed");
+
+// Steady clock in nanoseconds, the time base of both timestamps above
+uint64_t TelemetryClockNs();
+
+struct TelemetryServerOptions {
+    uint16_t port = TELEMETRY_DEFAULT_PORT; // TCP and UDP
+    int batchIntervalMs = 5;                // Longest a record waits for its frame
+    size_t clientBufferBytes = 256 * 1024;  // Unsent data per TCP client before coalescing
+};
+
+struct TelemetryServerStats {
+    uint64_t submitted;
+    uint64_t dropped;           // Ring full at submit
+    uint64_t framesSent;        // Per client
+    uint64_t framesCoalesced;   // Replaced by a newer frame before a slow client took them
+    uint64_t bytesSent;
+    uint32_t clients;           // TCP clients plus UDP subscribers
+};
+
+class TelemetryServer {
+public:
+    ~TelemetryServer();
+
+    bool start(const TelemetryServerOptions& options = TelemetryServerOptions());
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Physics thread only. Never blocks; returns false when the record was dropped.
+    bool submit(const TelemetryRecord& record);
+
+    TelemetryServerStats stats() const;
+
+private:
+    static const size_t RING_CAPACITY = 8192; // Power of two, ~1.4 s of steps at 6 kHz
+
+    struct Client {
+        SocketHandle socket;
+        std::vector<uint8_t> pending;   // Whole frames, oldest first
+        size_t sent = 0;                // Bytes of pending already on the wire
+        bool closed = false;
+    };
+
+    struct Subscriber {
+        sockaddr_in address;
+        SocketLength length;
+        uint64_t lastSeenNs;
+    };
+
+    void run();
+    void acceptClients();
+    void readSubscriptions();
+    size_t buildFrame(uint64_t sequence);
+    void queueFrame(Client& client);
+    bool flushClient(Client& client);
+
+    TelemetryServerOptions options;
+    std::unique_ptr<TelemetryWireRecord[]> ring;
+    alignas(64) std::atomic<uint64_t> head{ 0 }; // Written by submit()
+    alignas(64) std::atomic<uint64_t> tail{ 0 }; // Written by the server thread
+    alignas(64) uint32_t submitCount = 0;
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    SocketHandle listener = INVALID_SOCKET_HANDLE;
+    SocketHandle datagrams = INVALID_SOCKET_HANDLE;
+    std::vector<Client> clients;
+    std::vector<Subscriber> subscribers;
+    std::vector<uint8_t> frame;
+
+    std::atomic<uint64_t> droppedCount{ 0 };
+    std::atomic<uint64_t> framesSentCount{ 0 };
+    std::atomic<uint64_t> framesCoalescedCount{ 0 };
+    std::atomic<uint64_t> bytesSentCount{ 0 };
+    std::atomic<uint32_t> clientCount{ 0 };
+};
+
+// Connects to a running server and prints latency and throughput
+int RunTelemetryClient(float duration, uint16_t port, bool udp);
+
+// Flies one launch in real time at the given step rate while serving telemetry
+int RunTelemetryServer(float duration, uint16_t port, float stepRate);
+
+#endif
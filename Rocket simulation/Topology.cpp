@@ -0,0 +1,139 @@
+#include "Topology.h"
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int CpuTopology::cpuCount() const {
+    int count = 0;
+    for (const std::vector<int>& node : nodes) count += static_cast<int>(node.size());
+    return count;
+}
+
+#ifdef _WIN32
+static std::vector<int> AllowedCpus() {
+    std::vector<int> cpus;
+    DWORD_PTR process = 0, system = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+        for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); cpu++) {
+            if (process & (DWORD_PTR(1) << cpu)) cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Processor groups beyond the first are left out, like the affinity mask
+static std::vector<std::vector<int> > NodeCpus() {
+    std::vector<std::vector<int> > nodes;
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) return nodes;
+    for (ULONG node = 0; node <= highest; node++) {
+        ULONGLONG mask = 0;
+        std::vector<int> cpus;
+        if (GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask)) {
+            for (int cpu = 0; cpu < 64; cpu++) {
+                if (mask & (ULONGLONG(1) << cpu)) cpus.push_back(cpu);
+            }
+        }
+        nodes.push_back(cpus);
+    }
+    return nodes;
+}
+
+bool PinThreadToCpu(int cpu) {
+    return cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)
+        && SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+}
+#else
+static std::vector<int> AllowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// A cpulist is ranges and single CPUs, e.g. "0-7,16-23"
+static std::vector<int> ParseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    size_t at = 0;
+    while (at < list.size()) {
+        size_t end = list.find(',', at);
+        if (end == std::string::npos) end = list.size();
+        std::string range = list.substr(at, end - at);
+        size_t dash = range.find('-');
+        if (!range.empty() && range[0] >= '0' && range[0] <= '9') {
+            int first = std::stoi(range);
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+        at = end + 1;
+    }
+    return cpus;
+}
+
+// Node numbers can have holes; stop after a run of missing ones
+static std::vector<std::vector<int> > NodeCpus() {
+    std::vector<std::vector<int> > nodes;
+    for (int node = 0, missing = 0; missing < 64; node++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list)) {
+            missing++;
+            continue;
+        }
+        missing = 0;
+        nodes.push_back(ParseCpuList(list));
+    }
+    return nodes;
+}
+
+bool PinThreadToCpu(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+#endif
+
+CpuTopology DetectTopology() {
+    std::vector<int> allowed = AllowedCpus();
+    CpuTopology topology;
+    for (std::vector<int>& node : NodeCpus()) {
+        std::vector<int> usable;
+        for (int cpu : node) {
+            if (allowed.empty() || std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) usable.push_back(cpu);
+        }
+        if (!usable.empty()) topology.nodes.push_back(usable); // CPU-less nodes are memory only
+    }
+    if (topology.nodes.empty()) {
+        if (allowed.empty()) {
+            int count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            for (int cpu = 0; cpu < count; cpu++) allowed.push_back(cpu);
+        }
+        topology.nodes.push_back(allowed);
+    }
+    return topology;
+}
+
+int SpreadCpu(const CpuTopology& topology, int index, int* node) {
+    int nodeCount = static_cast<int>(topology.nodes.size());
+    int chosen = index % nodeCount;
+    const std::vector<int>& cpus = topology.nodes[chosen];
+    if (node != nullptr) *node = chosen;
+    return cpus[(index / nodeCount) % cpus.size()];
+}
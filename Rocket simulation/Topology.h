@@ -0,0 +1,30 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <vector>
+
+// Which CPUs sit on which NUMA node, so a thread can be kept on the node
+// that holds the memory it works on. Memory is placed by first touch: a page
+// lands on the node of the thread that first writes it, so data a pinned
+// thread allocates and fills itself stays local to it.
+
+struct CpuTopology {
+    std::vector<std::vector<int> > nodes; // CPUs this process may use, per node; never empty
+
+    int cpuCount() const;
+};
+
+// From /sys/devices/system/node on Linux and the NUMA API on Windows, limited
+// to the CPUs the process may run on. One node holding every CPU where
+// neither says more.
+CpuTopology DetectTopology();
+
+// CPU for the index-th of a set of threads: round robin over the nodes first,
+// so two threads already use two sockets, then over each node's CPUs. node,
+// if given, receives the node.
+int SpreadCpu(const CpuTopology& topology, int index, int* node = nullptr);
+
+// Pins the calling thread to one CPU
+bool PinThreadToCpu(int cpu);
+
+#endif
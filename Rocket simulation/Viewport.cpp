@@ -0,0 +1,536 @@
+#include "Viewport.h"
+#include "imgui.h"
+#include "imgui_impl_opengl3.h"
+#include "imgui_impl_opengl3_loader.h"
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+// Stream buffer layout: every region has a fixed offset, so each one can be
+// refreshed on its own with glBufferSubData.
+static const size_t TRAIL_OFFSET = 0;
+static const size_t TRAJECTORY_OFFSET = TRAIL_OFFSET + sizeof(glm::vec3) * RocketViewport::MAX_TRAIL_POINTS;
+static const size_t INSTANCE_OFFSET = TRAJECTORY_OFFSET + sizeof(glm::vec3) * RocketViewport::MAX_TRAJECTORY_POINTS;
+static const size_t STREAM_SIZE = INSTANCE_OFFSET + sizeof(VehicleInstance) * (RocketViewport::MAX_VEHICLES + 1);
+
+const int MESH_SEGMENTS = 12;
+const float BODY_RADIUS = 0.1f;
+const float BODY_HEIGHT = 0.8f;     // Nose cone on top up to 1.0
+const int GRID_LINES = 21;
+const float GRID_SPACING = 50.0f;   // Metres
+const float VEHICLE_SIZE = 0.04f;   // Drawn size as a fraction of the camera distance, so it never vanishes
+
+static const char* VEHICLE_VERTEX_SHADER =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 Position;\n"
+    "layout (location = 1) in vec4 Instance;\n" // xyz position, w scale
+    "layout (location = 2) in vec4 Color;\n"
+    "uniform mat4 ViewProjection;\n"
+    "uniform float VehicleScale;\n"
+    "out vec4 Frag_Color;\n"
+    "void main() {\n"
+    "    float facing = dot(normalize(vec3(Position.x, 0.05, Position.z)), normalize(vec3(0.6, 0.3, 0.75)));\n"
+    "    Frag_Color = vec4(Color.rgb * (0.55 + 0.45 * max(facing, 0.0)), Color.a);\n"
+    "    gl_Position = ViewProjection * vec4(Instance.xyz + Position * Instance.w * VehicleScale, 1.0);\n"
+    "}\n";
+
+static const char* LINE_VERTEX_SHADER =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 Position;\n"
+    "uniform mat4 ViewProjection;\n"
+    "uniform vec4 Color;\n"
+    "out vec4 Frag_Color;\n"
+    "void main() {\n"
+    "    Frag_Color = Color;\n"
+    "    gl_Position = ViewProjection * vec4(Position, 1.0);\n"
+    "}\n";
+
+static const char* FRAGMENT_SHADER =
+    "#version 330 core\n"
+    "in vec4 Frag_Color;\n"
+    "layout (location = 0) out vec4 Out_Color;\n"
+    "void main() {\n"
+    "    Out_Color = Frag_Color;\n"
+    "}\n";
+
+static GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Viewport shader failed to compile: " << log << std::endl;
+    }
+    return shader;
+}
+
+static GLuint linkProgram(const char* vertexSource) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        char log[512];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "Viewport program failed to link: " << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// Unit rocket along +y: a cylinder body and a nose cone, as plain triangles
+static void buildVehicleMesh(std::vector<glm::vec3>& vertices) {
+    for (int i = 0; i < MESH_SEGMENTS; i++) {
+        float a0 = 6.2831853f * i / MESH_SEGMENTS;
+        float a1 = 6.2831853f * (i + 1) / MESH_SEGMENTS;
+        glm::vec3 bottom0(BODY_RADIUS * std::cos(a0), 0.0f, BODY_RADIUS * std::sin(a0));
+        glm::vec3 bottom1(BODY_RADIUS * std::cos(a1), 0.0f, BODY_RADIUS * std::sin(a1));
+        glm::vec3 top0(bottom0.x, BODY_HEIGHT, bottom0.z);
+        glm::vec3 top1(bottom1.x, BODY_HEIGHT, bottom1.z);
+        glm::vec3 nose(0.0f, 1.0f, 0.0f);
+
+        vertices.push_back(bottom0); vertices.push_back(bottom1); vertices.push_back(top1);
+        vertices.push_back(bottom0); vertices.push_back(top1); vertices.push_back(top0);
+        vertices.push_back(top0); vertices.push_back(top1); vertices.push_back(nose);
+    }
+}
+
+// Ground grid around the pad, drawn as GL_LINES
+static void buildGrid(std::vector<glm::vec3>& vertices) {
+    float extent = GRID_SPACING * (GRID_LINES - 1) / 2;
+    for (int i = 0; i < GRID_LINES; i++) {
+        float offset = -extent + GRID_SPACING * i;
+        vertices.push_back(glm::vec3(offset, 0.0f, -extent));
+        vertices.push_back(glm::vec3(offset, 0.0f, extent));
+        vertices.push_back(glm::vec3(-extent, 0.0f, offset));
+        vertices.push_back(glm::vec3(extent, 0.0f, offset));
+    }
+}
+
+RocketViewport::RocketViewport() {}
+
+RocketViewport::~RocketViewport() {
+    // GL objects need the context, which is gone by now; shutdown() releases them
+}
+
+bool RocketViewport::init() {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major * 10 + minor < 33) {
+        std::cerr << "3D view disabled: needs OpenGL 3.3, context is " << major << "." << minor << std::endl;
+        return false;
+    }
+
+    program = linkProgram(VEHICLE_VERTEX_SHADER);
+    lineProgram = linkProgram(LINE_VERTEX_SHADER);
+    if (program == 0 || lineProgram == 0) {
+        shutdown();
+        return false;
+    }
+    viewProjectionLocation = glGetUniformLocation(program, "ViewProjection");
+    vehicleScaleLocation = glGetUniformLocation(program, "VehicleScale");
+    lineViewProjectionLocation = glGetUniformLocation(lineProgram, "ViewProjection");
+    lineColorLocation = glGetUniformLocation(lineProgram, "Color");
+
+    trail.reserve(MAX_TRAIL_POINTS);
+    trajectoryPoints.reserve(MAX_TRAJECTORY_POINTS);
+    trajectoryFirsts.reserve(MAX_TRAJECTORIES);
+    trajectoryCounts.reserve(MAX_TRAJECTORIES);
+    vehicles.assign(MAX_VEHICLES + 1, VehicleInstance{ glm::vec3(0.0f), 1.0f, 0xFFFFFFFFu });
+
+    GLint lastArrayBuffer = 0, lastVertexArray = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &lastVertexArray);
+
+    std::vector<glm::vec3> staticVertices;
+    buildVehicleMesh(staticVertices);
+    meshVertices = static_cast<int>(staticVertices.size());
+    buildGrid(staticVertices);
+    gridVertices = static_cast<int>(staticVertices.size()) - meshVertices;
+
+    glGenBuffers(1, &staticBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, staticBuffer);
+    glBufferData(GL_ARRAY_BUFFER, staticVertices.size() * sizeof(glm::vec3), staticVertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &streamBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    glBufferData(GL_ARRAY_BUFFER, STREAM_SIZE, nullptr, GL_STREAM_DRAW);
+
+    glGenVertexArrays(1, &staticVao);
+    glBindVertexArray(staticVao);
+    glBindBuffer(GL_ARRAY_BUFFER, staticBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+
+    glGenVertexArrays(1, &streamVao);
+    glBindVertexArray(streamVao);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(TRAIL_OFFSET));
+
+    // Mesh from the static buffer, one VehicleInstance per instance from the stream buffer
+    glGenVertexArrays(1, &vehicleVao);
+    glBindVertexArray(vehicleVao);
+    glBindBuffer(GL_ARRAY_BUFFER, staticBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(VehicleInstance), reinterpret_cast<void*>(INSTANCE_OFFSET));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VehicleInstance),
+        reinterpret_cast<void*>(INSTANCE_OFFSET + offsetof(VehicleInstance, color)));
+    glVertexAttribDivisor(2, 1);
+
+    glBindVertexArray(static_cast<GLuint>(lastVertexArray));
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(lastArrayBuffer));
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenTextures(1, &colorTexture);
+    glGenRenderbuffers(1, &depthBuffer);
+    return true;
+}
+
+void RocketViewport::shutdown() {
+    if (framebuffer) { glDeleteFramebuffers(1, &framebuffer); framebuffer = 0; }
+    if (colorTexture) { glDeleteTextures(1, &colorTexture); colorTexture = 0; }
+    if (depthBuffer) { glDeleteRenderbuffers(1, &depthBuffer); depthBuffer = 0; }
+    if (streamVao) { glDeleteVertexArrays(1, &streamVao); streamVao = 0; }
+    if (staticVao) { glDeleteVertexArrays(1, &staticVao); staticVao = 0; }
+    if (vehicleVao) { glDeleteVertexArrays(1, &vehicleVao); vehicleVao = 0; }
+    if (streamBuffer) { glDeleteBuffers(1, &streamBuffer); streamBuffer = 0; }
+    if (staticBuffer) { glDeleteBuffers(1, &staticBuffer); staticBuffer = 0; }
+    if (program) { glDeleteProgram(program); program = 0; }
+    if (lineProgram) { glDeleteProgram(lineProgram); lineProgram = 0; }
+    targetWidth = targetHeight = 0;
+}
+
+void RocketViewport::addTrailPoint(const glm::vec3& position) {
+    if (!isAvailable()) return;
+    if (!trail.empty() && trail.back() == position) {
+        return; // Standing still, e.g. back on the ground
+    }
+    if (++trailSkipped < trailStride) return;
+    trailSkipped = 0;
+
+    if (static_cast<int>(trail.size()) == MAX_TRAIL_POINTS) {
+        for (int i = 0; i < MAX_TRAIL_POINTS / 2; i++) {
+            trail[i] = trail[i * 2];
+        }
+        trail.resize(MAX_TRAIL_POINTS / 2);
+        trailStride *= 2;
+        trailUploaded = 0; // Every point moved, upload the lot again
+    }
+    trail.push_back(position);
+}
+
+void RocketViewport::clearTrail() {
+    trail.clear();
+    trailStride = 1;
+    trailSkipped = 0;
+    trailUploaded = 0;
+}
+
+void RocketViewport::setVehicle(const glm::vec3& position) {
+    if (!isAvailable()) return;
+    vehicles[0].position = position;
+    vehicleDirty = true;
+}
+
+void RocketViewport::setFleet(const VehicleInstance* fleet, int count) {
+    if (!isAvailable()) return;
+    vehicleCount = count < MAX_VEHICLES ? count : MAX_VEHICLES;
+    std::memcpy(&vehicles[1], fleet, sizeof(VehicleInstance) * vehicleCount);
+    fleetDirty = true;
+}
+
+bool RocketViewport::addTrajectory(const glm::vec3* points, int count) {
+    if (!isAvailable()) return false;
+    if (static_cast<int>(trajectoryCounts.size()) == MAX_TRAJECTORIES
+        || static_cast<int>(trajectoryPoints.size()) + count > MAX_TRAJECTORY_POINTS) {
+        return false;
+    }
+    // First vertex is an index into the whole stream buffer, past the trail region
+    trajectoryFirsts.push_back(MAX_TRAIL_POINTS + static_cast<int>(trajectoryPoints.size()));
+    trajectoryCounts.push_back(count);
+    trajectoryPoints.insert(trajectoryPoints.end(), points, points + count);
+    fleetDirty = true;
+    return true;
+}
+
+void RocketViewport::clearFleet() {
+    vehicleCount = 0;
+    trajectoryPoints.clear();
+    trajectoryFirsts.clear();
+    trajectoryCounts.clear();
+    fleetDirty = true;
+}
+
+void RocketViewport::orbit(float yawDegrees, float pitchDegrees) {
+    yaw = std::fmod(yaw + yawDegrees, 360.0f);
+    pitch += pitchDegrees;
+    if (pitch < -5.0f) pitch = -5.0f;
+    if (pitch > 89.0f) pitch = 89.0f;
+}
+
+void RocketViewport::zoom(float steps) {
+    distance *= std::pow(0.9f, steps);
+    if (distance < 10.0f) distance = 10.0f;
+    if (distance > 50000.0f) distance = 50000.0f;
+}
+
+// Only what changed since the last frame goes to the GPU: new trail points,
+// the main vehicle, and the fleet when it was replaced.
+void RocketViewport::uploadStream() {
+    uploadBytes = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+
+    int trailSize = static_cast<int>(trail.size());
+    if (trailUploaded > trailSize) trailUploaded = 0;
+    if (trailUploaded < trailSize) {
+        size_t bytes = sizeof(glm::vec3) * (trailSize - trailUploaded);
+        glBufferSubData(GL_ARRAY_BUFFER, TRAIL_OFFSET + sizeof(glm::vec3) * trailUploaded, bytes, &trail[trailUploaded]);
+        uploadBytes += bytes;
+        trailUploaded = trailSize;
+    }
+
+    if (fleetDirty) {
+        size_t pointBytes = sizeof(glm::vec3) * trajectoryPoints.size();
+        if (pointBytes > 0) {
+            glBufferSubData(GL_ARRAY_BUFFER, TRAJECTORY_OFFSET, pointBytes, trajectoryPoints.data());
+        }
+        size_t instanceBytes = sizeof(VehicleInstance) * vehicleCount;
+        if (instanceBytes > 0) {
+            glBufferSubData(GL_ARRAY_BUFFER, INSTANCE_OFFSET + sizeof(VehicleInstance), instanceBytes, &vehicles[1]);
+        }
+        uploadBytes += pointBytes + instanceBytes;
+        fleetDirty = false;
+    }
+
+    if (vehicleDirty) {
+        glBufferSubData(GL_ARRAY_BUFFER, INSTANCE_OFFSET, sizeof(VehicleInstance), &vehicles[0]);
+        uploadBytes += sizeof(VehicleInstance);
+        vehicleDirty = false;
+    }
+}
+
+void RocketViewport::resizeTarget(int width, int height) {
+    if (width == targetWidth && height == targetHeight) return;
+    targetWidth = width;
+    targetHeight = height;
+
+    GLint lastTexture = 0, lastRenderbuffer = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+    glGetIntegerv(GL_RENDERBUFFER_BINDING, &lastRenderbuffer);
+
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "3D view framebuffer incomplete at " << width << "x" << height << std::endl;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(lastTexture));
+    glBindRenderbuffer(GL_RENDERBUFFER, static_cast<GLuint>(lastRenderbuffer));
+}
+
+void RocketViewport::render(int width, int height) {
+    drawCalls = 0;
+    if (!isAvailable() || width <= 0 || height <= 0) return;
+
+    // Leave the GL state as we found it for the ImGui backend
+    GLint lastFramebuffer = 0, lastProgram = 0, lastVertexArray = 0, lastArrayBuffer = 0;
+    GLint lastViewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &lastFramebuffer);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &lastProgram);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &lastVertexArray);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+    glGetIntegerv(GL_VIEWPORT, lastViewport);
+    GLboolean lastDepthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean lastBlend = glIsEnabled(GL_BLEND);
+    GLboolean lastScissorTest = glIsEnabled(GL_SCISSOR_TEST);
+
+    resizeTarget(width, height);
+    uploadStream();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(0.08f, 0.10f, 0.14f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Orbit camera around the main vehicle
+    glm::vec3 target = vehicles[0].position;
+    float yawRadians = glm::radians(yaw), pitchRadians = glm::radians(pitch);
+    glm::vec3 eye = target + distance * glm::vec3(std::cos(pitchRadians) * std::sin(yawRadians),
+        std::sin(pitchRadians), std::cos(pitchRadians) * std::cos(yawRadians));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), static_cast<float>(width) / height,
+        distance * 0.01f, distance * 100.0f + target.y * 2.0f);
+    glm::mat4 viewProjection = projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    glUseProgram(lineProgram);
+    glUniformMatrix4fv(lineViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glUniform4f(lineColorLocation, 0.35f, 0.40f, 0.45f, 1.0f);
+    glBindVertexArray(staticVao);
+    glDrawArrays(GL_LINES, meshVertices, gridVertices);
+    drawCalls++;
+
+    glBindVertexArray(streamVao);
+    if (!trajectoryCounts.empty()) {
+        glUniform4f(lineColorLocation, 0.40f, 0.65f, 1.0f, 0.25f);
+        glMultiDrawArrays(GL_LINE_STRIP, trajectoryFirsts.data(), trajectoryCounts.data(), static_cast<GLsizei>(trajectoryCounts.size()));
+        drawCalls++;
+    }
+    if (trail.size() > 1) {
+        glUniform4f(lineColorLocation, 1.0f, 0.65f, 0.0f, 1.0f);
+        glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(trail.size()));
+        drawCalls++;
+    }
+
+    glUseProgram(program);
+    glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glUniform1f(vehicleScaleLocation, distance * VEHICLE_SIZE);
+    glBindVertexArray(vehicleVao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, meshVertices, vehicleCount + 1);
+    drawCalls++;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(lastFramebuffer));
+    glViewport(lastViewport[0], lastViewport[1], lastViewport[2], lastViewport[3]);
+    glUseProgram(static_cast<GLuint>(lastProgram));
+    glBindVertexArray(static_cast<GLuint>(lastVertexArray));
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(lastArrayBuffer));
+    if (lastDepthTest) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+    if (lastBlend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    if (lastScissorTest) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
+}
+
+int RunViewportBenchmark(int trailPoints, int vehicles, int trajectories, int pointsPerTrajectory, int frames) {
+    const int width = 1280, height = 720;
+    const double FRAME_BUDGET_MS = 1000.0 / 60.0;
+    if (trailPoints < 0 || vehicles < 0 || trajectories < 0 || pointsPerTrajectory < 2 || frames <= 0) {
+        std::cerr << "Viewport benchmark needs trail points, vehicles, trajectories, points per trajectory and frames" << std::endl;
+        return -1;
+    }
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(width, height, "Viewport benchmark", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    ImGui::CreateContext();
+    ImGui_ImplOpenGL3_Init("#version 130"); // Loads the GL functions, as in the dashboard
+
+    int exitCode = 0;
+    {
+        RocketViewport view;
+        if (!view.init()) {
+            std::cerr << "The 3D view needs OpenGL 3.3" << std::endl;
+            exitCode = -1;
+        }
+        else {
+            // A spiral climb for the trail, a fan of arcs for the trajectories and
+            // a grid of vehicles, all in front of the camera. The trail stops short
+            // of full so the timed frames never thin it out.
+            int filled = std::max(0, std::min(trailPoints, RocketViewport::MAX_TRAIL_POINTS - frames - 20));
+            for (int i = 0; i < filled; i++) {
+                float t = static_cast<float>(i) / std::max(1, filled - 1);
+                view.addTrailPoint(glm::vec3(40.0f * std::sin(t * 60.0f), 2000.0f * t, 40.0f * std::cos(t * 60.0f)));
+            }
+            std::vector<glm::vec3> path(static_cast<size_t>(pointsPerTrajectory));
+            int drawnTrajectories = 0;
+            for (int k = 0; k < trajectories; k++) {
+                float heading = 6.2831853f * k / std::max(1, trajectories);
+                for (int j = 0; j < pointsPerTrajectory; j++) {
+                    float t = static_cast<float>(j) / (pointsPerTrajectory - 1);
+                    path[j] = glm::vec3(300.0f * t * std::cos(heading), 2000.0f * t * (1.2f - 0.4f * t), 300.0f * t * std::sin(heading));
+                }
+                if (view.addTrajectory(path.data(), pointsPerTrajectory)) drawnTrajectories++;
+            }
+            std::vector<VehicleInstance> fleet(static_cast<size_t>(vehicles));
+            int side = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(vehicles))));
+            for (int i = 0; i < vehicles; i++) {
+                fleet[i] = { glm::vec3(10.0f * (i % side - side / 2), 1500.0f, 10.0f * (i / side - side / 2)), 0.5f, 0xFF40A0FFu };
+            }
+            view.setFleet(fleet.data(), vehicles);
+            view.zoom(-25.0f); // Back far enough to have everything in view
+
+            // The first frames upload the whole scene; time the steady ones
+            std::vector<double> frameMs(static_cast<size_t>(frames));
+            glm::vec3 top(0.0f, 2000.0f, 0.0f);
+            for (int f = -10; f < frames; f++) {
+                auto start = std::chrono::steady_clock::now();
+                top.y += 0.5f;
+                view.addTrailPoint(top);
+                view.setVehicle(top);
+                view.render(width, height);
+                glFinish();
+                if (f >= 0) frameMs[f] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            std::sort(frameMs.begin(), frameMs.end());
+            double sum = 0.0;
+            for (double ms : frameMs) sum += ms;
+            double mean = sum / frames;
+            double p99 = frameMs[std::min<size_t>(frameMs.size() - 1, frameMs.size() * 99 / 100)];
+
+            std::cout << "Viewport: " << glGetString(GL_RENDERER) << ", " << width << "x" << height << std::endl;
+            std::cout << "Scene: " << view.trailPoints() << " trail points, " << drawnTrajectories << " trajectories of "
+                << pointsPerTrajectory << " points, " << view.fleetVehicles() << " vehicles; "
+                << view.lastDrawCalls() << " draw calls, " << view.lastUploadBytes() << " bytes uploaded per frame" << std::endl;
+            std::cout << std::fixed << std::setprecision(2) << "Frame (ms) over " << frames << " frames: mean " << mean
+                << ", p50 " << frameMs[frameMs.size() / 2] << ", p99 " << p99 << ", max " << frameMs.back() << std::endl;
+            std::cout << "60 FPS budget (" << FRAME_BUDGET_MS << " ms) " << (p99 <= FRAME_BUDGET_MS ? "met" : "missed")
+                << " at p99 for the view alone; the dashboard draws on top of it" << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+            std::cout << std::setprecision(6);
+            if (GLenum error = glGetError()) std::cerr << "GL error 0x" << std::hex << error << std::dec << std::endl;
+        }
+        view.shutdown();
+    }
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return exitCode;
+}
@@ -0,0 +1,100 @@
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// One vehicle drawn by the 3D view. Fleets pass thousands of these per frame.
+struct VehicleInstance {
+    glm::vec3 position;
+    float scale;    // Relative to the main vehicle
+    uint32_t color; // RGBA8, same packing as IM_COL32
+};
+
+// 3D view of the flight rendered into an offscreen framebuffer and shown with
+// ImGui::Image. Everything dynamic (trail, fleet trajectories, vehicle
+// instances) lives in one streamed vertex buffer at fixed offsets, so the
+// trail only uploads the points added since the last frame and every vehicle
+// is a single instanced draw. Needs OpenGL 3.3; call init() after
+// ImGui_ImplOpenGL3_Init(), which loads the GL functions used here.
+class RocketViewport {
+public:
+    static const int MAX_TRAIL_POINTS = 100000;
+    static const int MAX_TRAJECTORY_POINTS = 500000; // Shared by all fleet trajectories
+    static const int MAX_TRAJECTORIES = 10000;
+    static const int MAX_VEHICLES = 10000;           // Fleet instances, the main vehicle comes on top
+
+    RocketViewport();
+    ~RocketViewport();
+    RocketViewport(const RocketViewport&) = delete;
+    RocketViewport& operator=(const RocketViewport&) = delete;
+
+    bool init();
+    void shutdown();
+    bool isAvailable() const { return program != 0; }
+
+    // The trail keeps the whole flight: once full it drops every other point
+    // and records at half the rate from then on.
+    void addTrailPoint(const glm::vec3& position);
+    void clearTrail();
+    void setVehicle(const glm::vec3& position);
+
+    // Fleet hook for Monte Carlo runs: vehicles are drawn instanced, the
+    // trajectories as line strips in one multi-draw.
+    void setFleet(const VehicleInstance* vehicles, int count);
+    bool addTrajectory(const glm::vec3* points, int count);
+    void clearFleet();
+
+    void orbit(float yawDegrees, float pitchDegrees);
+    void zoom(float steps);
+
+    // Renders into the offscreen target, resizing it when needed
+    void render(int width, int height);
+    void* texture() const { return reinterpret_cast<void*>(static_cast<intptr_t>(colorTexture)); }
+
+    int trailPoints() const { return static_cast<int>(trail.size()); }
+    int fleetVehicles() const { return vehicleCount; }
+    int lastDrawCalls() const { return drawCalls; }
+    size_t lastUploadBytes() const { return uploadBytes; }
+
+private:
+    void uploadStream();
+    void resizeTarget(int width, int height);
+
+    // Scene data, reserved up front so adding to it never allocates
+    std::vector<glm::vec3> trail;
+    int trailStride = 1;     // Record one point every trailStride calls
+    int trailSkipped = 0;
+    int trailUploaded = 0;   // Points already in the stream buffer
+    std::vector<glm::vec3> trajectoryPoints;
+    std::vector<int> trajectoryFirsts;
+    std::vector<int> trajectoryCounts;
+    std::vector<VehicleInstance> vehicles; // [0] is the main vehicle
+    int vehicleCount = 0;
+    bool fleetDirty = true;
+    bool vehicleDirty = true;
+
+    float yaw = 45.0f, pitch = 20.0f, distance = 250.0f;
+
+    // GL objects
+    unsigned int program = 0, lineProgram = 0;
+    int viewProjectionLocation = -1, vehicleScaleLocation = -1;
+    int lineViewProjectionLocation = -1, lineColorLocation = -1;
+    unsigned int streamBuffer = 0, staticBuffer = 0;
+    unsigned int streamVao = 0, staticVao = 0, vehicleVao = 0;
+    unsigned int framebuffer = 0, colorTexture = 0, depthBuffer = 0;
+    int targetWidth = 0, targetHeight = 0;
+    int meshVertices = 0, gridVertices = 0;
+
+    int drawCalls = 0;
+    size_t uploadBytes = 0;
+};
+
+// Renders a synthetic worst case offscreen in a hidden window: a trail,
+// trajectories of pointsPerTrajectory points and vehicle instances, then
+// times frames that each add a trail point, as a flight does. Reports the
+// frame times against the 60 FPS budget.
+int RunViewportBenchmark(int trailPoints, int vehicles, int trajectories, int pointsPerTrajectory, int frames);
+
+#endif
@@ -22,6 +22,7 @@
 
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
+//  (local)     OpenGL: Optional persistent mapped ring buffers (GL 4.4 / GL_ARB_buffer_storage) via ImGui_ImplOpenGL3_SetPersistentBuffers(), upload counters via ImGui_ImplOpenGL3_GetRenderStats().
 //  2024-06-28: OpenGL: ImGui_ImplOpenGL3_NewFrame() recreates font texture if it has been destroyed by ImGui_ImplOpenGL3_DestroyFontsTexture(). (#7748)
 //  2024-05-07: OpenGL: Update loader for Linux to support EGL/GLVND. (#7562)
 //  2024-04-16: OpenGL: Detect ES3 contexts on desktop based on version string, to e.g. avoid calling glPolygonMode() on them. (#7447)
@@ -207,6 +208,15 @@
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
 #endif
 
+// Desktop GL 4.4+ (or GL_ARB_buffer_storage) has glBufferStorage() for persistent mapped buffers.
+// The entry points come from our loader, so a custom loader opts out.
+#if !defined(IMGUI_IMPL_OPENGL_ES2) && !defined(IMGUI_IMPL_OPENGL_ES3) && !defined(IMGUI_IMPL_OPENGL_LOADER_CUSTOM) && defined(GL_VERSION_4_4)
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+#endif
+
+// Frames in flight for the persistent ring: the CPU writes region N while the GPU may still read N-1 and N-2.
+#define IMGUI_IMPL_OPENGL_RING_REGIONS  3
+
 // [Debugging]
 //#define IMGUI_IMPL_OPENGL_DEBUG
 #ifdef IMGUI_IMPL_OPENGL_DEBUG
@@ -238,6 +248,18 @@ struct ImGui_ImplOpenGL3_Data
     bool            HasPolygonMode;
     bool            HasClipOrigin;
     bool            UseBufferSubData;
+    bool            HasBufferStorage;        // GL 4.4+ or GL_ARB_buffer_storage, with glDrawElementsBaseVertex()
+    bool            UsePersistentBuffers;    // Set by ImGui_ImplOpenGL3_SetPersistentBuffers()
+    ImGui_ImplOpenGL3_RenderStats Stats;     // Counters for the last ImGui_ImplOpenGL3_RenderDrawData()
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    GLuint          RingVboHandle, RingElementsHandle;
+    ImDrawVert*     RingVtxMapped;           // Persistently mapped, IMGUI_IMPL_OPENGL_RING_REGIONS regions of RingVtxCapacity vertices
+    ImDrawIdx*      RingIdxMapped;
+    int             RingVtxCapacity;         // Per region
+    int             RingIdxCapacity;
+    int             RingRegion;              // Region the next frame writes to
+    GLsync          RingFences[IMGUI_IMPL_OPENGL_RING_REGIONS];
+#endif
 
     ImGui_ImplOpenGL3_Data() { memset((void*)this, 0, sizeof(*this)); }
 };
@@ -378,8 +400,18 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
         const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
         if (extension != nullptr && strcmp(extension, "GL_ARB_clip_control") == 0)
             bd->HasClipOrigin = true;
+        if (extension != nullptr && strcmp(extension, "GL_ARB_buffer_storage") == 0)
+            bd->HasBufferStorage = true;
     }
 #endif
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (bd->GlVersion >= 440)
+        bd->HasBufferStorage = true;
+    // Merged uploads address each draw list through the base vertex, and the loader must have found the entry points
+    bd->HasBufferStorage = bd->HasBufferStorage && bd->GlVersion >= 320 && glBufferStorage != nullptr && glMapBufferRange != nullptr && glFenceSync != nullptr && glClientWaitSync != nullptr;
+#else
+    bd->HasBufferStorage = false;
+#endif
 
     return true;
 }
@@ -472,8 +504,18 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
 #endif
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->ElementsHandle));
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (bd->Stats.PersistentBuffers)
+    {
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->RingVboHandle));
+        GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->RingElementsHandle));
+    }
+    else
+#endif
+    {
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
+        GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->ElementsHandle));
+    }
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxPos));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxUV));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxColor));
@@ -482,6 +524,110 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, col)));
 }
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+static void ImGui_ImplOpenGL3_WaitRingFence(ImGui_ImplOpenGL3_Data* bd, int region)
+{
+    GLsync fence = bd->RingFences[region];
+    if (fence == nullptr)
+        return;
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        // The GPU is still reading this region: a stall worth counting
+        bd->Stats.FenceWaits++;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+    }
+    glDeleteSync(fence);
+    bd->RingFences[region] = nullptr;
+}
+
+static void ImGui_ImplOpenGL3_DestroyRingBuffers(ImGui_ImplOpenGL3_Data* bd)
+{
+    for (int region = 0; region < IMGUI_IMPL_OPENGL_RING_REGIONS; region++)
+        ImGui_ImplOpenGL3_WaitRingFence(bd, region);
+    // Deleting a buffer implicitly unmaps it
+    if (bd->RingVboHandle)      { glDeleteBuffers(1, &bd->RingVboHandle); bd->RingVboHandle = 0; }
+    if (bd->RingElementsHandle) { glDeleteBuffers(1, &bd->RingElementsHandle); bd->RingElementsHandle = 0; }
+    bd->RingVtxMapped = nullptr;
+    bd->RingIdxMapped = nullptr;
+    bd->RingVtxCapacity = bd->RingIdxCapacity = 0;
+    bd->RingRegion = 0;
+}
+
+static void* ImGui_ImplOpenGL3_CreatePersistentBuffer(GLuint* handle, GLsizeiptr size)
+{
+    // Buffer objects are untyped, so GL_ARRAY_BUFFER also serves for the index buffer and leaves the caller's VAO alone
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
+    GL_CALL(glGenBuffers(1, handle));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, *handle));
+    GL_CALL(glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags));
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, (GLuint)last_array_buffer));
+    return mapped;
+}
+
+// Copy every command list of the frame into the next ring region in one pass.
+// Returns false (and the caller falls back to glBufferData) if the buffers could not be created.
+static bool ImGui_ImplOpenGL3_UploadToRing(ImGui_ImplOpenGL3_Data* bd, ImDrawData* draw_data, int* vtx_base, GLsizeiptr* idx_base)
+{
+    if (bd->RingVboHandle == 0 || draw_data->TotalVtxCount > bd->RingVtxCapacity || draw_data->TotalIdxCount > bd->RingIdxCapacity)
+    {
+        // Grow with headroom so a growing dashboard does not recreate the ring every frame
+        int vtx_capacity = draw_data->TotalVtxCount * 2 > 64 * 1024 ? draw_data->TotalVtxCount * 2 : 64 * 1024;
+        int idx_capacity = draw_data->TotalIdxCount * 2 > 128 * 1024 ? draw_data->TotalIdxCount * 2 : 128 * 1024;
+        ImGui_ImplOpenGL3_DestroyRingBuffers(bd);
+        bd->RingVtxMapped = (ImDrawVert*)ImGui_ImplOpenGL3_CreatePersistentBuffer(&bd->RingVboHandle, (GLsizeiptr)vtx_capacity * IMGUI_IMPL_OPENGL_RING_REGIONS * (int)sizeof(ImDrawVert));
+        bd->RingIdxMapped = (ImDrawIdx*)ImGui_ImplOpenGL3_CreatePersistentBuffer(&bd->RingElementsHandle, (GLsizeiptr)idx_capacity * IMGUI_IMPL_OPENGL_RING_REGIONS * (int)sizeof(ImDrawIdx));
+        if (bd->RingVtxMapped == nullptr || bd->RingIdxMapped == nullptr)
+        {
+            ImGui_ImplOpenGL3_DestroyRingBuffers(bd);
+            bd->UsePersistentBuffers = false;
+            return false;
+        }
+        bd->RingVtxCapacity = vtx_capacity;
+        bd->RingIdxCapacity = idx_capacity;
+    }
+
+    const int region = bd->RingRegion;
+    ImGui_ImplOpenGL3_WaitRingFence(bd, region);
+
+    ImDrawVert* vtx_dst = bd->RingVtxMapped + (size_t)region * bd->RingVtxCapacity;
+    ImDrawIdx* idx_dst = bd->RingIdxMapped + (size_t)region * bd->RingIdxCapacity;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        memcpy(vtx_dst, cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        memcpy(idx_dst, cmd_list->IdxBuffer.Data, (size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        vtx_dst += cmd_list->VtxBuffer.Size;
+        idx_dst += cmd_list->IdxBuffer.Size;
+    }
+
+    *vtx_base = region * bd->RingVtxCapacity;
+    *idx_base = (GLsizeiptr)region * bd->RingIdxCapacity * (GLsizeiptr)sizeof(ImDrawIdx);
+    bd->Stats.UploadCalls++;
+    bd->Stats.UploadBytes += (size_t)draw_data->TotalVtxCount * sizeof(ImDrawVert) + (size_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+    return true;
+}
+#endif
+
+bool    ImGui_ImplOpenGL3_SetPersistentBuffers(bool enable)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    bd->UsePersistentBuffers = enable && bd->HasBufferStorage;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (!bd->UsePersistentBuffers)
+        ImGui_ImplOpenGL3_DestroyRingBuffers(bd);
+#endif
+    return bd->UsePersistentBuffers;
+}
+
+ImGui_ImplOpenGL3_RenderStats ImGui_ImplOpenGL3_GetRenderStats()
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    return bd ? bd->Stats : ImGui_ImplOpenGL3_RenderStats();
+}
+
 // OpenGL3 Render function.
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly.
 // This is in order to be able to run within an OpenGL engine that doesn't do so.
@@ -541,6 +687,15 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     GL_CALL(glGenVertexArrays(1, &vertex_array_object));
 #endif
+
+    // Persistent path: the whole frame goes into one ring region up front, each list is then drawn at its offset
+    bd->Stats = ImGui_ImplOpenGL3_RenderStats();
+    int ring_vtx_base = 0;
+    GLsizeiptr ring_idx_base = 0;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (bd->UsePersistentBuffers)
+        bd->Stats.PersistentBuffers = ImGui_ImplOpenGL3_UploadToRing(bd, draw_data, &ring_vtx_base, &ring_idx_base);
+#endif
     ImGui_ImplOpenGL3_SetupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
 
     // Will project scissor/clipping rectangles into framebuffer space
@@ -562,7 +717,11 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
         // - See https://github.com/ocornut/imgui/issues/4468 and please report any corruption issues.
         const GLsizeiptr vtx_buffer_size = (GLsizeiptr)cmd_list->VtxBuffer.Size * (int)sizeof(ImDrawVert);
         const GLsizeiptr idx_buffer_size = (GLsizeiptr)cmd_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx);
-        if (bd->UseBufferSubData)
+        if (bd->Stats.PersistentBuffers)
+        {
+            // Already in the ring, uploaded with the rest of the frame
+        }
+        else if (bd->UseBufferSubData)
         {
             if (bd->VertexBufferSize < vtx_buffer_size)
             {
@@ -582,6 +741,11 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
             GL_CALL(glBufferData(GL_ARRAY_BUFFER, vtx_buffer_size, (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW));
             GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx_buffer_size, (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW));
         }
+        if (!bd->Stats.PersistentBuffers)
+        {
+            bd->Stats.UploadCalls += 2;
+            bd->Stats.UploadBytes += (size_t)(vtx_buffer_size + idx_buffer_size);
+        }
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -608,6 +772,11 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
 
                 // Bind texture, Draw
                 GL_CALL(glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->GetTexID()));
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+                if (bd->Stats.PersistentBuffers)
+                    GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(ring_idx_base + (GLsizeiptr)(pcmd->IdxOffset * sizeof(ImDrawIdx))), (GLint)(ring_vtx_base + pcmd->VtxOffset)));
+                else
+#endif
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
                 if (bd->GlVersion >= 320)
                     GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)), (GLint)pcmd->VtxOffset));
@@ -616,8 +785,20 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                 GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx))));
             }
         }
+        ring_vtx_base += cmd_list->VtxBuffer.Size;
+        ring_idx_base += (GLsizeiptr)cmd_list->IdxBuffer.Size * (GLsizeiptr)sizeof(ImDrawIdx);
     }
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    // Fence the region so it is not overwritten before the GPU has consumed it
+    if (bd->Stats.PersistentBuffers)
+    {
+        bd->RingFences[bd->RingRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        bd->RingRegion = (bd->RingRegion + 1) % IMGUI_IMPL_OPENGL_RING_REGIONS;
+    }
+#endif
+    (void)ring_vtx_base; (void)ring_idx_base;
+
     // Destroy the temporary VAO
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     GL_CALL(glDeleteVertexArrays(1, &vertex_array_object));
@@ -945,6 +1126,9 @@ void    ImGui_ImplOpenGL3_DestroyDeviceObjects()
     ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
     if (bd->VboHandle)      { glDeleteBuffers(1, &bd->VboHandle); bd->VboHandle = 0; }
     if (bd->ElementsHandle) { glDeleteBuffers(1, &bd->ElementsHandle); bd->ElementsHandle = 0; }
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    ImGui_ImplOpenGL3_DestroyRingBuffers(bd);
+#endif
     if (bd->ShaderHandle)   { glDeleteProgram(bd->ShaderHandle); bd->ShaderHandle = 0; }
     ImGui_ImplOpenGL3_DestroyFontsTexture();
 }
@@ -41,6 +41,21 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontsTexture();
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyDeviceObjects();
 
+// (Optional) Upload all draw lists of a frame into one persistently mapped, fenced ring buffer instead of
+// calling glBufferData() per draw list. Needs GL 4.4 or GL_ARB_buffer_storage; returns false and keeps the
+// glBufferData() path when they are missing. Call after ImGui_ImplOpenGL3_Init().
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_SetPersistentBuffers(bool enable);
+
+// (Optional) What the last ImGui_ImplOpenGL3_RenderDrawData() call uploaded
+struct ImGui_ImplOpenGL3_RenderStats
+{
+    int     UploadCalls = 0;            // glBufferData() calls, or 1 for a merged ring upload
+    size_t  UploadBytes = 0;
+    int     FenceWaits = 0;             // Times the CPU caught up with the GPU on a ring region
+    bool    PersistentBuffers = false;  // Frame went through the persistent ring
+};
+IMGUI_IMPL_API ImGui_ImplOpenGL3_RenderStats ImGui_ImplOpenGL3_GetRenderStats();
+
 // Configuration flags to add in your imconfig file:
 //#define IMGUI_IMPL_OPENGL_ES2     // Enable ES 2 (Auto-detected on Emscripten)
 //#define IMGUI_IMPL_OPENGL_ES3     // Enable ES 3 (Auto-detected on iOS/Android)